@@ -0,0 +1,15 @@
+#include <zephyr.h>
+
+#include "app_work.h"
+
+K_THREAD_STACK_DEFINE(app_work_stack, CONFIG_APP_WORK_STACK_SIZE);
+struct k_work_q app_work_q;
+
+/* start the application work queue, must run before the mesh is enabled */
+void app_work_init(void)
+{
+	k_work_q_start(&app_work_q, app_work_stack,
+		       K_THREAD_STACK_SIZEOF(app_work_stack),
+		       K_LOWEST_APPLICATION_THREAD_PRIO - 1);
+	k_thread_name_set(&app_work_q.thread, "app_work");
+}
@@ -0,0 +1,15 @@
+#ifndef APP_WORK_H
+#define APP_WORK_H
+
+#include <zephyr.h>
+
+/* work queue of the application, received messages, gossip rounds and
+ * sensor updates all run here so node table state is only touched by
+ * one thread
+ */
+extern struct k_work_q app_work_q;
+
+/* work queue functions */
+void app_work_init(void);
+
+#endif
@@ -0,0 +1,39 @@
+#include <zephyr.h>
+
+#include "distance.h"
+
+/* generated at build time from CONFIG_DISTANCE_TX_POWER and CONFIG_DISTANCE_ENV_FACTOR */
+#include <distance_table.h>
+
+#define RSSI_Q4_SHIFT 4
+
+/* distance in centimetres of a single rssi sample */
+uint16_t distance_cm(int8_t rssi)
+{
+	int index = CLAMP(-rssi, 0, DISTANCE_TABLE_SIZE - 1);
+
+	return distance_table[index];
+}
+
+/* add rssi sample to the exponential moving average of the neighbour
+ * and return the distance in centimetres of the averaged rssi
+ */
+uint16_t distance_filter_update(struct distance_filter *filter, int8_t rssi)
+{
+	int32_t sample = (int32_t)MIN(rssi, -1) << RSSI_Q4_SHIFT;
+
+	if (filter->rssi_q4 == 0) {
+		filter->rssi_q4 = sample;
+	} else {
+		filter->rssi_q4 += (sample - filter->rssi_q4) >> CONFIG_DISTANCE_FILTER_SHIFT;
+	}
+
+	/* round to the nearest whole dBm before the table lookup */
+	return distance_cm((filter->rssi_q4 + (1 << (RSSI_Q4_SHIFT - 1))) >> RSSI_Q4_SHIFT);
+}
+
+/* distance in whole metres as carried by the U and G messages */
+int8_t distance_to_metres(uint16_t cm)
+{
+	return MIN((cm + 50) / 100, INT8_MAX);
+}
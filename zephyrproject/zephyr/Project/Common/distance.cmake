@@ -0,0 +1,26 @@
+# SPDX-License-Identifier: Apache-2.0
+
+# Generate the RSSI to distance lookup table of distance.c from the
+# CONFIG_DISTANCE_TX_POWER and CONFIG_DISTANCE_ENV_FACTOR values.
+set(DISTANCE_TABLE_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/gen_distance_table.py)
+
+function(generate_distance_table_for_target
+    target      # The cmake target that depends on the generated file
+    output_file # The generated header file
+    )
+  add_custom_command(
+    OUTPUT ${output_file}
+    COMMAND
+    ${PYTHON_EXECUTABLE}
+    ${DISTANCE_TABLE_SCRIPT}
+    --tx-power ${CONFIG_DISTANCE_TX_POWER}
+    --env-factor ${CONFIG_DISTANCE_ENV_FACTOR}
+    --output ${output_file}
+    DEPENDS ${DISTANCE_TABLE_SCRIPT}
+            ${DOTCONFIG}
+    )
+
+  generate_unique_target_name_from_filename(${output_file} generated_target_name)
+  add_custom_target(${generated_target_name} DEPENDS ${output_file})
+  add_dependencies(${target} ${generated_target_name})
+endfunction()
@@ -0,0 +1,16 @@
+#ifndef DISTANCE_H
+#define DISTANCE_H
+
+#include <zephyr.h>
+
+/* smoothed rssi of one neighbour, kept in its node_info record */
+struct distance_filter {
+	int16_t rssi_q4;   /* rssi in 1/16 dBm, 0 if no sample yet */
+};
+
+/* distance functions */
+uint16_t distance_cm(int8_t rssi);
+uint16_t distance_filter_update(struct distance_filter *filter, int8_t rssi);
+int8_t distance_to_metres(uint16_t cm);
+
+#endif
@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""Generate the RSSI to distance lookup table used by distance.c
+
+Distance in metres follows the log-distance path loss model
+d = 10 ^ ((tx_power - rssi) / (10 * n)), tabulated in centimetres for
+every RSSI from 0 down to -127 dBm.
+"""
+
+import argparse
+
+TABLE_SIZE = 128
+CM_MAX = 0xffff
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--tx-power", type=int, required=True,
+                        help="RSSI measured at 1 m, in dBm")
+    parser.add_argument("--env-factor", type=int, required=True,
+                        help="path loss exponent n, in tenths")
+    parser.add_argument("-o", "--output", required=True,
+                        help="generated header file")
+    return parser.parse_args()
+
+
+def main():
+    args = parse_args()
+
+    entries = []
+    for i in range(TABLE_SIZE):
+        rssi = -i
+        metres = 10 ** ((args.tx_power - rssi) / args.env_factor)
+        entries.append(min(max(round(metres * 100), 1), CM_MAX))
+
+    with open(args.output, "w") as out:
+        out.write("/* Generated by gen_distance_table.py, do not edit */\n\n")
+        out.write("/* tx power {} dBm, environment factor {}.{} */\n".format(
+            args.tx_power, args.env_factor // 10, args.env_factor % 10))
+        out.write("#define DISTANCE_TABLE_SIZE {}\n\n".format(TABLE_SIZE))
+        out.write("/* distance in centimetres, indexed by -rssi */\n")
+        out.write("static const uint16_t distance_table[DISTANCE_TABLE_SIZE] = {\n")
+        for i in range(0, TABLE_SIZE, 8):
+            row = ", ".join("{:5d}".format(cm) for cm in entries[i:i + 8])
+            out.write("\t{},\n".format(row))
+        out.write("};\n")
+
+
+if __name__ == "__main__":
+    main()
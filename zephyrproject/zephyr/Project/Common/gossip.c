@@ -0,0 +1,271 @@
+#include <zephyr.h>
+#include <random/rand32.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "message.h"
+#include "node_table.h"
+#include "gossip.h"
+#include "app_work.h"
+
+/* state of this node carried in the header of every gossip message */
+static struct {
+	uint16_t addr;
+	int8_t temperature;
+	uint8_t humidity;
+	bool dirty;
+	bool pending;     /* dirty when the current pass started */
+} self;
+
+/* a pass sends every neighbour what changed, or everything when it has not
+ * been announced yet, packing up to MSG_GOSSIP_MAX_NEIGH records in each
+ * message. Gossip messages carry no names, a full pass tells the names of my
+ * neighbours in T messages first. A round sends at most
+ * CONFIG_GOSSIP_ROUND_MSGS messages and the next round resumes the pass.
+ */
+static struct {
+	bool active;
+	bool refresh;      /* resend the full state to every neighbour */
+	int neighbour;     /* index of the neighbour being sent to */
+	int name;          /* index of the next record to name for that neighbour */
+	int record;        /* index of the next record for that neighbour */
+	bool sent;         /* the neighbour got a message in this pass */
+} pass;
+
+static struct k_delayed_work gossip_work;
+static int64_t last_round;
+static int64_t last_refresh;
+
+/* changes made from now on go out in the next pass */
+static void gossip_pass_start(int64_t now)
+{
+	pass.active = true;
+	pass.refresh = false;
+	pass.neighbour = 0;
+	pass.name = 0;
+	pass.record = 0;
+	pass.sent = false;
+
+	if (CONFIG_GOSSIP_REFRESH_MS > 0 &&
+	    now - last_refresh >= CONFIG_GOSSIP_REFRESH_MS) {
+		pass.refresh = true;
+		last_refresh = now;
+	}
+
+	for (int i = 0; i < node_table_count(); i++) {
+		struct node_info *record = node_table_get(i);
+
+		record->pending = record->dirty;
+		record->dirty = false;
+	}
+
+	self.pending = self.dirty;
+	self.dirty = false;
+}
+
+static bool gossip_changed(void)
+{
+	if (self.dirty) {
+		return true;
+	}
+
+	for (int i = 0; i < node_table_count(); i++) {
+		if (node_table_get(i)->dirty) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* record is one of my links to be told to neighbour */
+static bool gossip_wanted(struct node_info *record, struct node_info *neighbour, bool full)
+{
+	if (record->addr != self.addr || record == neighbour) {
+		return false;
+	}
+
+	return full || record->pending;
+}
+
+/* fill msg with the next records wanted by neighbour, return index after the last one */
+static int gossip_pack(struct msg *msg, struct node_info *neighbour, bool full, int index)
+{
+	msg->neigh_count = 0;
+
+	for (; index < node_table_count() && msg->neigh_count < MSG_GOSSIP_MAX_NEIGH; index++) {
+		struct node_info *record = node_table_get(index);
+		struct msg_neigh_info *neigh = &msg->neigh[msg->neigh_count];
+
+		if (!gossip_wanted(record, neighbour, full)) {
+			continue;
+		}
+
+		neigh->addr = record->neighbour_addr;
+		neigh->distance = record->distance;
+		msg->neigh_count++;
+	}
+
+	return index;
+}
+
+/* send the next messages of the pass, return false if the round ran out of budget */
+static bool gossip_send(int *budget)
+{
+	struct msg msg = { .type = MSG_GOSSIP };
+
+	msg.temperature = self.temperature;
+	msg.humidity = self.humidity;
+
+	for (; pass.neighbour < node_table_count();
+	     pass.neighbour++, pass.name = 0, pass.record = 0, pass.sent = false) {
+		struct node_info *neighbour = node_table_get(pass.neighbour);
+		bool full = pass.refresh || !neighbour->announced;
+
+		if (neighbour->addr != self.addr) {
+			continue;
+		}
+
+		for (; full && pass.name < node_table_count(); pass.name++) {
+			struct node_info *record = node_table_get(pass.name);
+			struct msg name_msg = { .type = MSG_NEIGH_NEIGH };
+
+			if (!gossip_wanted(record, neighbour, full)) {
+				continue;
+			}
+
+			if (*budget == 0) {
+				return false;
+			}
+
+			name_msg.addr = record->neighbour_addr;
+			snprintf(name_msg.name, sizeof(name_msg.name), "%s", record->neighbour_name);
+
+			/* out of buffers, retry from this record in the next round */
+			if (send_message(neighbour->neighbour_addr, &name_msg)) {
+				return false;
+			}
+
+			(*budget)--;
+		}
+
+		for (;;) {
+			int next = gossip_pack(&msg, neighbour, full, pass.record);
+
+			if (!msg.neigh_count) {
+				break;
+			}
+
+			if (*budget == 0) {
+				return false;
+			}
+
+			/* out of buffers, retry from the same records in the next round */
+			if (send_message(neighbour->neighbour_addr, &msg)) {
+				return false;
+			}
+
+			pass.record = next;
+			(*budget)--;
+			pass.sent = true;
+		}
+
+		/* no link to tell, the header alone carries my sensor state */
+		if (!pass.sent && (full || self.pending)) {
+			if (*budget == 0) {
+				return false;
+			}
+
+			msg.neigh_count = 0;
+			if (send_message(neighbour->neighbour_addr, &msg)) {
+				return false;
+			}
+
+			(*budget)--;
+		}
+
+		if (full) {
+			neighbour->announced = true;
+		}
+	}
+
+	return true;
+}
+
+/* send part of the current pass, starting a new one if there is none */
+static void gossip_round(struct k_work *work)
+{
+	int budget = CONFIG_GOSSIP_ROUND_MSGS;
+
+	last_round = k_uptime_get();
+
+	if (!pass.active) {
+		gossip_pass_start(last_round);
+	}
+
+	if (!gossip_send(&budget)) {
+		gossip_schedule();
+		return;
+	}
+
+	pass.active = false;
+
+	/* entries changed during the pass go out in the next one */
+	if (gossip_changed()) {
+		gossip_schedule();
+	}
+
+	if (CONFIG_GOSSIP_REFRESH_MS > 0 && !k_delayed_work_pending(&gossip_work)) {
+		k_delayed_work_submit_to_queue(&app_work_q, &gossip_work, K_MSEC(CONFIG_GOSSIP_REFRESH_MS));
+	}
+}
+
+/* schedule a gossip round no earlier than one period after the last one */
+void gossip_schedule(void)
+{
+	int64_t elapsed = k_uptime_get() - last_round;
+	int32_t delay = 0;
+
+	if (k_delayed_work_pending(&gossip_work) &&
+	    k_delayed_work_remaining_get(&gossip_work) <=
+	    CONFIG_GOSSIP_PERIOD_MS + CONFIG_GOSSIP_JITTER_MS) {
+		return;
+	}
+
+	if (elapsed < CONFIG_GOSSIP_PERIOD_MS) {
+		delay = CONFIG_GOSSIP_PERIOD_MS - elapsed;
+	}
+
+	if (CONFIG_GOSSIP_JITTER_MS > 0) {
+		delay += sys_rand32_get() % CONFIG_GOSSIP_JITTER_MS;
+	}
+
+	k_delayed_work_submit_to_queue(&app_work_q, &gossip_work, K_MSEC(delay));
+}
+
+/* mark record as changed so it is sent in the next round */
+void gossip_mark_dirty(struct node_info *record)
+{
+	record->dirty = true;
+	gossip_schedule();
+}
+
+/* update the state of this node, a change is sent to all neighbours */
+void gossip_update_self(uint16_t addr, int temperature, int humidity)
+{
+	if (self.addr == addr &&
+	    self.temperature == temperature && self.humidity == humidity) {
+		return;
+	}
+
+	self.addr = addr;
+	self.temperature = temperature;
+	self.humidity = humidity;
+	self.dirty = true;
+	gossip_schedule();
+}
+
+void gossip_init(void)
+{
+	k_delayed_work_init(&gossip_work, gossip_round);
+}
@@ -0,0 +1,14 @@
+#ifndef GOSSIP_H
+#define GOSSIP_H
+
+#include <zephyr.h>
+
+#include "node_table.h"
+
+/* gossip functions */
+void gossip_init(void);
+void gossip_update_self(uint16_t addr, int temperature, int humidity);
+void gossip_mark_dirty(struct node_info *record);
+void gossip_schedule(void);
+
+#endif
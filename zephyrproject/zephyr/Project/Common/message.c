@@ -0,0 +1,329 @@
+#include <zephyr.h>
+#include <sys/byteorder.h>
+#include <sys/printk.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/mesh.h>
+
+#include "message.h"
+#include "app_work.h"
+
+/* fixed on-air layout of every message type, names are not nul terminated */
+struct msg_prov_pdu {
+	char prov_name[MSG_NAME_LEN];
+	char node_name[MSG_NAME_LEN];
+} __packed;
+
+struct msg_neigh_pdu {
+	uint16_t addr;
+	char name[MSG_NAME_LEN];
+} __packed;
+
+struct msg_sensor_pdu {
+	char name[MSG_NAME_LEN];
+	int8_t temperature;
+	uint8_t humidity;
+} __packed;
+
+struct msg_neigh_dist_pdu {
+	uint16_t addr;
+	int8_t distance;
+	char name[MSG_NAME_LEN];
+} __packed;
+
+/* gossip message is a sensor header followed by up to MSG_GOSSIP_MAX_NEIGH
+ * entries, the receiver already knows the sender's name from provisioning and
+ * the names of its neighbours from T messages, so several entries fit in
+ * one unsegmented PDU
+ */
+struct msg_gossip_pdu {
+	int8_t temperature;
+	uint8_t humidity;
+} __packed;
+
+struct msg_gossip_neigh_pdu {
+	uint16_t addr;
+	int8_t distance;
+} __packed;
+
+BUILD_ASSERT(sizeof(struct msg_gossip_pdu) +
+	     MSG_GOSSIP_MAX_NEIGH * sizeof(struct msg_gossip_neigh_pdu) <= MSG_MAX_LEN);
+/* every message fits in one unsegmented access PDU, 11 bytes with the opcode */
+BUILD_ASSERT(BT_MESH_MODEL_OP_LEN(OP_VND_GOSSIP_MSG) + MSG_MAX_LEN <= 11);
+BUILD_ASSERT(sizeof(struct msg_prov_pdu) <= MSG_MAX_LEN);
+BUILD_ASSERT(sizeof(struct msg_neigh_pdu) <= MSG_MAX_LEN);
+BUILD_ASSERT(sizeof(struct msg_sensor_pdu) <= MSG_MAX_LEN);
+BUILD_ASSERT(sizeof(struct msg_neigh_dist_pdu) <= MSG_MAX_LEN);
+
+/* opcode of every message type */
+static const uint32_t msg_opcodes[MSG_TYPE_COUNT] = {
+	[MSG_PROV] = OP_VND_PROV_MSG,
+	[MSG_NEIGH] = OP_VND_NEIGH_MSG,
+	[MSG_SENSOR] = OP_VND_SENSOR_MSG,
+	[MSG_NEIGH_NEIGH] = OP_VND_NEIGH_NEIGH_MSG,
+	[MSG_NEIGH_DIST] = OP_VND_NEIGH_DIST_MSG,
+	[MSG_GOSSIP] = OP_VND_GOSSIP_MSG,
+};
+
+/* ASCII code of every message type, used for logging */
+static const char msg_codes[MSG_TYPE_COUNT] = {
+	[MSG_PROV] = 'Q',
+	[MSG_NEIGH] = 'R',
+	[MSG_SENSOR] = 'S',
+	[MSG_NEIGH_NEIGH] = 'T',
+	[MSG_NEIGH_DIST] = 'U',
+	[MSG_GOSSIP] = 'G',
+};
+
+/* encode message into buf, buf must hold BT_MESH_MODEL_BUF_LEN(op, MSG_MAX_LEN) bytes */
+void msg_encode(struct net_buf_simple *buf, const struct msg *msg)
+{
+	bt_mesh_model_msg_init(buf, msg_opcodes[msg->type]);
+
+	switch (msg->type) {
+	case MSG_PROV: {
+		struct msg_prov_pdu *pdu = net_buf_simple_add(buf, sizeof(*pdu));
+
+		memcpy(pdu->prov_name, msg->prov_name, MSG_NAME_LEN);
+		memcpy(pdu->node_name, msg->name, MSG_NAME_LEN);
+		break;
+	}
+	case MSG_NEIGH:
+	case MSG_NEIGH_NEIGH: {
+		struct msg_neigh_pdu *pdu = net_buf_simple_add(buf, sizeof(*pdu));
+
+		pdu->addr = sys_cpu_to_le16(msg->addr);
+		memcpy(pdu->name, msg->name, MSG_NAME_LEN);
+		break;
+	}
+	case MSG_SENSOR: {
+		struct msg_sensor_pdu *pdu = net_buf_simple_add(buf, sizeof(*pdu));
+
+		memcpy(pdu->name, msg->name, MSG_NAME_LEN);
+		pdu->temperature = msg->temperature;
+		pdu->humidity = msg->humidity;
+		break;
+	}
+	case MSG_NEIGH_DIST: {
+		struct msg_neigh_dist_pdu *pdu = net_buf_simple_add(buf, sizeof(*pdu));
+
+		pdu->addr = sys_cpu_to_le16(msg->addr);
+		pdu->distance = msg->distance;
+		memcpy(pdu->name, msg->name, MSG_NAME_LEN);
+		break;
+	}
+	case MSG_GOSSIP: {
+		struct msg_gossip_pdu *pdu = net_buf_simple_add(buf, sizeof(*pdu));
+		uint8_t count = MIN(msg->neigh_count, MSG_GOSSIP_MAX_NEIGH);
+
+		pdu->temperature = msg->temperature;
+		pdu->humidity = msg->humidity;
+
+		for (int i = 0; i < count; i++) {
+			struct msg_gossip_neigh_pdu *neigh = net_buf_simple_add(buf, sizeof(*neigh));
+
+			neigh->addr = sys_cpu_to_le16(msg->neigh[i].addr);
+			neigh->distance = msg->neigh[i].distance;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+/* format message in the old ASCII protocol layout for the serial log */
+int msg_to_str(const struct msg *msg, char *str, size_t len)
+{
+	switch (msg->type) {
+	case MSG_PROV:
+		return snprintf(str, len, "%c=%s=%s", msg_codes[msg->type],
+				msg->prov_name, msg->name);
+	case MSG_NEIGH:
+	case MSG_NEIGH_NEIGH:
+		return snprintf(str, len, "%c=0x%04x=%s", msg_codes[msg->type],
+				msg->addr, msg->name);
+	case MSG_SENSOR:
+		return snprintf(str, len, "%c=%s=%d=%d", msg_codes[msg->type],
+				msg->name, msg->temperature, msg->humidity);
+	case MSG_NEIGH_DIST:
+		return snprintf(str, len, "%c=0x%04x=%d=%s", msg_codes[msg->type],
+				msg->addr, msg->distance, msg->name);
+	case MSG_GOSSIP:
+		return snprintf(str, len, "%c=%d=%d=%d", msg_codes[msg->type],
+				msg->temperature, msg->humidity, msg->neigh_count);
+	default:
+		return snprintf(str, len, "?");
+	}
+}
+
+/* received message waiting for the application work queue */
+struct msg_rx {
+	struct bt_mesh_msg_ctx ctx;
+	int8_t rssi;
+	struct msg msg;
+};
+
+K_MSGQ_DEFINE(msg_rx_q, sizeof(struct msg_rx), CONFIG_MSG_RX_QUEUE_SIZE, 4);
+
+/* updated on the BT RX thread and the work queue, read from either */
+static struct msg_rx_stats rx_stats;
+static struct k_spinlock rx_stats_lock;
+static uint32_t rx_dropped_reported;
+
+/* drain the receive queue on the application work queue */
+static void msg_rx_handler(struct k_work *work)
+{
+	struct msg_rx rx;
+	k_spinlock_key_t key;
+	uint32_t dropped;
+
+	while (!k_msgq_get(&msg_rx_q, &rx, K_NO_WAIT)) {
+		receive_message(&rx.ctx, &rx.msg, rx.rssi);
+
+		key = k_spin_lock(&rx_stats_lock);
+		rx_stats.handled++;
+		k_spin_unlock(&rx_stats_lock, key);
+	}
+
+	key = k_spin_lock(&rx_stats_lock);
+	dropped = rx_stats.dropped;
+	k_spin_unlock(&rx_stats_lock, key);
+
+	if (dropped != rx_dropped_reported) {
+		printk("Receive queue full, %u messages dropped\n", dropped - rx_dropped_reported);
+		rx_dropped_reported = dropped;
+	}
+}
+
+K_WORK_DEFINE(msg_rx_work, msg_rx_handler);
+
+/* called on the BT RX thread, only copies the message */
+static void msg_rx_queue(struct bt_mesh_msg_ctx *ctx, const struct msg *msg, int8_t rssi)
+{
+	struct msg_rx rx = { .ctx = *ctx, .rssi = rssi, .msg = *msg };
+	k_spinlock_key_t key;
+	uint32_t used;
+
+	if (k_msgq_put(&msg_rx_q, &rx, K_NO_WAIT)) {
+		key = k_spin_lock(&rx_stats_lock);
+		rx_stats.dropped++;
+		k_spin_unlock(&rx_stats_lock, key);
+		return;
+	}
+
+	used = k_msgq_num_used_get(&msg_rx_q);
+
+	key = k_spin_lock(&rx_stats_lock);
+	rx_stats.queued++;
+	if (used > rx_stats.max_used)
+		rx_stats.max_used = used;
+	k_spin_unlock(&rx_stats_lock, key);
+
+	k_work_submit_to_queue(&app_work_q, &msg_rx_work);
+}
+
+void msg_rx_stats_get(struct msg_rx_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&rx_stats_lock);
+
+	*stats = rx_stats;
+	k_spin_unlock(&rx_stats_lock, key);
+}
+
+/* decode handlers, access layer has already checked the minimum length */
+static void receive_prov_msg(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx,
+			     struct net_buf_simple *buf, int8_t rssi)
+{
+	const struct msg_prov_pdu *pdu = net_buf_simple_pull_mem(buf, sizeof(*pdu));
+	struct msg msg = { .type = MSG_PROV };
+
+	memcpy(msg.prov_name, pdu->prov_name, MSG_NAME_LEN);
+	memcpy(msg.name, pdu->node_name, MSG_NAME_LEN);
+	msg_rx_queue(ctx, &msg, rssi);
+}
+
+static void receive_neigh_msg(struct bt_mesh_msg_ctx *ctx, struct net_buf_simple *buf,
+			      int8_t rssi, enum msg_type type)
+{
+	const struct msg_neigh_pdu *pdu = net_buf_simple_pull_mem(buf, sizeof(*pdu));
+	struct msg msg = { .type = type };
+
+	msg.addr = sys_le16_to_cpu(pdu->addr);
+	memcpy(msg.name, pdu->name, MSG_NAME_LEN);
+	msg_rx_queue(ctx, &msg, rssi);
+}
+
+static void receive_neighbour_msg(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx,
+				  struct net_buf_simple *buf, int8_t rssi)
+{
+	receive_neigh_msg(ctx, buf, rssi, MSG_NEIGH);
+}
+
+static void receive_neigh_neigh_msg(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx,
+				    struct net_buf_simple *buf, int8_t rssi)
+{
+	receive_neigh_msg(ctx, buf, rssi, MSG_NEIGH_NEIGH);
+}
+
+static void receive_sensor_msg(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx,
+			       struct net_buf_simple *buf, int8_t rssi)
+{
+	const struct msg_sensor_pdu *pdu = net_buf_simple_pull_mem(buf, sizeof(*pdu));
+	struct msg msg = { .type = MSG_SENSOR };
+
+	memcpy(msg.name, pdu->name, MSG_NAME_LEN);
+	msg.temperature = pdu->temperature;
+	msg.humidity = pdu->humidity;
+	msg_rx_queue(ctx, &msg, rssi);
+}
+
+static void receive_neigh_dist_msg(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx,
+				   struct net_buf_simple *buf, int8_t rssi)
+{
+	const struct msg_neigh_dist_pdu *pdu = net_buf_simple_pull_mem(buf, sizeof(*pdu));
+	struct msg msg = { .type = MSG_NEIGH_DIST };
+
+	msg.addr = sys_le16_to_cpu(pdu->addr);
+	msg.distance = pdu->distance;
+	memcpy(msg.name, pdu->name, MSG_NAME_LEN);
+	msg_rx_queue(ctx, &msg, rssi);
+}
+
+static void receive_gossip_msg(struct bt_mesh_model *model, struct bt_mesh_msg_ctx *ctx,
+			       struct net_buf_simple *buf, int8_t rssi)
+{
+	const struct msg_gossip_pdu *pdu = net_buf_simple_pull_mem(buf, sizeof(*pdu));
+	struct msg msg = { .type = MSG_GOSSIP };
+
+	/* number of entries follows from the length */
+	if (buf->len % sizeof(struct msg_gossip_neigh_pdu) ||
+	    buf->len > MSG_GOSSIP_MAX_NEIGH * sizeof(struct msg_gossip_neigh_pdu)) {
+		return;
+	}
+
+	msg.temperature = pdu->temperature;
+	msg.humidity = pdu->humidity;
+	msg.neigh_count = buf->len / sizeof(struct msg_gossip_neigh_pdu);
+
+	for (int i = 0; i < msg.neigh_count; i++) {
+		const struct msg_gossip_neigh_pdu *neigh = net_buf_simple_pull_mem(buf, sizeof(*neigh));
+
+		msg.neigh[i].addr = sys_le16_to_cpu(neigh->addr);
+		msg.neigh[i].distance = neigh->distance;
+	}
+
+	msg_rx_queue(ctx, &msg, rssi);
+}
+
+const struct bt_mesh_model_op msg_vnd_ops[] = {
+	{ OP_VND_PROV_MSG, sizeof(struct msg_prov_pdu), receive_prov_msg },
+	{ OP_VND_NEIGH_MSG, sizeof(struct msg_neigh_pdu), receive_neighbour_msg },
+	{ OP_VND_SENSOR_MSG, sizeof(struct msg_sensor_pdu), receive_sensor_msg },
+	{ OP_VND_NEIGH_NEIGH_MSG, sizeof(struct msg_neigh_pdu), receive_neigh_neigh_msg },
+	{ OP_VND_NEIGH_DIST_MSG, sizeof(struct msg_neigh_dist_pdu), receive_neigh_dist_msg },
+	{ OP_VND_GOSSIP_MSG, sizeof(struct msg_gossip_pdu), receive_gossip_msg },
+	BT_MESH_MODEL_OP_END,
+};
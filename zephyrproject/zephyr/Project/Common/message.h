@@ -0,0 +1,73 @@
+#ifndef MESSAGE_H
+#define MESSAGE_H
+
+#include <zephyr.h>
+#include <bluetooth/mesh.h>
+
+#define MSG_NAME_LEN          3
+#define MSG_GOSSIP_MAX_NEIGH  2
+#define MSG_MAX_LEN           (2 + 3 * MSG_GOSSIP_MAX_NEIGH)
+
+/* vendor opcodes, one per message type */
+#define OP_VND_PROV_MSG       BT_MESH_MODEL_OP_3(0x01, BT_COMP_ID_LF)
+#define OP_VND_NEIGH_MSG      BT_MESH_MODEL_OP_3(0x02, BT_COMP_ID_LF)
+#define OP_VND_SENSOR_MSG     BT_MESH_MODEL_OP_3(0x03, BT_COMP_ID_LF)
+#define OP_VND_NEIGH_NEIGH_MSG BT_MESH_MODEL_OP_3(0x04, BT_COMP_ID_LF)
+#define OP_VND_NEIGH_DIST_MSG BT_MESH_MODEL_OP_3(0x05, BT_COMP_ID_LF)
+#define OP_VND_GOSSIP_MSG     BT_MESH_MODEL_OP_3(0x06, BT_COMP_ID_LF)
+
+/* message types, the letter is the code used by the old ASCII protocol */
+enum msg_type {
+	MSG_PROV,         /* Q : provisioner name and name assigned to the node */
+	MSG_NEIGH,        /* R : a node the provisioner already knows about */
+	MSG_SENSOR,       /* S : sender name, temperature and humidity */
+	MSG_NEIGH_NEIGH,  /* T : a neighbour of the sender */
+	MSG_NEIGH_DIST,   /* U : distance between the sender and its neighbour */
+	MSG_GOSSIP,       /* G : S without the name, U without the name of up to
+	                   *     MSG_GOSSIP_MAX_NEIGH neighbours
+	                   */
+	MSG_TYPE_COUNT,
+};
+
+/* a neighbour of the sender carried by a gossip message, its name comes in a T message */
+struct msg_neigh_info {
+	uint16_t addr;
+	int8_t distance;
+};
+
+/* decoded message, only the fields of the message type are valid */
+struct msg {
+	enum msg_type type;
+	uint16_t addr;                      /* R, T, U : neighbour address */
+	char name[MSG_NAME_LEN + 1];        /* Q : node name, R, T : neighbour name, S, U : sender name */
+	char prov_name[MSG_NAME_LEN + 1];   /* Q : provisioner name */
+	int8_t temperature;                 /* S, G */
+	uint8_t humidity;                   /* S, G */
+	int8_t distance;                    /* U : distance in metres */
+	uint8_t neigh_count;                /* G */
+	struct msg_neigh_info neigh[MSG_GOSSIP_MAX_NEIGH]; /* G */
+};
+
+/* receive queue statistics */
+struct msg_rx_stats {
+	uint32_t queued;    /* messages put in the queue */
+	uint32_t handled;   /* messages passed to receive_message() */
+	uint32_t dropped;   /* messages lost because the queue was full */
+	uint32_t max_used;  /* highest number of messages waiting at once */
+};
+
+/* vendor model opcode table, handlers decode and queue the message,
+ * receive_message() is called later from the application work queue
+ */
+extern const struct bt_mesh_model_op msg_vnd_ops[];
+
+/* implemented by the application */
+void receive_message(struct bt_mesh_msg_ctx *ctx, const struct msg *msg, int8_t rssi);
+int send_message(uint16_t to_address, const struct msg *msg);
+
+/* encode functions */
+void msg_encode(struct net_buf_simple *buf, const struct msg *msg);
+int msg_to_str(const struct msg *msg, char *str, size_t len);
+void msg_rx_stats_get(struct msg_rx_stats *stats);
+
+#endif
@@ -0,0 +1,88 @@
+#include <zephyr.h>
+#include <stdio.h>
+
+#include <bluetooth/mesh.h>
+
+#include "node_status.h"
+#include "node_table.h"
+#include "sampler.h"
+#include "screen.h"
+
+struct node_status_self {
+	uint16_t addr;
+	const char *name;
+};
+
+/* print node_info list info on the board */
+static void draw_node_status(void *user_data)
+{
+	const struct node_status_self *self = user_data;
+	char str[100];
+	int len, line = 0;
+
+	// print my info
+	len = snprintf(str, sizeof(str), "Node :%s: 0x%04x :%dC %d%% \n",
+		       self->name, self->addr, get_temperature(), get_humidity());
+	print_line(FONT_SMALL, line++, str, len, true);
+
+	// print my neighbours info
+	len = snprintf(str, sizeof(str), "%s", "My Neighbours: \n");
+	print_line(FONT_SMALL, line++, str, len, true);
+
+	for (int i = 0; i < node_table_count(); i++)
+	{
+		struct node_info *stat = node_table_get(i);
+		if (stat->addr != BT_MESH_ADDR_UNASSIGNED)
+		{
+			if (stat->addr == self->addr)
+			{
+				char temp_hum[50];
+				if (stat->neighbour_temperature >= 0 && stat->neighbour_humidity >= 0)
+					snprintf(temp_hum, 50, "%dC %d%%", stat->neighbour_temperature, stat->neighbour_humidity);
+				else
+					snprintf(temp_hum, 20, "%s", "");
+				len = snprintf(str, sizeof(str), "%s:0x%04x %dm %d %s\n",
+					       stat->neighbour_name, stat->neighbour_addr, stat->distance, stat->rssi,
+					       temp_hum);
+				print_line(FONT_SMALL, line++, str, len, false);
+			}
+		}
+	}
+
+	// print neighbours neighbours Info
+	if (node_table_count() > 1)
+	{
+		len = snprintf(str, sizeof(str), "%s", "-----------------------\n");
+		print_line(FONT_SMALL, line++, str, len, false);
+
+		len = snprintf(str, sizeof(str), "%s", "Among Neighbours: \n");
+		print_line(FONT_SMALL, line++, str, len, true);
+
+		for (int i = 0; i < node_table_count(); i++)
+		{
+			struct node_info *stat = node_table_get(i);
+			if (stat->addr != BT_MESH_ADDR_UNASSIGNED)
+			{
+				if (stat->addr != self->addr)
+				{
+					len = snprintf(str, sizeof(str), "%s:0x%04x %s:0x%04x %dm\n",
+						       stat->name, stat->addr,
+						       stat->neighbour_name, stat->neighbour_addr, stat->distance);
+					print_line(FONT_SMALL, line++, str, len, false);
+				}
+			}
+		}
+	}
+}
+
+/* draw this node and the node table on the screen */
+void node_status_show(uint16_t self, const char *self_name)
+{
+	struct node_status_self status_self = {
+		.addr = self,
+		.name = self_name,
+	};
+
+	// screen_draw() calls back before it returns, status_self stays valid
+	screen_draw(draw_node_status, &status_self);
+}
@@ -0,0 +1,9 @@
+#ifndef NODE_STATUS_H
+#define NODE_STATUS_H
+
+#include <zephyr.h>
+
+/* draw this node and the node table on the screen */
+void node_status_show(uint16_t self, const char *self_name);
+
+#endif
@@ -0,0 +1,205 @@
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <bluetooth/mesh.h>
+
+#include "node_table.h"
+
+/* hash index has twice as many slots as records to keep probe chains short */
+#define NODE_TABLE_SIZE   CONFIG_NODE_INFO_TABLE_SIZE
+#define NODE_TABLE_SLOTS  (2 * NODE_TABLE_SIZE)
+#define SLOT_EMPTY        0
+
+BUILD_ASSERT(NODE_TABLE_SLOTS < UINT16_MAX);
+
+/* records are kept dense in insertion order, slots hold record index + 1 */
+static struct node_info records[NODE_TABLE_SIZE];
+static uint16_t slots[NODE_TABLE_SLOTS];
+static int record_count;
+static node_table_change_cb_t change_cb;
+
+static uint32_t node_table_hash(uint16_t addr, uint16_t neighbour_addr)
+{
+	uint32_t key = ((uint32_t)addr << 16) | neighbour_addr;
+
+	/* Fibonacci hashing, the high half of the product depends on every
+	 * key bit, the low bits only on the low bits of neighbour_addr
+	 */
+	return ((key * 2654435761U) >> 16) % NODE_TABLE_SLOTS;
+}
+
+/* return slot holding the key, or the empty slot where it would be inserted */
+static uint16_t *node_table_slot(uint16_t addr, uint16_t neighbour_addr)
+{
+	uint32_t i = node_table_hash(addr, neighbour_addr);
+
+	for (;;) {
+		uint16_t *slot = &slots[i];
+
+		if (*slot == SLOT_EMPTY) {
+			return slot;
+		}
+
+		if (records[*slot - 1].addr == addr &&
+		    records[*slot - 1].neighbour_addr == neighbour_addr) {
+			return slot;
+		}
+
+		i = (i + 1) % NODE_TABLE_SLOTS;
+	}
+}
+
+/* remove all records */
+void node_table_clear(void)
+{
+	memset(records, 0, sizeof(records));
+	memset(slots, 0, sizeof(slots));
+	record_count = 0;
+
+	if (change_cb) {
+		change_cb(-1, NULL);
+	}
+}
+
+/* return number of records */
+int node_table_count(void)
+{
+	return record_count;
+}
+
+/* return record at index in insertion order */
+struct node_info *node_table_get(int index)
+{
+	if (index < 0 || index >= record_count) {
+		return NULL;
+	}
+
+	return &records[index];
+}
+
+/* find record of node addr with neighbour neighbour_addr */
+struct node_info *node_table_find(uint16_t addr, uint16_t neighbour_addr)
+{
+	uint16_t *slot = node_table_slot(addr, neighbour_addr);
+
+	if (*slot == SLOT_EMPTY) {
+		return NULL;
+	}
+
+	return &records[*slot - 1];
+}
+
+/* find record of the link between two nodes, in either direction */
+struct node_info *node_table_find_link(uint16_t addr, uint16_t neighbour_addr)
+{
+	struct node_info *record = node_table_find(addr, neighbour_addr);
+
+	if (record) {
+		return record;
+	}
+
+	return node_table_find(neighbour_addr, addr);
+}
+
+/* add record of node addr with neighbour neighbour_addr, return existing one if present */
+struct node_info *node_table_add(uint16_t addr, uint16_t neighbour_addr)
+{
+	uint16_t *slot = node_table_slot(addr, neighbour_addr);
+	struct node_info *record;
+
+	if (*slot != SLOT_EMPTY) {
+		return &records[*slot - 1];
+	}
+
+	if (record_count >= NODE_TABLE_SIZE) {
+		printk("Node table full, dropping record 0x%04x 0x%04x\n",
+		       addr, neighbour_addr);
+		return NULL;
+	}
+
+	record = &records[record_count++];
+	*slot = record_count;
+	memset(record, 0, sizeof(*record));
+	record->addr = addr;
+	record->neighbour_addr = neighbour_addr;
+
+	node_table_changed(record);
+
+	return record;
+}
+
+/* tell the change callback that fields of record were written */
+void node_table_changed(struct node_info *record)
+{
+	if (change_cb) {
+		change_cb(record - records, record);
+	}
+}
+
+/* set the function told about every added or changed record */
+void node_table_change_cb_set(node_table_change_cb_t cb)
+{
+	change_cb = cb;
+}
+
+/* add record of a neighbour of neighbour addr, unless the link is known from
+ * the other end. A NULL or empty name keeps the name known so far.
+ */
+void node_table_add_link(uint16_t self, uint16_t addr, uint16_t neighbour_addr, const char *name)
+{
+	struct node_info *record;
+
+	if (neighbour_addr == BT_MESH_ADDR_UNASSIGNED || neighbour_addr == self ||
+	    node_table_find(neighbour_addr, addr)) {
+		return;
+	}
+
+	record = node_table_add(addr, neighbour_addr);
+	if (record && name && name[0]) {
+		snprintf(record->neighbour_name, sizeof(record->neighbour_name), "%s", name);
+	}
+}
+
+/* update distance between neighbour addr and its neighbour, and the name of
+ * addr unless name is NULL or empty
+ */
+void node_table_update_link(uint16_t self, uint16_t addr, uint16_t neighbour_addr, int8_t distance,
+			    const char *name)
+{
+	struct node_info *record;
+
+	if (neighbour_addr == self) {
+		return;
+	}
+
+	record = node_table_find(addr, neighbour_addr);
+	if (!record) {
+		return;
+	}
+
+	record->distance = distance;
+
+	if (name && name[0]) {
+		snprintf(record->name, sizeof(record->name), "%s", name);
+	}
+
+	node_table_changed(record);
+}
+
+/* print all records on the serial log */
+void node_table_print(void)
+{
+	printk("Record No. : Node_Address Node_Name  Node_Temperature  Node_Humidity Neighbour_Address "
+	       "Neighbour_Name Neighbour_Temperature Neighbour_Humidity Distance Rssi\n ");
+
+	for (int i = 0; i < record_count; i++) {
+		struct node_info *record = &records[i];
+
+		printk("Record %d : 0x%04x %s %dC %d%%    0x%04x %s %dC %d%%    %dm %d\n ",
+		       i + 1, record->addr, record->name, record->temperature, record->humidity,
+		       record->neighbour_addr, record->neighbour_name, record->neighbour_temperature,
+		       record->neighbour_humidity, record->distance, record->rssi);
+	}
+}
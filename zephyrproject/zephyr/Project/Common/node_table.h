@@ -0,0 +1,45 @@
+#ifndef NODE_TABLE_H
+#define NODE_TABLE_H
+
+#include <zephyr.h>
+
+#include "distance.h"
+
+/* record of a node and one of its neighbours */
+struct node_info {
+	uint16_t addr;
+	char name[3];
+	int temperature;
+	int humidity;
+	uint16_t neighbour_addr;
+	char neighbour_name[4];
+	int neighbour_temperature;
+	int neighbour_humidity;
+	int8_t rssi;
+	int8_t distance;                  /* metres, smoothed for my own neighbours */
+	struct distance_filter filter;    /* rssi average of my own neighbours */
+	bool dirty;        /* changed since it was last gossiped */
+	bool pending;      /* dirty when the current gossip pass started */
+	bool announced;    /* neighbour has received our full state */
+};
+
+/* called after a record was added or changed, record is NULL after node_table_clear() */
+typedef void (*node_table_change_cb_t)(int index, struct node_info *record);
+
+/* node table functions */
+void node_table_clear(void);
+int node_table_count(void);
+struct node_info *node_table_get(int index);
+struct node_info *node_table_find(uint16_t addr, uint16_t neighbour_addr);
+struct node_info *node_table_find_link(uint16_t addr, uint16_t neighbour_addr);
+struct node_info *node_table_add(uint16_t addr, uint16_t neighbour_addr);
+void node_table_changed(struct node_info *record);
+void node_table_change_cb_set(node_table_change_cb_t cb);
+
+/* neighbour links reported by other nodes, self is the address of this node */
+void node_table_add_link(uint16_t self, uint16_t addr, uint16_t neighbour_addr, const char *name);
+void node_table_update_link(uint16_t self, uint16_t addr, uint16_t neighbour_addr, int8_t distance,
+			    const char *name);
+void node_table_print(void);
+
+#endif
@@ -0,0 +1,105 @@
+#include <zephyr.h>
+#include <device.h>
+#include <drivers/sensor.h>
+#include <sys/atomic.h>
+#include <sys/printk.h>
+#include <stdlib.h>
+
+#include "sampler.h"
+
+#define SAMPLER_STACK_SIZE 768
+
+/* last sample, temperature in the low and humidity in the high 16 bits,
+ * so that readers get both values of the same sample with one load
+ */
+static atomic_t snapshot;
+
+static const struct device *hdc_dev;
+static sampler_change_cb_t change_cb;
+static int notified_temperature, notified_humidity;
+
+K_THREAD_STACK_DEFINE(sampler_stack, SAMPLER_STACK_SIZE);
+static struct k_thread sampler_thread_data;
+
+/* fetch both channels of the "ti_hdc" sensor with a single conversion */
+static int sampler_fetch(int *temperature, int *humidity)
+{
+	struct sensor_value temp, hum;
+	int err;
+
+	err = sensor_sample_fetch(hdc_dev);
+	if (err) {
+		return err;
+	}
+
+	sensor_channel_get(hdc_dev, SENSOR_CHAN_AMBIENT_TEMP, &temp);
+	sensor_channel_get(hdc_dev, SENSOR_CHAN_HUMIDITY, &hum);
+
+	*temperature = MAX(temp.val1, 0);
+	*humidity = hum.val1;
+	return 0;
+}
+
+static void sampler_publish(int temperature, int humidity)
+{
+	atomic_set(&snapshot, (uint16_t)temperature | ((uint32_t)(uint16_t)humidity << 16));
+}
+
+static void sampler_thread(void *p1, void *p2, void *p3)
+{
+	int temperature, humidity;
+
+	for (;;) {
+		k_sleep(K_MSEC(CONFIG_SENSOR_SAMPLE_PERIOD_MS));
+
+		if (sampler_fetch(&temperature, &humidity))
+			continue;
+
+		sampler_publish(temperature, humidity);
+
+		if (!change_cb || CONFIG_SENSOR_CHANGE_THRESHOLD == 0)
+			continue;
+
+		if (abs(temperature - notified_temperature) > CONFIG_SENSOR_CHANGE_THRESHOLD ||
+		    abs(humidity - notified_humidity) > CONFIG_SENSOR_CHANGE_THRESHOLD) {
+			notified_temperature = temperature;
+			notified_humidity = humidity;
+			change_cb(temperature, humidity);
+		}
+	}
+}
+
+/* take the first sample and start the sampler thread */
+void sampler_init(sampler_change_cb_t cb)
+{
+	int temperature = 0, humidity = 0;
+
+	hdc_dev = device_get_binding(DT_LABEL(DT_INST(0, ti_hdc)));
+	if (!hdc_dev) {
+		printk("Temperature/humidity sensor not found\n");
+		return;
+	}
+
+	sampler_fetch(&temperature, &humidity);
+	sampler_publish(temperature, humidity);
+	notified_temperature = temperature;
+	notified_humidity = humidity;
+	change_cb = cb;
+
+	k_thread_create(&sampler_thread_data, sampler_stack,
+			K_THREAD_STACK_SIZEOF(sampler_stack), sampler_thread,
+			NULL, NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0, K_NO_WAIT);
+	k_thread_name_set(&sampler_thread_data, "sampler");
+}
+
+/* get temperature from the last sample */
+unsigned int get_temperature(void)
+{
+	return (int16_t)(atomic_get(&snapshot) & 0xffff);
+}
+
+/* get humidity from the last sample */
+int get_humidity(void)
+{
+	return (int16_t)((uint32_t)atomic_get(&snapshot) >> 16);
+}
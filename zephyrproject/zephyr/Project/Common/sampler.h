@@ -0,0 +1,18 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <zephyr.h>
+
+/* called from the sampler thread when a value moved by more than
+ * CONFIG_SENSOR_CHANGE_THRESHOLD since the last notification
+ */
+typedef void (*sampler_change_cb_t)(int temperature, int humidity);
+
+/* sampler functions */
+void sampler_init(sampler_change_cb_t change_cb);
+
+/* sensor functions, return the last sampled values without touching the bus */
+unsigned int get_temperature(void);
+int get_humidity(void);
+
+#endif
@@ -0,0 +1,161 @@
+#include <zephyr.h>
+#include <device.h>
+#include <display/cfb.h>
+#include <string.h>
+
+#include "screen.h"
+
+#define SCREEN_COLUMNS    26
+
+static const struct font_info {
+	uint8_t columns;
+} fonts[] = {
+	[FONT_BIG] = { .columns = 12 },
+	[FONT_MEDIUM] = { .columns = 14 },
+	[FONT_SMALL] = { .columns = SCREEN_COLUMNS },
+};
+
+/* one retained text row of the screen */
+struct screen_line {
+	char text[SCREEN_COLUMNS + 1];
+	uint8_t font_size;
+	uint8_t pad;
+};
+
+static const struct device *epd_dev;
+
+/* rows being written by the application, rows waiting for the screen thread and rows on the panel */
+static struct screen_line next[SCREEN_MAX_ROWS];
+static struct screen_line pending[SCREEN_MAX_ROWS];
+static struct screen_line drawn[SCREEN_MAX_ROWS];
+static bool drawn_valid;
+
+K_MUTEX_DEFINE(screen_lock);
+K_SEM_DEFINE(screen_sem, 0, 1);
+
+/* print line into the new screen content, called from a screen_draw() callback */
+size_t print_line(enum font_size font_size, int row, const char *text,
+		  size_t len, bool center)
+{
+	struct screen_line *line;
+
+	if (row < 0 || row >= SCREEN_MAX_ROWS) {
+		return 0;
+	}
+
+	line = &next[row];
+	len = MIN(len, fonts[font_size].columns);
+	memcpy(line->text, text, len);
+	line->text[len] = '\0';
+	line->font_size = font_size;
+
+	if (center)
+		line->pad = (fonts[font_size].columns - len) / 2U;
+	else
+		line->pad = 0;
+
+	return len;
+}
+
+/* draw new screen content with print_line() and hand it over to the screen thread */
+void screen_draw(screen_draw_t draw, void *user_data)
+{
+	k_mutex_lock(&screen_lock, K_FOREVER);
+	memset(next, 0, sizeof(next));
+	draw(user_data);
+	memcpy(pending, next, sizeof(pending));
+	k_mutex_unlock(&screen_lock);
+	k_sem_give(&screen_sem);
+}
+
+/* extend band of pixel rows [y_start, y_end) by the pixel rows of text row */
+static void screen_band_add(const struct screen_line *line, int row,
+			    uint16_t *y_start, uint16_t *y_end)
+{
+	uint8_t font_width, font_height;
+
+	cfb_get_font_size(epd_dev, line->font_size, &font_width, &font_height);
+	*y_start = MIN(*y_start, font_height * row);
+	*y_end = MAX(*y_end, font_height * (row + 1));
+}
+
+/* redraw framebuffer and write the band of rows that changed since last refresh */
+static void screen_refresh(const struct screen_line *lines)
+{
+	uint16_t height = cfb_get_display_parameter(epd_dev, CFB_DISPLAY_HEIGH);
+	uint16_t ppt = cfb_get_display_parameter(epd_dev, CFB_DISPLAY_PPT);
+	uint16_t y_start = UINT16_MAX, y_end = 0;
+
+	for (int row = 0; row < SCREEN_MAX_ROWS; row++) {
+		if (drawn_valid && !memcmp(&lines[row], &drawn[row], sizeof(lines[row])))
+			continue;
+
+		screen_band_add(&lines[row], row, &y_start, &y_end);
+		screen_band_add(&drawn[row], row, &y_start, &y_end);
+	}
+
+	if (y_start >= y_end)
+		return;
+
+	cfb_framebuffer_clear(epd_dev, false);
+
+	for (int row = 0; row < SCREEN_MAX_ROWS; row++) {
+		const struct screen_line *line = &lines[row];
+		uint8_t font_width, font_height;
+
+		if (!line->text[0])
+			continue;
+
+		cfb_framebuffer_set_font(epd_dev, line->font_size);
+		cfb_get_font_size(epd_dev, line->font_size, &font_width, &font_height);
+		cfb_print(epd_dev, (char *)line->text, font_width * line->pad, font_height * row);
+	}
+
+	/* only the changed band is sent to the panel, clipped to whole tiles */
+	y_start -= y_start % ppt;
+	y_end = MIN(ROUND_UP(y_end, ppt), height - height % ppt);
+
+	if (!drawn_valid)
+		cfb_framebuffer_finalize(epd_dev);
+	else if (y_start < y_end)
+		cfb_framebuffer_finalize_area(epd_dev, y_start, y_end - y_start);
+
+	memcpy(drawn, lines, sizeof(drawn));
+	drawn_valid = true;
+}
+
+/* screen thread, refreshes the panel at most once per CONFIG_EPD_REFRESH_INTERVAL_MS */
+static void screen_thread(void)
+{
+	static struct screen_line lines[SCREEN_MAX_ROWS];
+
+	for (;;) {
+		bool ready;
+
+		k_sem_take(&screen_sem, K_FOREVER);
+
+		k_mutex_lock(&screen_lock, K_FOREVER);
+		memcpy(lines, pending, sizeof(lines));
+		ready = epd_dev != NULL;
+		k_mutex_unlock(&screen_lock);
+
+		if (ready)
+			screen_refresh(lines);
+
+		k_sleep(K_MSEC(CONFIG_EPD_REFRESH_INTERVAL_MS));
+	}
+}
+
+K_THREAD_DEFINE(screen_thread_id, CONFIG_EPD_THREAD_STACK_SIZE, screen_thread,
+		NULL, NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
+
+/* initialize character framebuffer of the display */
+void screen_init(const struct device *dev)
+{
+	k_mutex_lock(&screen_lock, K_FOREVER);
+	cfb_framebuffer_init(dev);
+	cfb_framebuffer_clear(dev, true);
+	drawn_valid = false;
+	epd_dev = dev;
+	k_mutex_unlock(&screen_lock);
+}
@@ -0,0 +1,24 @@
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include <zephyr.h>
+#include <device.h>
+
+#define SCREEN_MAX_ROWS   16
+
+enum font_size {
+	FONT_SMALL = 0,
+	FONT_MEDIUM = 1,
+	FONT_BIG = 2,
+};
+
+/* draws the whole screen content with print_line(), called with the screen locked */
+typedef void (*screen_draw_t)(void *user_data);
+
+/* screen functions */
+void screen_init(const struct device *dev);
+void screen_draw(screen_draw_t draw, void *user_data);
+size_t print_line(enum font_size font_size, int row, const char *text,
+		  size_t len, bool center);
+
+#endif
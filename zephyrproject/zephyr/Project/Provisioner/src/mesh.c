@@ -1,18 +1,22 @@
 #include <zephyr.h>
 #include <device.h>
 #include <sys/printk.h>
-#include <display/cfb.h>
 
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
 
 #include <bluetooth/bluetooth.h>
 #include <bluetooth/mesh.h>
 
 #include "mesh.h"
 #include "board.h"
+#include "node_table.h"
+#include "node_status.h"
+#include "gossip.h"
+#include "app_work.h"
+#include "provisioning.h"
+#include "topology.h"
 
 /* Provisoner static hardcoded information */
 static const uint8_t my_device_uuid[16] = { 0xbb, 0xaa };
@@ -21,404 +25,102 @@ char * my_device_name = "P";
 static uint16_t  self_address = 0X0006;
 
 /* declare other static variables */
-static uint16_t node_address;
-static uint8_t node_uuid[16];
 static uint8_t device_key[16];
 static  uint8_t network_key[16] ;
 static  uint8_t application_key[16];
-static char node_info_list_str[600];
 
 static uint32_t record_count = 1;
 
-static struct stat {
-	uint16_t addr;
-	char name[3];
-	int temperature;
-	int humidity;
-	uint16_t neighbour_addr;
-	char neighbour_name[4];
-	int neighbour_temperature;
-	int neighbour_humidity;
-	int8_t rssi;
-	int8_t distance;
-} node_info[STAT_COUNT] = {
-	[0 ...(STAT_COUNT - 1)] = {},
-};
-
-K_SEM_DEFINE(sem_unprov_beacon, 0, 5);
-K_SEM_DEFINE(sem_node_added, 0, 5);
-
 static struct bt_mesh_cfg_cli cfg_cli = {
 
 };
 
-/*generate integrated string of node_info list */
-static char * get_node_info_list_string()
-{
-	printk("Node Info List Integration String is %s\n\n",node_info_list_str);
-	return node_info_list_str;
-}
-
-/* generate integrated string of node_info list */
-static void generate_node_info_list_string()
-{
-	static struct neigh {
-	uint16_t neigh_addr;
-	int neigh_record_index;
-	} neighbour_addr_list[STAT_COUNT] = {
-		[0 ...(STAT_COUNT - 1)] = {},
-	};
-	static struct integration_str {
-	char my_info_str[100];
-	char all_neighbours_info_str[500];
-	} integration_string_list[2] = {
-		[0 ...(1)] = {},
-	};
-	
-	int neighbours_count = 0;
-	char my_info_str[100];
-	char all_neighbours_info_str[500];
-	struct integration_str *integration_str = &integration_string_list[0];
-	for (int i = 0; i < get_node_info_list_record_count(); i++)
-	{
-		struct stat *stat = &node_info[i];
-		if (stat->addr == get_my_address() && stat->neighbour_addr != BT_MESH_ADDR_UNASSIGNED)
-		{
-			struct neigh *neigh = &neighbour_addr_list[neighbours_count];
-			neigh->neigh_addr =  stat->neighbour_addr;
-			neigh->neigh_record_index = i;
-			neighbours_count++;
-		}
-	}
-	for (int i = 0; i < neighbours_count; i++)
-	{
-		struct neigh *neigh = &neighbour_addr_list[i];
-		struct stat *stat = &node_info[neigh->neigh_record_index];
-		if (stat->addr == get_my_address() && stat->neighbour_addr != BT_MESH_ADDR_UNASSIGNED)
-		{
-			if(i==0)
-				snprintf(my_info_str,50,"0x%04x,%d,%d,%d,0x%04x:%d",
-			         stat->addr,stat->temperature,stat->humidity,neighbours_count,
-					 stat->neighbour_addr,stat->distance);
-			else
-			{
-				char value_str[50];
-				snprintf(value_str,50,",0x%04x:%d",stat->neighbour_addr,stat->distance);
-				strcat(my_info_str,value_str);
-			}
-		}
-	}
-	strcat(my_info_str,";\0");
-	strcpy(integration_str->my_info_str ,my_info_str);
-
-	for (int j = 0; j < neighbours_count ; j++)
-	{
-		struct neigh *neigh = &neighbour_addr_list[j];
-		char neighbour_info_str[100];
-		for (int i = 0; i < get_node_info_list_record_count(); i++)
-		{
-			struct stat *stat = &node_info[i];
-			if (i == neigh->neigh_record_index)
-				snprintf(neighbour_info_str,50,"0x%04x,%d,%d,%d,0x%04x:%d",
-			         stat->neighbour_addr,stat->neighbour_temperature,stat->neighbour_humidity,neighbours_count,
-					 stat->addr,stat->distance);
-
-			else if (neigh->neigh_addr != get_my_address() &&  stat->addr !=get_my_address() && stat->neighbour_addr != BT_MESH_ADDR_UNASSIGNED)
-			{
-				if( neigh->neigh_addr == stat->addr)
-				{
-					char value_str[50];
-					snprintf(value_str,50,",0x%04x:%d",stat->neighbour_addr,stat->distance);
-					strcat(neighbour_info_str,value_str);
-				}
-				else if(neigh->neigh_addr == stat->neighbour_addr)
-				{
-					char value_str[50];
-					snprintf(value_str,50,",0x%04x:%d",stat->addr,stat->distance);
-					strcat(neighbour_info_str,value_str);
-				}
-			}
-		}
-		strcat(neighbour_info_str,";\0");
-		if(j==0)
-			strcpy(all_neighbours_info_str,neighbour_info_str);
-		else
-		{
-			strcat(all_neighbours_info_str,neighbour_info_str);
-		}
-	}
-	strcat(all_neighbours_info_str,"\0");
-	strcpy(integration_str->all_neighbours_info_str ,all_neighbours_info_str);
-	snprintk(node_info_list_str,600,"%s%s" ,integration_str->my_info_str,integration_str->all_neighbours_info_str);
-}
-
-/* print node_info list info on the board */
-void show_node_status()
-{
-	char str[100];
-	int len, line = 0;
-	const struct device *epd_dev;
-	epd_dev = device_get_binding(DISPLAY_DRIVER);
-	cfb_framebuffer_clear(epd_dev, true);
-
-	 // print my info
-	len = snprintf(str, sizeof(str), "Node :%s: 0x%04x :%dC %d%% \n",
-									 get_my_device_name(), get_my_address(), get_temperature(), get_humidity());
-	print_line(FONT_SMALL, line++, str, len, true);
-
-	// print my neighbours info
-	len = snprintf(str, sizeof(str), "%s", "My Neighbours: \n");
-	print_line(FONT_SMALL, line++, str, len, true);
-
-	for (int i = 0; i < get_node_info_list_record_count(); i++)
-	{
-		struct stat *stat = &node_info[i];
-		if (stat->addr != BT_MESH_ADDR_UNASSIGNED)
-		{
-			if (stat->addr == get_my_address())
-			{
-				char temp_hum[50];
-				if (stat->neighbour_temperature >= 0 && stat->neighbour_humidity >= 0)
-					snprintf(temp_hum, 50, "%dC %d%%", stat->neighbour_temperature, stat->neighbour_humidity);
-				else
-					snprintf(temp_hum, 20, "%s", "");
-				int8_t round_result = (int8_t) round(stat->distance); 
-				len = snprintf(str, sizeof(str), "%s:0x%04x %dm %d %s\n",
-								   stat->neighbour_name, stat->neighbour_addr, round_result,stat->rssi,
-								    temp_hum);
-				print_line(FONT_SMALL, line++, str, len, false);
-			}
-		}
-	}
-
-	// print neighbours neighbours Info
-	if(get_node_info_list_record_count() > 1)
-	{
-		len = snprintf(str, sizeof(str), "%s", "-----------------------\n");
-		print_line(FONT_SMALL, line++, str, len, false);
-
-		len = snprintf(str, sizeof(str), "%s", "Among Neighbours: \n");
-		print_line(FONT_SMALL, line++, str, len, true);
-	
-		for (int i = 0; i < get_node_info_list_record_count(); i++)
-		{
-			struct stat *stat = &node_info[i];
-			if (stat->addr != BT_MESH_ADDR_UNASSIGNED)
-			{
-				if (stat->addr != get_my_address())
-				{
-					int8_t round_result =  (int8_t) round(stat->distance); 
-					len = snprintf(str, sizeof(str), "%s:0x%04x %s:0x%04x %dm\n",
-								stat->name, stat->addr,
-								stat->neighbour_name, stat->neighbour_addr, round_result);
-					print_line(FONT_SMALL, line++, str, len, false);
-				}
-			}
-		}
-	}
-	cfb_framebuffer_finalize(epd_dev);
-}
-
-/*compute distance in metres from RSSI value */
-static double calculate_distance_in_metres(int8_t rssi)
-{
-	double default_tx = -59; // tx power of nrf52 chip is -59dm at 1m
-	double env_factor = 2.7; //constant for environment factor . Range 2 to 4
-	double exponent = (default_tx - rssi) / (10 * env_factor);
-	double base = 10.0;
-	double result = pow(base, exponent);
-	return result;
-}
-
-/* check if  neighbour record already exists in node_info list */
-static bool check_if_record_neighbour_exists(uint16_t ctx_addr, uint16_t address_hex)
-{
-	int is_record_exists = 0;
-	for (int i = 0; i <  get_node_info_list_record_count(); i++)
-	{
-		struct stat *stat = &node_info[i];
-		if (address_hex != get_my_address() && ((stat->addr == ctx_addr && stat->neighbour_addr == address_hex) ||
-											 (stat->neighbour_addr == ctx_addr && stat->addr == address_hex)))
-		{
-			is_record_exists = 1;
-			return is_record_exists;
-		}
-	}
-	return is_record_exists;
-}
-
-
 /* receive message from a node */
-static void receive_message(struct bt_mesh_model *model , struct bt_mesh_msg_ctx *ctx ,
-		      		        struct net_buf_simple *buf , int8_t rssi)
+void receive_message(struct bt_mesh_msg_ctx *ctx, const struct msg *msg, int8_t rssi)
 {
 	// If Sender address is my own address or unassigned address, return 
 	if (ctx->addr == get_my_address() || ctx->addr== BT_MESH_ADDR_UNASSIGNED) 
 		return;
 
-	// extract message content		
+	// log message content
 	char message_str[32];
-	size_t len =  MIN(buf->len, MSG_MAX_LEN);
-	memcpy(message_str, buf->data, len);
-	message_str[len] = '\0';
+	msg_to_str(msg, message_str, sizeof(message_str));
 	printk("Received Message %s from 0x%04x \n\n", message_str, ctx->addr);
 	
-	// Compute distance in metres from RSSI  value 
-	double distance  = calculate_distance_in_metres(rssi);
-	
-	// if distnace is less than 2 m , blink leds 
-	if (distance < 2 ) 
-		board_blink_leds();
 
 	uint16_t from_address = ctx->addr;
+	uint16_t distance = distance_cm(rssi);
 
 	// update distance and rssi value in node_info list with respect to neighbour with address as from_address
-	for (int i = 0; i <  get_node_info_list_record_count(); i++)
+	struct node_info *stat = node_table_find(get_my_address(), from_address);
+	if (stat)
 	{
-		struct stat *stat = &node_info[i];
-		if (stat->addr == get_my_address())
+		distance = distance_filter_update(&stat->filter, rssi);
+		if (stat->distance != distance_to_metres(distance))
+			gossip_mark_dirty(stat);
+		stat->distance = distance_to_metres(distance);
+		stat->rssi = rssi;
+
+		//if message is of type "Sensor Info Message" with message code as S, 
+		// then save sensor info of neighbor with address as from_address
+		if (msg->type == MSG_SENSOR || msg->type == MSG_GOSSIP) 
 		{
-			if (stat->neighbour_addr == from_address)
+			// gossip messages do not carry the name, it is known from provisioning
+			if (msg->type == MSG_SENSOR)
 			{
-				stat->distance = distance;
-				stat->rssi = rssi;
+				if (strncmp(stat->neighbour_name, msg->name, 3))
+					gossip_mark_dirty(stat);
+				snprintk(stat->neighbour_name, 4, "%s", msg->name);
 			}
+			stat->neighbour_temperature = msg->temperature;
+			stat->neighbour_humidity = msg->humidity;
 		}
-	}
 
-	//if message is of type "Sensor Info Message" with message code as S, 
-	// then save sensor info of neighbor with address as from_address
-	if(strstr(message_str,"S")!=NULL) 
-	{
-		for (int i = 0; i <  get_node_info_list_record_count(); i++)
-		{
-			struct stat *stat = &node_info[i];
-			if (stat->addr == get_my_address())
-			{
-				if (stat->neighbour_addr == from_address)
-				{
-					char msg_str[50];
-					snprintf(msg_str, 50, "%s", message_str);
-					char *msg_token;
-					msg_token = strtok(msg_str, "=");
-					msg_token = strtok(NULL, "=");
-					snprintk(stat->neighbour_name, 4, "%s", msg_token);
-					msg_token = strtok(NULL, "=");
-					stat->neighbour_temperature = atoi(msg_token);
-					msg_token = strtok(NULL, "=");
-					stat->neighbour_humidity= atoi(msg_token);
-					stat->rssi = rssi;
-					stat->distance = distance;
-				}
-			}
-		}
+		node_table_changed(stat);
 	}
 
+	// if distance is less than 2 m , blink leds 
+	if (distance < 200) 
+		board_blink_leds();
+
 	//if message is of type "Neighbours Neighbours Message" with message code as T, 
 	// then add a recors of it in node_info list
-	if(strstr(message_str,"T")!=NULL)
-	{
-		char msg_str[50];
-		snprintf(msg_str, 50, "%s", message_str);
-		char *address_name_token;
-		char address_str[7];
-		address_name_token = strtok(msg_str, "=");
-		address_name_token = strtok(NULL, "=");
-		snprintf(address_str,7,"0X000%s",address_name_token);
-		uint16_t address_hex = (uint16_t)strtol(address_str, NULL, 0);
-		if(address_hex!= BT_MESH_ADDR_UNASSIGNED)
-		{
-			int is_record_exists = check_if_record_neighbour_exists(from_address,address_hex);
-			
-			if (is_record_exists==0) 
-			{
-				struct stat *stat = &node_info[get_node_info_list_record_count()];
-				stat->addr = from_address;
-				stat->neighbour_addr = address_hex;
-				address_name_token = strtok(NULL, "=");
-				snprintf(stat->neighbour_name, 4, "%s", address_name_token);
-				record_count++;
-			}
-		}
-	}
+	if (msg->type == MSG_NEIGH_NEIGH)
+		node_table_add_link(get_my_address(), from_address, msg->addr, msg->name);
 
 	//if message is of type "Neighbours Neighbours Update Info Message" with message code as U, 
 	// update received info to corresponding neighbor neighbour record in node_info list
-	if(strstr(message_str,"U")!=NULL)
+	if (msg->type == MSG_NEIGH_DIST)
+		node_table_update_link(get_my_address(), from_address, msg->addr, msg->distance, msg->name);
+
+	//if message is of type "Gossip Message" with message code as G,
+	// it carries U info of several neighbours of the sender, their names come in T messages
+	if (msg->type == MSG_GOSSIP)
 	{
-		char msg_str[50];
-		snprintf(msg_str, 50, "%s", message_str);
-		char *address_name_token;
-		char address_str[7];
-		address_name_token = strtok(msg_str, "=");
-		address_name_token = strtok(NULL, "=");
-		snprintf(address_str,7,"0X000%s",address_name_token);
-		uint16_t address_hex = (uint16_t)strtol(address_str, NULL, 0);
-		int is_record_exists = check_if_record_neighbour_exists(from_address, address_hex);
-		if (is_record_exists == 1)
+		for (int i = 0; i < msg->neigh_count; i++)
 		{
-			for (int i = 0; i <  get_node_info_list_record_count(); i++)
-			{
-				struct stat *stat = &node_info[i];
-				if(stat->addr == from_address && stat->addr  != get_my_address() &&  stat->neighbour_addr == address_hex)
-				{
-					address_name_token = strtok(NULL, "=");
-					int8_t round_value = atoi(address_name_token);
-					stat->distance = round_value ;
-					address_name_token = strtok(NULL, "=");
-					snprintf(stat->name, 3, "%s", address_name_token);
-				}
-			}
+			node_table_add_link(get_my_address(), from_address, msg->neigh[i].addr, NULL);
+			node_table_update_link(get_my_address(), from_address, msg->neigh[i].addr,
+					       msg->neigh[i].distance, stat ? stat->neighbour_name : NULL);
 		}
 	}
 	
-	// send sensor Info , Neighbours Neighbours Info  stores in node_info list to all my neighbours
-	for (int i = 0; i < get_node_info_list_record_count() ; i++) 
-	{
-		struct stat *stat = &node_info[i];
-		if(stat->addr == get_my_address())
-		{
-			char sensor_info_message[12];
-			snprintf(sensor_info_message, 12, "S=%s=%d=%d", get_my_device_name(),get_temperature(), get_humidity());
-			send_message(stat->neighbour_addr, sensor_info_message);	
-
-			if(stat->neighbour_addr != from_address)
-			{
-				char addr_string[8];
-				snprintf(addr_string,8,"0x%04x",stat->neighbour_addr);
-				char c = addr_string[strlen(addr_string) -1];
-
-				char neighbour_addr_name_msg[10];
-				snprintf(neighbour_addr_name_msg,10,"T=%c=%s",c,stat->neighbour_name);						
-				send_message(from_address,neighbour_addr_name_msg);
-								
-				char neighbour_addr_dist_message[17],dev_name[4];
-				snprintf(dev_name, 4, "%s",get_my_device_name());
-				int8_t round_result = (int8_t) round(stat->distance); 
-				snprintf(neighbour_addr_dist_message, 17, "U=%c=%d=%s", c,round_result,dev_name);
-				send_message(from_address,neighbour_addr_dist_message);	
-			}	
-		}
-			
-	}
+	// my sensor info and changed neighbours info are sent to all my neighbours by the next gossip round
+	gossip_update_self(get_my_address(), get_temperature(), get_humidity());
 
 	// print all reciors of node_info list on serial log 
-	printk ("Record No. : Node_Address Node_Name  Node_Temperature  Node_Humidity Neighbour_Address Neighbour_Name Neighbour_Temperature Neighbour_Humidity Distance Rssi\n ");
-	for (int i = 0; i < get_node_info_list_record_count() ; i++) {
-	struct stat *stat = &node_info[i];
-	printk ("Record %d : 0x%04x %s %dC %d%%    0x%04x %s %dC %d%%    %dm %d\n ",
-			i+1 ,stat->addr, stat->name, stat->temperature,stat->humidity,
-			stat->neighbour_addr , stat->neighbour_name,stat->neighbour_temperature,stat->neighbour_humidity,
-			stat->distance,stat->rssi);
-	}
+	node_table_print();
+	struct msg_rx_stats rx_stats;
+	msg_rx_stats_get(&rx_stats);
+	printk("Receive queue : queued %u handled %u dropped %u max %u\n ",
+			rx_stats.queued, rx_stats.handled, rx_stats.dropped, rx_stats.max_used);
 	printk("\n ");
 
 	//display node_info list info on board
-	show_node_status();
+	node_status_show(get_my_address(), get_my_device_name());
 
-	//generate and get the integration string of complete node_info_list
-	generate_node_info_list_string();
-	get_node_info_list_string();
+	// export the changed topology to the console, rate limited
+	topology_schedule();
 }
 
 static struct bt_mesh_model root_models[] = {
@@ -426,13 +128,8 @@ static struct bt_mesh_model root_models[] = {
 	BT_MESH_MODEL_CFG_SRV,
 };
 
-static const struct bt_mesh_model_op vnd_ops[] = {
-	{ OP_VND_MSG, 1, receive_message },
-	BT_MESH_MODEL_OP_END,
-};
-
 static struct bt_mesh_model vnd_models[] = {
-	BT_MESH_MODEL_VND(BT_COMP_ID_LF, MOD_LF, vnd_ops, NULL, NULL),
+	BT_MESH_MODEL_VND(BT_COMP_ID_LF, MOD_LF, msg_vnd_ops, NULL, NULL),
 };
 
 static struct bt_mesh_elem elements[] = {
@@ -445,43 +142,32 @@ static const struct bt_mesh_comp comp = {
 	.elem_count = ARRAY_SIZE(elements),
 };
 
-/*get first word of message string */
-static size_t get_first_word(const char * message_str)
-{
-	size_t len; 
-	for (len = 0; * message_str; message_str++, len++)
-	{
-		switch (* message_str)
-		{
-		case ' ':
-		case ',':
-		case '\n':
-			return len;
-		}
-	}
-	return len;
-}
-
 /* send message to a node */
-void send_message(uint16_t to_address , const char * message_str)
+int send_message(uint16_t to_address , const struct msg * msg)
 {
+	int err;
+
 	// if to_address is my address or uassigned address, return
 	if(to_address==get_my_address() || to_address==BT_MESH_ADDR_UNASSIGNED )
-		return;
+		return 0;
 
-	//decklare message buffer of size 20
-	NET_BUF_SIMPLE_DEFINE(buf, 3 + MSG_MAX_LEN + 4);
+	//declare message buffer large enough for any message type
+	BT_MESH_MODEL_BUF_DEFINE(buf, OP_VND_PROV_MSG, MSG_MAX_LEN);
 	struct bt_mesh_msg_ctx ctx = {
 		.app_idx = APP_IDX,
 		.addr = to_address,
 		.send_ttl = DEFAULT_TTL,
 	};
-	bt_mesh_model_msg_init(&buf, OP_VND_MSG);
-	net_buf_simple_add_mem(&buf, message_str, MIN(MSG_MAX_LEN, get_first_word(message_str)));
-	if(bt_mesh_model_send(&vnd_models[0], &ctx, &buf, NULL, NULL)==0)
+	msg_encode(&buf, msg);
+	err = bt_mesh_model_send(&vnd_models[0], &ctx, &buf, NULL, NULL);
+	if(err==0)
+	{
+		char message_str[32];
+		msg_to_str(msg, message_str, sizeof(message_str));
 		printk("Sending Message %s to 0x%04x\n\n", message_str , to_address);
-	else
-		return;
+	}
+
+	return err;
 }
 
 /* configure self i.e. provisioner */
@@ -514,61 +200,112 @@ static void configure_self(struct bt_mesh_cdb_node *self)
 	printk("Self-Configuration complete\n\n");
 }
 
-/* configure beacon node */
-static void configure_node(struct bt_mesh_cdb_node *node)
+/* send neighbours info messages (with message code "R") between a new node and my other neighbours */
+static void send_neighbours_info(uint16_t addr, const char *name)
 {
-	printk("Node Configuring Started \n");
+	struct msg new_node_message = {
+		.type = MSG_NEIGH,
+		.addr = addr,
+	};
+	snprintf(new_node_message.name, sizeof(new_node_message.name), "%s", name);
 
-	// Map self to Application Key
-	bt_mesh_cfg_app_key_add(NET_IDX, node->addr, NET_IDX, APP_IDX,application_key, NULL);
+	for (int i = 0; i < get_node_info_list_record_count(); i++)
+	{
+		struct node_info *stat = node_table_get(i);
+		if (stat->addr != get_my_address() || stat->neighbour_addr == addr ||
+		    stat->neighbour_addr == BT_MESH_ADDR_UNASSIGNED)
+			continue;
 
-	// Bind self to vendor model
-	bt_mesh_cfg_mod_app_bind_vnd(NET_IDX, node->addr, node->addr,APP_IDX, MOD_LF, BT_COMP_ID_LF, NULL);
+		struct msg neigh_info_message = {
+			.type = MSG_NEIGH,
+			.addr = stat->neighbour_addr,
+		};
+		snprintf(neigh_info_message.name, sizeof(neigh_info_message.name), "%s", stat->neighbour_name);
+		send_message(addr, &neigh_info_message);
+		send_message(stat->neighbour_addr, &new_node_message);
+	}
+}
+
+/* welcome a beacon node whose app key and model binding are configured */
+static void configure_node(uint16_t addr)
+{
+	struct bt_mesh_cdb_node *node = bt_mesh_cdb_node_get(addr);
+	if (!node)
+		return;
 
 	atomic_set_bit(node->flags, BT_MESH_CDB_NODE_CONFIGURED);
 
-	// add self to the CDB
+	// add node to the CDB
 	if (IS_ENABLED(CONFIG_BT_SETTINGS)) 
 		bt_mesh_cdb_node_store(node);
 
 	//send provisioning message (with message code "Q") to beacon node
-	char prov_name[2];
-	snprintf(prov_name, 2, "%s",get_my_device_name());
-	char node_name[4];
-	snprintf(node_name, 4, "N%d", record_count);
-	char provisioning_message[12];
-	snprintf(provisioning_message, 12, "Q=%s=%s", prov_name,node_name);
-	send_message(node->addr,provisioning_message);
+	struct msg provisioning_message = {
+		.type = MSG_PROV,
+	};
+	snprintf(provisioning_message.prov_name, sizeof(provisioning_message.prov_name), "%s", get_my_device_name());
+	snprintf(provisioning_message.name, sizeof(provisioning_message.name), "N%d", record_count);
+	send_message(node->addr, &provisioning_message);
+
+	// tell the new node and my other neighbours about each other
+	send_neighbours_info(node->addr, provisioning_message.name);
 
 	//add node to node_info list
-	struct stat *stat = &node_info[get_node_info_list_record_count()];
-	stat->addr= get_my_address();
-	stat->humidity = get_humidity();
-	stat->temperature = get_temperature();
-	snprintf(stat->name, 2, "%s",get_my_device_name());
-	snprintf(stat->neighbour_name, 4, "%s",node_name);
-	stat->neighbour_addr = node->addr;
+	struct node_info *stat = node_table_add(get_my_address(), node->addr);
+	if (stat)
+	{
+		stat->humidity = get_humidity();
+		stat->temperature = get_temperature();
+		snprintf(stat->name, 2, "%s",get_my_device_name());
+		snprintf(stat->neighbour_name, 4, "%s", provisioning_message.name);
+		node_table_changed(stat);
+		gossip_mark_dirty(stat);
+	}
 	record_count++;
 
 	printk("Configured node 0x%04x \n",node->addr);
 	printk("Node Configuration completed\n\n");
 }
 
+K_MSGQ_DEFINE(configured_q, sizeof(uint16_t), CONFIG_PROV_MAX_CONFIGURING, 2);
+
+/* node table is owned by the application work queue */
+static void configured_handler(struct k_work *work)
+{
+	uint16_t addr;
+
+	while (!k_msgq_get(&configured_q, &addr, K_NO_WAIT))
+		configure_node(addr);
+}
+
+K_WORK_DEFINE(configured_work, configured_handler);
+
+/* called by the provisioning manager when a node is ready to be welcomed */
+void mesh_node_configured(uint16_t addr)
+{
+	k_msgq_put(&configured_q, &addr, K_FOREVER);
+	k_work_submit_to_queue(&app_work_q, &configured_work);
+}
+
 /* call back function for Provisioner after detecting the beacon node and reads its UUID */
 static void unprovisioned_beacon(uint8_t uuid[16],
 				 bt_mesh_prov_oob_info_t oob_info,
 				 uint32_t *uri_hash)
 {
-	memcpy(node_uuid, uuid, 16);
-	k_sem_give(&sem_unprov_beacon);
+	provisioning_beacon(uuid);
 }
 
 /* call back function for Provisioner after provisioning beacon node and storing the provisioned address of node */
 static void node_added(uint16_t net_idx, uint8_t uuid[16], uint16_t node_addr,
 		       uint8_t num_elem)
 {
-	node_address = node_addr;
-	k_sem_give(&sem_node_added);
+	provisioning_node_added(node_addr);
+}
+
+/* call back function for Provisioner when the provisioning link is closed */
+static void link_close(bt_mesh_prov_bearer_t bearer)
+{
+	provisioning_link_closed();
 }
 
 /* declare mesh profile */
@@ -576,13 +313,17 @@ static const struct bt_mesh_prov prov = {
 	.uuid = my_device_uuid,
 	.unprovisioned_beacon = unprovisioned_beacon,
 	.node_added = node_added,
+	.link_close = link_close,
 };
 
 /* Initialize the Bluetooth Mesh Subsystem */
 static void bt_ready(void)
 {
 	/* Initialize the device */
+	app_work_init();
 	board_init();
+	gossip_init();
+	topology_init();
 
 	printk("Device Initialized\n");
 	board_show_text("Device Initialized\n",true);
@@ -654,7 +395,7 @@ static void bt_ready(void)
 	show_main();
 }
 
-/* check is provisioned node is configured or not */
+/* configure provisioned nodes that were not configured before a restart */
 static uint8_t check_unconfigured(struct bt_mesh_cdb_node *node, void *data)
 {
 	//If not configured , invoke configure function
@@ -663,32 +404,7 @@ static uint8_t check_unconfigured(struct bt_mesh_cdb_node *node, void *data)
 		if (node->addr == self_address) 
 			configure_self(node);
 		else
-			configure_node(node);
-	}
-	// if node is already configured send neighbours info message (with message code "R")  to all neighbours
-	else
-	{
-		//send message to node when node is not same as me
-		if(node->addr!=get_my_address() && node->addr!=BT_MESH_ADDR_UNASSIGNED)
-		{
-			for(int i =0 ;i< get_node_info_list_record_count() ; i++)
-			{
-				struct stat * stat = &node_info[i];
-				if(stat->addr ==  get_my_address())
-				{
-					if(stat->neighbour_addr != node->addr && stat->neighbour_addr!=BT_MESH_ADDR_UNASSIGNED)
-					{
-						char neigh_info_message[12] ;
-						char neigh_addr_string[8];
-						snprintf(neigh_addr_string,8,"0x%04x",stat->neighbour_addr);
-						char last_char_of_address_str = neigh_addr_string[strlen(neigh_addr_string) -1];
-
-						snprintf(neigh_info_message,12,"R=%c=%s",last_char_of_address_str,stat->neighbour_name);
-		;				send_message(node->addr,neigh_info_message);
-					}	
-				}
-			}	
-		}
+			provisioning_configure(node->addr);
 	}
 
 	return BT_MESH_CDB_ITER_CONTINUE;
@@ -701,44 +417,11 @@ void mesh_start(void)
 	bt_enable(NULL);
 	bt_ready();
 
-	int err;
-	// scan and provision/configure/add nodes
-	while (1) {
-		k_sem_reset(&sem_unprov_beacon);
-		k_sem_reset(&sem_node_added);
-		bt_mesh_cdb_node_foreach(check_unconfigured, NULL);
-
-		// scan for beacon nodes
-		printk("Waiting for unprovisioned beacon node...\n");
-		err = k_sem_take(&sem_unprov_beacon, K_SECONDS(5));
-		if (err == -EAGAIN) {
-			continue;
-		}
+	bt_mesh_cdb_node_foreach(check_unconfigured, NULL);
 
-		// node detected
-		char node_uuid_str[8 + 1];
-		bin2hex(node_uuid, 2, node_uuid_str, sizeof(node_uuid_str));
-		printk("Unprovisioned Beacon Node Detected with UUID : %s\n", node_uuid_str);
-
-		// start provisioning node with next sequential address
-		printk("Node Provisioning started \n");
-		char node_address_str[7] , record_count_str[2];
-		snprintf(record_count_str,2,"%d", record_count);
-		snprintf(node_address_str , 7 ,"0X000%s", record_count_str);
-		uint16_t addr = (uint16_t)strtol(node_address_str, NULL, 0);
-
-		err = bt_mesh_provision_adv(node_uuid, NET_IDX, addr, 0);
-		if (err < 0) {
-			continue;
-		}
-
-		err = k_sem_take(&sem_node_added, K_SECONDS(10));
-		if (err == -EAGAIN) {
-			continue;
-		}
-		printk("Node Provisioned Address  0x%04x\n", node_address);
-		printk("Node Provisioning Completed %s\n\n", node_uuid_str);
-	}
+	// scan and provision/configure/add nodes
+	printk("Waiting for unprovisioned beacon node...\n");
+	provisioning_run();
 }
 
 /* get functions */
@@ -759,7 +442,7 @@ char * get_my_device_name(void)
 
 int get_node_info_list_record_count(void)
 {
-	return record_count - 1 ;
+	return node_table_count();
 }
 
 const uint8_t * get_network_key(void)
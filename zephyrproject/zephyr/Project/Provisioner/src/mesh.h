@@ -1,12 +1,9 @@
-#define STAT_COUNT 10
+#include "message.h"
 
 #define MOD_LF            0x0000
 #define NET_IDX           0x000
 #define APP_IDX           0x000
 #define DEFAULT_TTL       31
-#define MSG_MAX_LEN       12
-#define OP_MSG        	  0xbb
-#define OP_VND_MSG        BT_MESH_MODEL_OP_3(OP_MSG, BT_COMP_ID_LF)
 #define IV_INDEX          0
 #define FLAGS             0
 
@@ -34,8 +31,10 @@ int get_node_info_list_record_count(void);
 uint16_t get_my_address(void);
 const uint8_t * get_my_device_uuid(void);
 char * get_my_device_name(void);
+const uint8_t * get_application_key(void);
 
-void send_message(uint16_t to_address, const char * message_str);
+/* provisioning functions */
+void mesh_node_configured(uint16_t addr);
 
 /*mesh functions */
 void mesh_start(void);
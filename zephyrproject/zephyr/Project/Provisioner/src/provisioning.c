@@ -0,0 +1,409 @@
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <sys/util.h>
+#include <string.h>
+
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/mesh.h>
+
+#include "mesh.h"
+#include "provisioning.h"
+
+#define PROV_IDLE_POLL_MS         1000
+#define PROV_RETRY_BACKOFF_MS     2000
+#define PROV_BEACON_TIMEOUT_MS    30000
+
+/* Config Server status code for a key that is already stored */
+#define STATUS_IDX_ALREADY_STORED 0x06
+
+/* unprovisioned device found by its beacon */
+struct prov_candidate {
+	uint8_t uuid[16];
+	int64_t first_seen;
+	int64_t last_seen;
+	int64_t retry_at;
+	uint8_t attempts;
+	bool used;
+};
+
+enum prov_node_state {
+	NODE_APP_KEY_ADD,
+	NODE_MOD_APP_BIND,
+	NODE_WELCOME,
+};
+
+/* provisioned node waiting for its configuration */
+struct prov_node {
+	uint16_t addr;
+	enum prov_node_state state;
+	uint8_t retries;
+	int64_t first_seen;
+	bool used;
+	bool waiting;       /* request of the current state is outstanding */
+	bool has_result;    /* response or timeout of the request arrived */
+	int err;
+	uint8_t status;
+};
+
+static struct prov_candidate candidates[CONFIG_PROV_UUID_QUEUE_SIZE];
+static struct prov_node nodes[CONFIG_PROV_MAX_CONFIGURING];
+
+/* device on the PB-ADV link, the stack supports a single link */
+static struct prov_candidate *link_candidate;
+static bool link_node_added;
+
+static struct {
+	uint32_t provisioned;
+	uint32_t configured;
+	uint32_t failed;
+	uint32_t queue_full;
+	int64_t started;
+	int64_t config_time;    /* sum of beacon to configured time in ms */
+} stats;
+
+K_MUTEX_DEFINE(prov_lock);
+K_SEM_DEFINE(prov_sem, 0, 1);
+
+static struct prov_node *node_alloc(uint16_t addr, int64_t first_seen)
+{
+	for (int i = 0; i < ARRAY_SIZE(nodes); i++) {
+		struct prov_node *node = &nodes[i];
+
+		if (node->used && node->addr == addr)
+			return node;
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(nodes); i++) {
+		struct prov_node *node = &nodes[i];
+
+		if (!node->used) {
+			memset(node, 0, sizeof(*node));
+			node->used = true;
+			node->addr = addr;
+			node->state = NODE_APP_KEY_ADD;
+			node->first_seen = first_seen;
+			return node;
+		}
+	}
+
+	return NULL;
+}
+
+static bool node_slot_free(void)
+{
+	for (int i = 0; i < ARRAY_SIZE(nodes); i++) {
+		if (!nodes[i].used)
+			return true;
+	}
+
+	return false;
+}
+
+/* call back of an unprovisioned beacon, queue the device once */
+void provisioning_beacon(const uint8_t uuid[16])
+{
+	struct prov_candidate *free = NULL;
+	int64_t now = k_uptime_get();
+
+	k_mutex_lock(&prov_lock, K_FOREVER);
+
+	for (int i = 0; i < ARRAY_SIZE(candidates); i++) {
+		struct prov_candidate *candidate = &candidates[i];
+
+		if (!candidate->used) {
+			if (!free)
+				free = candidate;
+			continue;
+		}
+
+		if (!memcmp(candidate->uuid, uuid, 16)) {
+			candidate->last_seen = now;
+			k_mutex_unlock(&prov_lock);
+			return;
+		}
+	}
+
+	if (!free) {
+		stats.queue_full++;
+		k_mutex_unlock(&prov_lock);
+		return;
+	}
+
+	memcpy(free->uuid, uuid, 16);
+	free->first_seen = now;
+	free->last_seen = now;
+	free->retry_at = now;
+	free->attempts = 0;
+	free->used = true;
+
+	k_mutex_unlock(&prov_lock);
+
+	char uuid_str[8 + 1];
+	bin2hex(uuid, 4, uuid_str, sizeof(uuid_str));
+	printk("Unprovisioned Beacon Node Detected with UUID : %s\n", uuid_str);
+
+	k_sem_give(&prov_sem);
+}
+
+/* call back after the device on the link got its address */
+void provisioning_node_added(uint16_t addr)
+{
+	k_mutex_lock(&prov_lock, K_FOREVER);
+
+	link_node_added = true;
+	stats.provisioned++;
+	if (!node_alloc(addr, link_candidate ? link_candidate->first_seen : k_uptime_get()))
+		printk("No room to configure node 0x%04x\n", addr);
+
+	k_mutex_unlock(&prov_lock);
+
+	printk("Node Provisioned Address  0x%04x\n", addr);
+	k_sem_give(&prov_sem);
+}
+
+/* call back when the PB-ADV link is closed, after success or failure */
+void provisioning_link_closed(void)
+{
+	struct prov_candidate *candidate;
+
+	k_mutex_lock(&prov_lock, K_FOREVER);
+
+	candidate = link_candidate;
+	link_candidate = NULL;
+
+	if (candidate && link_node_added) {
+		candidate->used = false;
+	} else if (candidate && ++candidate->attempts >= CONFIG_PROV_MAX_ATTEMPTS) {
+		printk("Node Provisioning failed, giving up\n");
+		candidate->used = false;
+		stats.failed++;
+	} else if (candidate) {
+		printk("Node Provisioning failed, retrying\n");
+		candidate->retry_at = k_uptime_get() + PROV_RETRY_BACKOFF_MS;
+	}
+
+	k_mutex_unlock(&prov_lock);
+
+	k_sem_give(&prov_sem);
+}
+
+/* queue a provisioned node that is not configured yet */
+int provisioning_configure(uint16_t addr)
+{
+	struct prov_node *node;
+
+	k_mutex_lock(&prov_lock, K_FOREVER);
+	node = node_alloc(addr, k_uptime_get());
+	k_mutex_unlock(&prov_lock);
+
+	if (!node)
+		return -ENOMEM;
+
+	k_sem_give(&prov_sem);
+	return 0;
+}
+
+/* open a link to the oldest queued device if a link and a node slot are free */
+static void provisioning_start_link(void)
+{
+	struct prov_candidate *next = NULL;
+	int64_t now = k_uptime_get();
+	uint8_t uuid[16];
+	int err;
+
+	k_mutex_lock(&prov_lock, K_FOREVER);
+
+	if (link_candidate || !node_slot_free()) {
+		k_mutex_unlock(&prov_lock);
+		return;
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(candidates); i++) {
+		struct prov_candidate *candidate = &candidates[i];
+
+		if (!candidate->used)
+			continue;
+
+		/* device is gone */
+		if (now - candidate->last_seen > PROV_BEACON_TIMEOUT_MS) {
+			candidate->used = false;
+			continue;
+		}
+
+		if (candidate->retry_at > now)
+			continue;
+
+		if (!next || candidate->first_seen < next->first_seen)
+			next = candidate;
+	}
+
+	if (!next) {
+		k_mutex_unlock(&prov_lock);
+		return;
+	}
+
+	link_candidate = next;
+	link_node_added = false;
+	memcpy(uuid, next->uuid, 16);
+
+	k_mutex_unlock(&prov_lock);
+
+	// the stack picks the lowest free unicast address
+	printk("Node Provisioning started \n");
+	err = bt_mesh_provision_adv(uuid, NET_IDX, BT_MESH_ADDR_UNASSIGNED, 0);
+
+	k_mutex_lock(&prov_lock, K_FOREVER);
+	if (err) {
+		// -EBUSY while the previous link is still closing
+		if (link_candidate == next)
+			link_candidate = NULL;
+		if (err != -EBUSY)
+			next->retry_at = now + PROV_RETRY_BACKOFF_MS;
+	} else if (!stats.started) {
+		stats.started = now;
+	}
+	k_mutex_unlock(&prov_lock);
+}
+
+static void provisioning_print_stats(void)
+{
+	int64_t elapsed = k_uptime_get() - stats.started;
+	uint32_t rate_x10 = elapsed > 0 ? (uint32_t)(stats.configured * 600000LL / elapsed) : 0;
+
+	printk("Provisioning : provisioned %u configured %u failed %u queue full %u\n",
+	       stats.provisioned, stats.configured, stats.failed, stats.queue_full);
+	printk("Provisioning : %u.%u nodes/min, %u ms per node from beacon to configured\n\n",
+	       rate_x10 / 10, rate_x10 % 10,
+	       stats.configured ? (uint32_t)(stats.config_time / stats.configured) : 0);
+}
+
+/* completion of a Config Client request, called from the mesh stack */
+static void config_status(uint16_t addr, int err, uint8_t status, void *user_data)
+{
+	struct prov_node *node = user_data;
+
+	k_mutex_lock(&prov_lock, K_FOREVER);
+	if (node->used && node->addr == addr && node->waiting) {
+		node->waiting = false;
+		node->has_result = true;
+		node->err = err;
+		node->status = status;
+	}
+	k_mutex_unlock(&prov_lock);
+
+	k_sem_give(&prov_sem);
+}
+
+/* handle the response of the current state, returns false if the node is done */
+static bool node_result(struct prov_node *node)
+{
+	if (node->status == STATUS_IDX_ALREADY_STORED && node->state == NODE_APP_KEY_ADD)
+		node->status = 0;
+
+	if (!node->err && !node->status) {
+		node->state++;
+		node->retries = 0;
+		return true;
+	}
+
+	if (++node->retries > CONFIG_PROV_CONFIG_RETRIES) {
+		printk("Configuring node 0x%04x failed (err %d status %u)\n",
+		       node->addr, node->err, node->status);
+		node->used = false;
+		stats.failed++;
+		return false;
+	}
+
+	return true;
+}
+
+/* send the request of the current state of node */
+static int node_request(struct prov_node *node)
+{
+	switch (node->state) {
+	case NODE_APP_KEY_ADD:
+		return bt_mesh_cfg_app_key_add_async(NET_IDX, node->addr, NET_IDX, APP_IDX,
+						     get_application_key(), config_status, node);
+	case NODE_MOD_APP_BIND:
+		return bt_mesh_cfg_mod_app_bind_vnd_async(NET_IDX, node->addr, node->addr, APP_IDX,
+							  MOD_LF, BT_COMP_ID_LF, config_status, node);
+	default:
+		return -EINVAL;
+	}
+}
+
+/* advance the configuration of all nodes whose last request completed,
+ * returns false if there was nothing to do
+ */
+static bool provisioning_configure_nodes(void)
+{
+	bool busy = false;
+
+	for (int i = 0; i < ARRAY_SIZE(nodes); i++) {
+		struct prov_node *node = &nodes[i];
+		int err;
+
+		k_mutex_lock(&prov_lock, K_FOREVER);
+
+		if (!node->used || node->waiting) {
+			k_mutex_unlock(&prov_lock);
+			continue;
+		}
+
+		if (node->has_result) {
+			node->has_result = false;
+			busy = true;
+			if (!node_result(node)) {
+				k_mutex_unlock(&prov_lock);
+				continue;
+			}
+		}
+
+		if (node->state == NODE_WELCOME) {
+			uint16_t addr = node->addr;
+
+			node->used = false;
+			stats.configured++;
+			stats.config_time += k_uptime_get() - node->first_seen;
+			k_mutex_unlock(&prov_lock);
+
+			mesh_node_configured(addr);
+			provisioning_print_stats();
+			busy = true;
+			continue;
+		}
+
+		node->waiting = true;
+		k_mutex_unlock(&prov_lock);
+
+		err = node_request(node);
+		if (!err) {
+			busy = true;
+			continue;
+		}
+
+		k_mutex_lock(&prov_lock, K_FOREVER);
+		node->waiting = false;
+		// all requests slots in use, try again when one completes
+		if (err != -ENOMEM && err != -EBUSY) {
+			node->has_result = true;
+			node->err = err;
+		}
+		k_mutex_unlock(&prov_lock);
+	}
+
+	return busy;
+}
+
+/* provisioning manager, provisions queued devices while configuring the ones already provisioned */
+void provisioning_run(void)
+{
+	bool busy;
+
+	while (1) {
+		provisioning_start_link();
+		busy = provisioning_configure_nodes();
+
+		k_sem_take(&prov_sem, busy ? K_NO_WAIT : K_MSEC(PROV_IDLE_POLL_MS));
+	}
+}
@@ -0,0 +1,8 @@
+/* callbacks of the mesh stack */
+void provisioning_beacon(const uint8_t uuid[16]);
+void provisioning_node_added(uint16_t addr);
+void provisioning_link_closed(void);
+
+/* provisioning functions */
+int provisioning_configure(uint16_t addr);
+void provisioning_run(void);
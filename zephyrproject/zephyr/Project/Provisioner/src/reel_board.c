@@ -1,11 +1,9 @@
 #include <zephyr.h>
 #include <device.h>
 
-#include <display/cfb.h>
 #include <drivers/flash.h>
 #include <storage/flash_map.h>
 #include <drivers/gpio.h>
-#include <drivers/sensor.h>
 
 #include <sys/printk.h>
 #include <string.h>
@@ -17,17 +15,10 @@
 
 #include "mesh.h"
 #include "board.h"
-
-struct font_info {
-	uint8_t columns;
-} fonts[] = {
-	[FONT_BIG] = { .columns = 12 },
-	[FONT_MEDIUM] = { .columns = 14 },
-	[FONT_SMALL] = { .columns = 26 },
-};
+#include "gossip.h"
+#include "app_work.h"
 
 struct k_delayed_work led_timer;
-static const struct device *epd_dev;
 
 static struct {
 	const struct device *dev;
@@ -44,67 +35,11 @@ static struct {
 	       .pin = DT_GPIO_PIN(DT_ALIAS(led2), gpios),
 	       .flags = DT_GPIO_FLAGS(DT_ALIAS(led2), gpios) } };
 
-/* print line */
-size_t print_line(enum font_size font_size, int row, const char *text,
-				  size_t len, bool center)
-{
-	uint8_t font_height, font_width;
-	uint8_t line[fonts[FONT_SMALL].columns + 1];
-	int pad;
-	epd_dev = device_get_binding(DISPLAY_DRIVER);
-	cfb_framebuffer_set_font(epd_dev, font_size);
-
-	len = MIN(len, fonts[font_size].columns);
-	memcpy(line, text, len);
-	line[len] = '\0';
-
-	if (center)
-		pad = (fonts[font_size].columns - len) / 2U;
-	else
-		pad = 0;
-	cfb_get_font_size(epd_dev, font_size, &font_width, &font_height);
-	cfb_print(epd_dev, line, font_width * pad, font_height * row);
-	return len;
-}
-
-/* get humidity sensor value from "ti_hdc" sample */
-int get_humidity(void)
-{
-	const struct device *dev;
-	struct sensor_value humidity;
-
-	dev = device_get_binding(DT_LABEL(DT_INST(0, ti_hdc)));
-	sensor_sample_fetch(dev);
-	sensor_channel_get(dev, SENSOR_CHAN_HUMIDITY, &humidity);
-
-	int humidity_value = (int)humidity.val1;
-	return humidity_value;
-}
-
-
-/* get temperature sensor value from "ti_hdc" sample */
-unsigned int get_temperature(void)
-{
-	const struct device *dev;
-	struct sensor_value temp;
-
-	dev = device_get_binding(DT_LABEL(DT_INST(0, ti_hdc)));
-	sensor_sample_fetch(dev);
-	sensor_channel_get(dev, SENSOR_CHAN_AMBIENT_TEMP, &temp);
-
-	int temperature_value = (int)temp.val1;
-	if (temperature_value < 0)
-		temperature_value = 0;
-	return temperature_value;
-}
-
 /* Display main screen info */
-void show_main()
+static void draw_main(void *user_data)
 {
 	char str[100];
 	int len, line = 0;
-	epd_dev = device_get_binding(DISPLAY_DRIVER);
-	cfb_framebuffer_clear(epd_dev, true);
 
 	len = snprintf(str, sizeof(str), "Mesh Info :\n");
 	print_line(FONT_SMALL, line++, str, len, true);
@@ -135,7 +70,11 @@ void show_main()
 	len = snprintf(str, sizeof(str), "Node Count : %d",get_node_info_list_record_count()+1);
 	print_line(FONT_SMALL, line++, str, len, false);
 
-	cfb_framebuffer_finalize(epd_dev);
+}
+
+void show_main()
+{
+	screen_draw(draw_main, NULL);
 }
 
 /*blink board leds lights */
@@ -189,21 +128,46 @@ static int configure_leds(void)
 	return 0;
 }
 
+/* text drawn by board_show_text() */
+struct board_text {
+	const char *str;
+	bool center;
+};
+
+static void draw_text(void *user_data)
+{
+	const struct board_text *text = user_data;
+
+	print_line(FONT_SMALL, 0, text->str, strlen(text->str), text->center);
+}
+
 /*show text on board display */
 void board_show_text(const char * message_str, bool center)
 {
-	int line = 0;
-	epd_dev = device_get_binding(DISPLAY_DRIVER);
-	cfb_framebuffer_clear(epd_dev, true);
-	print_line(FONT_SMALL, line++, message_str, strlen(message_str), center);
-	cfb_framebuffer_finalize(epd_dev);
+	struct board_text text = { .str = message_str, .center = center };
+
+	screen_draw(draw_text, &text);
+}
+
+/* send my new sensor values to my neighbours */
+static void sensor_changed_handler(struct k_work *work)
+{
+	if (get_my_address() != BT_MESH_ADDR_UNASSIGNED)
+		gossip_update_self(get_my_address(), get_temperature(), get_humidity());
+}
+
+K_WORK_DEFINE(sensor_changed_work, sensor_changed_handler);
+
+/* called from the sampler thread, hand over to the application work queue */
+static void sensor_changed(int temperature, int humidity)
+{
+	k_work_submit_to_queue(&app_work_q, &sensor_changed_work);
 }
 
 /*initialize device board */
 void board_init(void)
 {
-	epd_dev = device_get_binding(DISPLAY_DRIVER);	
-	cfb_framebuffer_init(epd_dev) ;
-	cfb_framebuffer_clear(epd_dev, true);
+	screen_init(device_get_binding(DISPLAY_DRIVER));
+	sampler_init(sensor_changed);
 	configure_leds();
 }
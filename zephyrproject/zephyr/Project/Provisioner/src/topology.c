@@ -0,0 +1,412 @@
+#include <zephyr.h>
+#include <sys/printk.h>
+#include <sys/util.h>
+#include <sys/crc.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/mesh.h>
+
+#include "mesh.h"
+#include "node_table.h"
+#include "app_work.h"
+#include "topology.h"
+
+#define TOPOLOGY_MAX_NODES   (CONFIG_NODE_INFO_TABLE_SIZE + 1)
+#define TOPOLOGY_SLOTS       (2 * TOPOLOGY_MAX_NODES)
+#define TOPOLOGY_CHUNK_SIZE  64
+
+BUILD_ASSERT(TOPOLOGY_SLOTS < UINT16_MAX);
+
+/* exported node, its links are chained through the records from first_link */
+struct topology_node {
+	uint16_t addr;
+	int8_t temperature;
+	uint8_t humidity;
+	uint16_t first_link;   /* record index + 1, 0 if none */
+	uint16_t last_link;
+	uint16_t link_count;
+	bool dirty;
+};
+
+/* export state of a node table record, kept up to date as the record changes */
+struct topology_record {
+	uint16_t next[2];      /* next link of the node at each end, record index + 1 */
+	bool attached[2];      /* linked into the list of the node at each end */
+	bool indexed;
+	bool exported;
+	bool dirty;
+	uint16_t crc;          /* checksum of the exported fields, as serialized */
+	uint16_t exported_crc;
+};
+
+static struct topology_node nodes[TOPOLOGY_MAX_NODES];
+static uint16_t slots[TOPOLOGY_SLOTS];   /* node index + 1, 0 if empty */
+static int node_count;
+
+static struct topology_record records[CONFIG_NODE_INFO_TABLE_SIZE];
+static int record_count;
+
+/* what changed since the last export */
+static uint16_t dirty_nodes[TOPOLOGY_MAX_NODES];
+static int dirty_node_count;
+static uint16_t dirty_records[CONFIG_NODE_INFO_TABLE_SIZE];
+static int dirty_record_count;
+static bool full_pending;   /* records were removed, only a full export shows it */
+
+/* periodic export output, the console if not set */
+static topology_out_t export_out;
+static void *export_ctx;
+
+/* output buffered into small chunks */
+struct topology_writer {
+	topology_out_t out;
+	void *ctx;
+	size_t len;
+	uint8_t buf[TOPOLOGY_CHUNK_SIZE];
+};
+
+static void writer_flush(struct topology_writer *w)
+{
+	if (w->len) {
+		w->out(w->ctx, w->buf, w->len);
+		w->len = 0;
+	}
+}
+
+static void writer_put(struct topology_writer *w, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+
+	while (len) {
+		size_t n = MIN(len, sizeof(w->buf) - w->len);
+
+		memcpy(&w->buf[w->len], p, n);
+		w->len += n;
+		p += n;
+		len -= n;
+
+		if (w->len == sizeof(w->buf))
+			writer_flush(w);
+	}
+}
+
+static void writer_printf(struct topology_writer *w, const char *fmt, ...)
+{
+	char str[24];
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	len = vsnprintk(str, sizeof(str), fmt, args);
+	va_end(args);
+
+	writer_put(w, str, MIN(len, sizeof(str) - 1));
+}
+
+static uint16_t *node_slot(uint16_t addr)
+{
+	/* high half of the Fibonacci product depends on every address bit */
+	uint32_t i = (((uint32_t)addr * 2654435761U) >> 16) % TOPOLOGY_SLOTS;
+
+	while (slots[i] && nodes[slots[i] - 1].addr != addr)
+		i = (i + 1) % TOPOLOGY_SLOTS;
+
+	return &slots[i];
+}
+
+static struct topology_node *node_find(uint16_t addr)
+{
+	uint16_t *slot = node_slot(addr);
+
+	return *slot ? &nodes[*slot - 1] : NULL;
+}
+
+static void node_dirty(struct topology_node *node)
+{
+	if (node->dirty)
+		return;
+
+	node->dirty = true;
+	dirty_nodes[dirty_node_count++] = node - nodes;
+}
+
+/* append record index to the links of node, end is the side of the record node is on */
+static void node_link(struct topology_node *node, int index, int end)
+{
+	struct topology_record *rec = &records[index];
+
+	if (rec->attached[end])
+		return;
+
+	if (node->last_link) {
+		const struct node_info *last = node_table_get(node->last_link - 1);
+
+		records[node->last_link - 1].next[last->addr == node->addr ? 0 : 1] = index + 1;
+	} else {
+		node->first_link = index + 1;
+	}
+
+	node->last_link = index + 1;
+	node->link_count++;
+	rec->attached[end] = true;
+	node_dirty(node);
+}
+
+/* add node, with the links indexed before it was known */
+static struct topology_node *node_add(uint16_t addr)
+{
+	uint16_t *slot = node_slot(addr);
+	struct topology_node *node;
+
+	if (*slot)
+		return &nodes[*slot - 1];
+
+	node = &nodes[node_count++];
+	memset(node, 0, sizeof(*node));
+	node->addr = addr;
+	*slot = node_count;
+	node_dirty(node);
+
+	for (int i = 0; i < record_count; i++) {
+		const struct node_info *stat = node_table_get(i);
+
+		if (!records[i].indexed)
+			continue;
+
+		if (stat->addr == addr)
+			node_link(node, i, 0);
+		else if (stat->neighbour_addr == addr)
+			node_link(node, i, 1);
+	}
+
+	return node;
+}
+
+static uint16_t record_crc(const struct node_info *stat)
+{
+	struct {
+		uint16_t addr;
+		uint16_t neighbour_addr;
+		int8_t temperature;
+		uint8_t humidity;
+		int8_t neighbour_temperature;
+		uint8_t neighbour_humidity;
+		int8_t distance;
+	} __packed fields = {
+		stat->addr, stat->neighbour_addr, stat->temperature, stat->humidity,
+		stat->neighbour_temperature, stat->neighbour_humidity, stat->distance,
+	};
+
+	return crc16_ccitt(0xffff, (const uint8_t *)&fields, sizeof(fields));
+}
+
+static void topology_reset(void)
+{
+	memset(slots, 0, sizeof(slots));
+	memset(records, 0, sizeof(records));
+	node_count = 0;
+	record_count = 0;
+	dirty_node_count = 0;
+	dirty_record_count = 0;
+	full_pending = true;
+}
+
+/* node table callback, keeps the index and the checksums of the records up
+ * to date so that an export only walks what changed
+ */
+static void topology_record_changed(int index, struct node_info *stat)
+{
+	uint16_t me = get_my_address();
+	struct topology_record *rec;
+	struct topology_node *a, *b;
+
+	if (!stat) {
+		topology_reset();
+		return;
+	}
+
+	if (stat->addr == BT_MESH_ADDR_UNASSIGNED || stat->neighbour_addr == BT_MESH_ADDR_UNASSIGNED ||
+	    stat->addr == stat->neighbour_addr)
+		return;
+
+	rec = &records[index];
+	if (!rec->indexed) {
+		rec->indexed = true;
+		record_count = MAX(record_count, index + 1);
+	}
+
+	/* me and my neighbours are exported, with all their links */
+	if (stat->addr == me) {
+		a = node_add(me);
+		b = node_add(stat->neighbour_addr);
+
+		if (a->temperature != stat->temperature || a->humidity != stat->humidity) {
+			a->temperature = stat->temperature;
+			a->humidity = stat->humidity;
+			node_dirty(a);
+		}
+
+		if (b->temperature != stat->neighbour_temperature ||
+		    b->humidity != stat->neighbour_humidity) {
+			b->temperature = stat->neighbour_temperature;
+			b->humidity = stat->neighbour_humidity;
+			node_dirty(b);
+		}
+	} else {
+		a = node_find(stat->addr);
+		b = node_find(stat->neighbour_addr);
+	}
+
+	if (a)
+		node_link(a, index, 0);
+	if (b)
+		node_link(b, index, 1);
+
+	rec->crc = record_crc(stat);
+	if (rec->exported && rec->crc == rec->exported_crc)
+		return;
+
+	if (!rec->dirty) {
+		rec->dirty = true;
+		dirty_records[dirty_record_count++] = index;
+	}
+
+	if (a)
+		node_dirty(a);
+	if (b)
+		node_dirty(b);
+}
+
+static void topology_write_node(struct topology_writer *w, enum topology_format format,
+				const struct topology_node *node)
+{
+	if (format == TOPOLOGY_TEXT) {
+		writer_printf(w, "0x%04x,%d,%d,%d", node->addr, node->temperature,
+			      node->humidity, node->link_count);
+	} else {
+		uint8_t header[5] = { node->addr, node->addr >> 8, node->temperature,
+				      node->humidity, MIN(node->link_count, UINT8_MAX) };
+
+		writer_put(w, header, sizeof(header));
+	}
+
+	for (int l = 0, i = node->first_link - 1; l < node->link_count; l++) {
+		struct node_info *stat = node_table_get(i);
+		uint16_t peer = stat->addr == node->addr ? stat->neighbour_addr : stat->addr;
+
+		if (format == TOPOLOGY_TEXT) {
+			writer_printf(w, ",0x%04x:%d", peer, stat->distance);
+		} else if (l < UINT8_MAX) {
+			uint8_t link[3] = { peer, peer >> 8, stat->distance };
+
+			writer_put(w, link, sizeof(link));
+		}
+
+		i = records[i].next[stat->addr == node->addr ? 0 : 1] - 1;
+	}
+
+	if (format == TOPOLOGY_TEXT)
+		writer_put(w, ";", 1);
+}
+
+/* stream the topology to out, only the nodes whose records changed since the
+ * last export if changed_only is set. Returns the number of nodes written.
+ */
+int topology_export(enum topology_format format, bool changed_only,
+		    topology_out_t out, void *ctx)
+{
+	struct topology_writer w = { .out = out, .ctx = ctx };
+	int written = 0;
+
+	if (full_pending)
+		changed_only = false;
+
+	if (changed_only) {
+		for (int d = 0; d < dirty_node_count; d++) {
+			topology_write_node(&w, format, &nodes[dirty_nodes[d]]);
+			written++;
+		}
+	} else {
+		for (int n = 0; n < node_count; n++) {
+			topology_write_node(&w, format, &nodes[n]);
+			written++;
+		}
+	}
+	writer_flush(&w);
+
+	for (int d = 0; d < dirty_record_count; d++) {
+		struct topology_record *rec = &records[dirty_records[d]];
+
+		rec->exported_crc = rec->crc;
+		rec->exported = true;
+		rec->dirty = false;
+	}
+	dirty_record_count = 0;
+
+	for (int d = 0; d < dirty_node_count; d++)
+		nodes[dirty_nodes[d]].dirty = false;
+	dirty_node_count = 0;
+	full_pending = false;
+
+	return written;
+}
+
+static void console_out(void *ctx, const uint8_t *data, size_t len)
+{
+	if (IS_ENABLED(CONFIG_TOPOLOGY_EXPORT_BINARY)) {
+		for (size_t i = 0; i < len; i++)
+			printk("%02x", data[i]);
+	} else {
+		char str[TOPOLOGY_CHUNK_SIZE + 1];
+
+		len = MIN(len, TOPOLOGY_CHUNK_SIZE);
+		memcpy(str, data, len);
+		str[len] = '\0';
+		printk("%s", str);
+	}
+}
+
+/* periodic export of the changes to the console */
+static void topology_export_handler(struct k_work *work)
+{
+	enum topology_format format = IS_ENABLED(CONFIG_TOPOLOGY_EXPORT_BINARY) ?
+				      TOPOLOGY_BINARY : TOPOLOGY_TEXT;
+
+	if (export_out) {
+		topology_export(format, IS_ENABLED(CONFIG_TOPOLOGY_EXPORT_CHANGED_ONLY),
+				export_out, export_ctx);
+		return;
+	}
+
+	printk("Node Info List Integration String is ");
+	topology_export(format, IS_ENABLED(CONFIG_TOPOLOGY_EXPORT_CHANGED_ONLY),
+			console_out, NULL);
+	printk("\n\n");
+}
+
+K_DELAYED_WORK_DEFINE(topology_work, topology_export_handler);
+
+/* the node table changed, export it at most once per CONFIG_TOPOLOGY_EXPORT_PERIOD_MS */
+void topology_schedule(void)
+{
+	if (k_delayed_work_pending(&topology_work))
+		return;
+
+	k_delayed_work_submit_to_queue(&app_work_q, &topology_work,
+				       K_MSEC(CONFIG_TOPOLOGY_EXPORT_PERIOD_MS));
+}
+
+/* send the periodic export to out instead of the console, NULL restores the console */
+void topology_output_set(topology_out_t out, void *ctx)
+{
+	export_out = out;
+	export_ctx = ctx;
+}
+
+/* start indexing the node table, before any record is added */
+void topology_init(void)
+{
+	node_table_change_cb_set(topology_record_changed);
+}
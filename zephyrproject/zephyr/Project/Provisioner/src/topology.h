@@ -0,0 +1,15 @@
+/* topology export formats */
+enum topology_format {
+	TOPOLOGY_TEXT,      /* "0xaddr,temp,hum,count,0xpeer:dist,...;" per node */
+	TOPOLOGY_BINARY,    /* addr le16, temp, hum, count, then count x (peer le16, dist) per node */
+};
+
+/* receives the export chunk by chunk */
+typedef void (*topology_out_t)(void *ctx, const uint8_t *data, size_t len);
+
+/* topology functions */
+void topology_init(void);
+int topology_export(enum topology_format format, bool changed_only,
+		    topology_out_t out, void *ctx);
+void topology_output_set(topology_out_t out, void *ctx);
+void topology_schedule(void);
@@ -67,6 +67,41 @@ int bt_encrypt_le(const uint8_t key[16], const uint8_t plaintext[16],
 int bt_encrypt_be(const uint8_t key[16], const uint8_t plaintext[16],
 		  uint8_t enc_data[16]);
 
+/** @brief Expanded AES-128 key.
+ *
+ *  Holds the key schedule of a key that encrypts many blocks, so that the
+ *  key is only expanded once. Initialize with @ref bt_aes_key_set.
+ */
+struct bt_aes_key {
+#if defined(CONFIG_BT_HOST_CRYPTO)
+	uint32_t sched[44];
+#else
+	uint8_t key[16];
+#endif
+};
+
+/** @brief Expand a big-endian AES key.
+ *
+ *  @param aes_key Expanded key to initialize
+ *  @param key     128 bit MS byte first key
+ *
+ *  @return Zero on success or error code otherwise.
+ */
+int bt_aes_key_set(struct bt_aes_key *aes_key, const uint8_t key[16]);
+
+/** @brief AES encrypt big-endian data with an expanded key.
+ *
+ *  Same as @ref bt_encrypt_be, but without expanding the key.
+ *
+ *  @param key Expanded key, see @ref bt_aes_key_set
+ *  @param plaintext 128 bit MS byte first plaintext data block to be encrypted
+ *  @param enc_data 128 bit MS byte first encrypted data block
+ *
+ *  @return Zero on success or error code otherwise.
+ */
+int bt_encrypt_be_key(const struct bt_aes_key *key,
+		      const uint8_t plaintext[16], uint8_t enc_data[16]);
+
 
 /** @brief Decrypt big-endian data with AES-CCM.
  *
@@ -116,6 +151,49 @@ int bt_ccm_encrypt(const uint8_t key[16], uint8_t nonce[13], const uint8_t *enc_
 		   size_t len, const uint8_t *aad, size_t aad_len,
 		   uint8_t *plaintext, size_t mic_size);
 
+/** @brief Decrypt big-endian data with AES-CCM and an expanded key.
+ *
+ *  Same as @ref bt_ccm_decrypt, but runs every block against the already
+ *  expanded @p key.
+ *
+ *  @param key       Expanded key, see @ref bt_aes_key_set
+ *  @param nonce     13 byte MS byte first nonce
+ *  @param enc_data  Encrypted data
+ *  @param len       Length of the encrypted data
+ *  @param aad       Additional input data
+ *  @param aad_len   Additional input data length
+ *  @param plaintext Plaintext buffer to place result in
+ *  @param mic_size  Size of the trailing MIC (in bytes)
+ *
+ *  @retval 0        Successfully decrypted the data.
+ *  @retval -EINVAL  Invalid parameters.
+ *  @retval -EBADMSG Authentication failed.
+ */
+int bt_ccm_decrypt_key(const struct bt_aes_key *key, uint8_t nonce[13],
+		       const uint8_t *enc_data, size_t len, const uint8_t *aad,
+		       size_t aad_len, uint8_t *plaintext, size_t mic_size);
+
+/** @brief Encrypt big-endian data with AES-CCM and an expanded key.
+ *
+ *  Same as @ref bt_ccm_encrypt, but runs every block against the already
+ *  expanded @p key.
+ *
+ *  @param key       Expanded key, see @ref bt_aes_key_set
+ *  @param nonce     13 byte MS byte first nonce
+ *  @param enc_data  Buffer to place encrypted data in
+ *  @param len       Length of the encrypted data
+ *  @param aad       Additional input data
+ *  @param aad_len   Additional input data length
+ *  @param plaintext Plaintext buffer to encrypt
+ *  @param mic_size  Size of the trailing MIC (in bytes)
+ *
+ *  @retval 0        Successfully encrypted the data.
+ *  @retval -EINVAL  Invalid parameters.
+ */
+int bt_ccm_encrypt_key(const struct bt_aes_key *key, uint8_t nonce[13],
+		       const uint8_t *enc_data, size_t len, const uint8_t *aad,
+		       size_t aad_len, uint8_t *plaintext, size_t mic_size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,6 +24,7 @@
 #include <bluetooth/mesh/proxy.h>
 #include <bluetooth/mesh/heartbeat.h>
 #include <bluetooth/mesh/cdb.h>
+#include <bluetooth/mesh/stats.h>
 #include <bluetooth/mesh/cfg.h>
 
 #endif /* ZEPHYR_INCLUDE_BLUETOOTH_MESH_H_ */
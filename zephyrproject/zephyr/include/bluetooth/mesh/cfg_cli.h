@@ -924,6 +924,83 @@ int bt_mesh_cfg_hb_pub_set(uint16_t net_idx, uint16_t addr,
 int bt_mesh_cfg_hb_pub_get(uint16_t net_idx, uint16_t addr,
 			   struct bt_mesh_cfg_hb_pub *pub, uint8_t *status);
 
+/** @brief Completion callback of an asynchronous Configuration Client
+ *         request.
+ *
+ *  Called from the context that received the status message, or from the
+ *  system work queue if no status arrived within the transmission timeout.
+ *
+ *  @param addr      Target node address of the request.
+ *  @param err       0 if a status was received, -ETIMEDOUT otherwise.
+ *  @param status    Status code of the response, only valid if @c err is 0.
+ *  @param user_data User data passed with the request.
+ */
+typedef void (*bt_mesh_cfg_cli_async_cb_t)(uint16_t addr, int err,
+					   uint8_t status, void *user_data);
+
+/** @brief Add an application key to the target node without waiting for
+ *         the response.
+ *
+ *  Up to @option{CONFIG_BT_MESH_CFG_CLI_ASYNC_COUNT} asynchronous requests
+ *  may be outstanding at once, to the same or to different nodes, and
+ *  independently of the synchronous API.
+ *
+ *  @param net_idx     Network index to encrypt with.
+ *  @param addr        Target node address.
+ *  @param key_net_idx Network key index the application key belongs to.
+ *  @param key_app_idx Application key index.
+ *  @param app_key     Application key.
+ *  @param cb          Completion callback.
+ *  @param user_data   User data passed to @c cb.
+ *
+ *  @return 0 if the request was sent, -ENOMEM if too many requests are
+ *          pending, or (negative) error code on failure.
+ */
+int bt_mesh_cfg_app_key_add_async(uint16_t net_idx, uint16_t addr,
+				  uint16_t key_net_idx, uint16_t key_app_idx,
+				  const uint8_t app_key[16],
+				  bt_mesh_cfg_cli_async_cb_t cb, void *user_data);
+
+/** @brief Bind an application to a SIG model on the target node without
+ *         waiting for the response.
+ *
+ *  @param net_idx     Network index to encrypt with.
+ *  @param addr        Target node address.
+ *  @param elem_addr   Element address the model is in.
+ *  @param mod_app_idx Application index to bind.
+ *  @param mod_id      Model ID.
+ *  @param cb          Completion callback.
+ *  @param user_data   User data passed to @c cb.
+ *
+ *  @return 0 if the request was sent, -ENOMEM if too many requests are
+ *          pending, or (negative) error code on failure.
+ */
+int bt_mesh_cfg_mod_app_bind_async(uint16_t net_idx, uint16_t addr,
+				   uint16_t elem_addr, uint16_t mod_app_idx,
+				   uint16_t mod_id,
+				   bt_mesh_cfg_cli_async_cb_t cb, void *user_data);
+
+/** @brief Bind an application to a vendor model on the target node without
+ *         waiting for the response.
+ *
+ *  @param net_idx     Network index to encrypt with.
+ *  @param addr        Target node address.
+ *  @param elem_addr   Element address the model is in.
+ *  @param mod_app_idx Application index to bind.
+ *  @param mod_id      Model ID.
+ *  @param cid         Company ID of the model.
+ *  @param cb          Completion callback.
+ *  @param user_data   User data passed to @c cb.
+ *
+ *  @return 0 if the request was sent, -ENOMEM if too many requests are
+ *          pending, or (negative) error code on failure.
+ */
+int bt_mesh_cfg_mod_app_bind_vnd_async(uint16_t net_idx, uint16_t addr,
+				       uint16_t elem_addr, uint16_t mod_app_idx,
+				       uint16_t mod_id, uint16_t cid,
+				       bt_mesh_cfg_cli_async_cb_t cb,
+				       void *user_data);
+
 /** @brief Get the current transmission timeout value.
  *
  *  @return The configured transmission timeout in milliseconds.
@@ -512,6 +512,22 @@ void bt_mesh_iv_update_test(bool enable);
  */
 bool bt_mesh_iv_update(void);
 
+/** @brief Configure the relay suppression of the local device
+ *
+ *  A message to be relayed from the advertising bearer is held back for a
+ *  random backoff of up to @p max_delay milliseconds, and dropped if
+ *  @p threshold copies of it were heard from other relays in the meantime.
+ *  This API is only available if relay suppression has been enabled in
+ *  Kconfig.
+ *
+ *  @param threshold Number of copies that suppress relaying a message, or
+ *                   zero to relay every message right away.
+ *  @param max_delay Maximum backoff in milliseconds, at most 1000.
+ *
+ *  @return Zero on success or (negative) error code otherwise.
+ */
+int bt_mesh_relay_suppress_set(uint8_t threshold, uint16_t max_delay);
+
 /** @brief Toggle the Low Power feature of the local device
  *
  *  Enables or disables the Low Power feature of the local device. This is
@@ -0,0 +1,203 @@
+/** @file
+ *  @brief Bluetooth Mesh statistics API.
+ */
+
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef ZEPHYR_INCLUDE_BLUETOOTH_MESH_STATS_H_
+#define ZEPHYR_INCLUDE_BLUETOOTH_MESH_STATS_H_
+
+/**
+ * @brief Bluetooth Mesh
+ * @defgroup bt_mesh_stats Bluetooth Mesh statistics
+ * @ingroup bt_mesh
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Events counted by the mesh statistics, with the meaning of their value. */
+enum bt_mesh_stats_evt {
+	BT_MESH_STATS_ADV_HEARD,        /**< Mesh Message AD received */
+	BT_MESH_STATS_DUP_DROP,         /**< Dropped by the duplicate filter */
+	BT_MESH_STATS_CACHE_DROP,       /**< Dropped by the Network Message
+					 *   Cache
+					 */
+	BT_MESH_STATS_NET_RX,           /**< Decrypted, val: trial decryptions */
+	BT_MESH_STATS_NET_UNKNOWN,      /**< No key found, val: trial
+					 *   decryptions
+					 */
+	BT_MESH_STATS_RELAY_SENT,       /**< Relayed on the advertising bearer */
+	BT_MESH_STATS_RELAY_NO_BUF,     /**< Not relayed for lack of buffers */
+	BT_MESH_STATS_RELAY_SUPPRESSED, /**< Not relayed after hearing others */
+	BT_MESH_STATS_SEG_RETRANSMIT,   /**< Segment sent again */
+	BT_MESH_STATS_SEG_EVICT,        /**< Stale incoming message dropped */
+	BT_MESH_STATS_ACK_SENT,         /**< Segment Acknowledgment went out */
+	BT_MESH_STATS_ACK_REPLACED,     /**< Queued ack replaced by a newer one */
+	BT_MESH_STATS_ACK_REPEATED,     /**< Ack not sent, same block just
+					 *   acked
+					 */
+	BT_MESH_STATS_ACK_DEFERRED,     /**< Ack put off as segments came in */
+	BT_MESH_STATS_RPL_REJECT,       /**< Rejected by the Replay Protection */
+	BT_MESH_STATS_ADV_QUEUED,       /**< Advertising buffer queued, val:
+					 *   advertising class
+					 */
+	BT_MESH_STATS_ADV_CANCELED,     /**< Canceled buffer taken off the
+					 *   queue, val: advertising class
+					 */
+	BT_MESH_STATS_ADV_SENT,         /**< Buffer sent, val: ms in the queue */
+
+	BT_MESH_STATS_EVTS,
+};
+
+/** Upper bounds in milliseconds of the time in queue histogram buckets,
+ *  the last bucket counts everything longer.
+ */
+#define BT_MESH_STATS_WAIT_BOUNDS 10, 50, 100, 500
+/** Number of buckets in the time in queue histogram. */
+#define BT_MESH_STATS_WAIT_BUCKETS 5
+
+/** Entries of the trial decryption histogram, the last entry counts three
+ *  or more credentials tried.
+ */
+#define BT_MESH_STATS_TRIALS 4
+
+/** Advertising classes, in the order of @ref bt_mesh_stats::adv: Segment
+ *  Acknowledgments, Friend, provisioning, relay, local and beacon PDUs.
+ */
+#define BT_MESH_STATS_ADV_CLASSES 6
+
+/** Advertising queue statistics of one advertising class. */
+struct bt_mesh_stats_adv {
+	/** Buffers taken for sending. */
+	uint32_t sent;
+	/** Buffers canceled while queued. */
+	uint32_t canceled;
+	/** Allocations failed on the buffer quota. */
+	uint32_t no_quota;
+	/** Buffers in the queue. */
+	uint16_t depth;
+	/** Most buffers in the queue. */
+	uint16_t max_depth;
+	/** Total time waited in the queue, in milliseconds. */
+	uint32_t wait_ms;
+	/** Longest time waited in the queue, in milliseconds. */
+	uint32_t max_wait_ms;
+};
+
+/** Snapshot of the mesh statistics.
+ *
+ *  The counters up to and including @ref bt_mesh_stats::adv_wait are the
+ *  "bt_mesh" statistics group and are cleared by bt_mesh_stats_reset(),
+ *  except for the advertising queue depth, which is a level. The details
+ *  after it are kept by the layers themselves and are never cleared.
+ */
+struct bt_mesh_stats {
+	/** Mesh Message ADs heard. */
+	uint32_t adv_heard;
+	/** PDUs dropped by the duplicate filter. */
+	uint32_t dup_drop;
+	/** PDUs dropped by the Network Message Cache. */
+	uint32_t cache_drop;
+	/** PDUs decrypted with one of the network keys. */
+	uint32_t net_rx;
+	/** PDUs no network key decrypted. */
+	uint32_t net_unknown;
+	/** Trial decryptions of all PDUs. */
+	uint32_t net_trials;
+	/** PDUs relayed on the advertising bearer. */
+	uint32_t relay_sent;
+	/** PDUs not relayed for lack of buffers. */
+	uint32_t relay_no_buf;
+	/** PDUs not relayed after hearing other relays. */
+	uint32_t relay_suppressed;
+	/** Segments sent again. */
+	uint32_t seg_retransmit;
+	/** Stale incoming segmented messages dropped. */
+	uint32_t seg_evict;
+	/** Segment Acknowledgments sent. */
+	uint32_t ack_sent;
+	/** Queued acks replaced by a newer one. */
+	uint32_t ack_replaced;
+	/** Acks not sent as the same block was just acked. */
+	uint32_t ack_repeated;
+	/** Acks put off as segments came in. */
+	uint32_t ack_deferred;
+	/** Messages rejected by the Replay Protection. */
+	uint32_t rpl_reject;
+	/** Advertising buffers queued. */
+	uint32_t adv_queued;
+	/** Advertising buffers in the queue. */
+	uint32_t adv_depth;
+	/** Most advertising buffers in the queue. */
+	uint32_t adv_max_depth;
+	/** Time in queue histogram, see @ref BT_MESH_STATS_WAIT_BOUNDS. */
+	uint32_t adv_wait[BT_MESH_STATS_WAIT_BUCKETS];
+
+	/** PDUs by the number of network credentials tried on them. */
+	uint32_t net_trials_hist[BT_MESH_STATS_TRIALS];
+	/** Buffers allocated for received data. */
+	uint32_t rx_alloc;
+	/** Copies of received data. */
+	uint32_t rx_copy;
+	/** Bytes of received data copied. */
+	uint32_t rx_copy_bytes;
+	/** Advertising queue by class, see @ref BT_MESH_STATS_ADV_CLASSES. */
+	struct bt_mesh_stats_adv adv[BT_MESH_STATS_ADV_CLASSES];
+};
+
+/** @typedef bt_mesh_stats_trace_t
+ *  @brief Statistics tracing hook.
+ *
+ *  Called for every counted event, in the context the event happened in, so
+ *  it must not block.
+ *
+ *  @param evt Event.
+ *  @param val Value of the event, see @ref bt_mesh_stats_evt.
+ */
+typedef void (*bt_mesh_stats_trace_t)(enum bt_mesh_stats_evt evt,
+				      uint32_t val);
+
+#if defined(CONFIG_BT_MESH_STATS) || defined(__DOXYGEN__)
+/** @brief Take a snapshot of the mesh statistics.
+ *
+ *  Without @option{CONFIG_BT_MESH_STATS} the snapshot is all zeros.
+ *
+ *  @param stats Snapshot return buffer.
+ */
+void bt_mesh_stats_get(struct bt_mesh_stats *stats);
+
+/** @brief Clear the "bt_mesh" statistics group. */
+void bt_mesh_stats_reset(void);
+
+/** @brief Set the statistics tracing hook.
+ *
+ *  @param trace Tracing hook, or NULL to remove it.
+ */
+void bt_mesh_stats_trace_set(bt_mesh_stats_trace_t trace);
+#else
+static inline void bt_mesh_stats_get(struct bt_mesh_stats *stats)
+{
+	*stats = (struct bt_mesh_stats){ 0 };
+}
+
+static inline void bt_mesh_stats_reset(void)
+{
+}
+
+static inline void bt_mesh_stats_trace_set(bt_mesh_stats_trace_t trace)
+{
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+/**
+ * @}
+ */
+
+#endif /* ZEPHYR_INCLUDE_BLUETOOTH_MESH_STATS_H_ */
@@ -119,6 +119,20 @@ int cfb_framebuffer_invert(const struct device *dev);
  */
 int cfb_framebuffer_finalize(const struct device *dev);
 
+/**
+ * @brief Finalize a horizontal band of the framebuffer and write only
+ * that band to display RAM, invert pixels if necessary.
+ *
+ * @param dev Pointer to device structure for driver instance
+ * @param y Position in Y direction of the first line of the band,
+ *          must be a multiple of the tile height
+ * @param height Height of the band, must be a multiple of the tile height
+ *
+ * @return 0 on success, negative value otherwise
+ */
+int cfb_framebuffer_finalize_area(const struct device *dev, uint16_t y,
+				  uint16_t height);
+
 /**
  * @brief Get display parameter.
  *
@@ -4,6 +4,10 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <string.h>
+
+#include <bluetooth/crypto.h>
+
 #define BT_DBG_ENABLED IS_ENABLED(CONFIG_BT_DEBUG_HCI_DRIVER)
 #define LOG_MODULE_NAME bt_ctlr_crypto
 #include "common/log.h"
@@ -43,3 +47,19 @@ int bt_encrypt_be(const uint8_t key[16], const uint8_t plaintext[16],
 
 	return 0;
 }
+
+/* The ECB peripheral takes the plain key, nothing to expand */
+int bt_aes_key_set(struct bt_aes_key *aes_key, const uint8_t key[16])
+{
+	memcpy(aes_key->key, key, 16);
+
+	return 0;
+}
+
+int bt_encrypt_be_key(const struct bt_aes_key *key,
+		      const uint8_t plaintext[16], uint8_t enc_data[16])
+{
+	ecb_encrypt_be(key->key, plaintext, enc_data);
+
+	return 0;
+}
@@ -36,8 +36,8 @@ static inline void xor16(uint8_t *dst, const uint8_t *a, const uint8_t *b)
 }
 
 /* pmsg is assumed to have the nonce already present in bytes 1-13 */
-static int ccm_calculate_X0(const uint8_t key[16], const uint8_t *aad, uint8_t aad_len,
-			    size_t mic_size, uint8_t msg_len, uint8_t b[16],
+static int ccm_calculate_X0(const struct bt_aes_key *key, const uint8_t *aad,
+			    uint8_t aad_len, size_t mic_size, uint8_t msg_len, uint8_t b[16],
 			    uint8_t X0[16])
 {
 	int i, j, err;
@@ -47,7 +47,7 @@ static int ccm_calculate_X0(const uint8_t key[16], const uint8_t *aad, uint8_t a
 
 	sys_put_be16(msg_len, b + 14);
 
-	err = bt_encrypt_be(key, b, X0);
+	err = bt_encrypt_be_key(key, b, X0);
 	if (err) {
 		return err;
 	}
@@ -71,7 +71,7 @@ static int ccm_calculate_X0(const uint8_t key[16], const uint8_t *aad, uint8_t a
 			aad_len -= 16;
 			i = 0;
 
-			err = bt_encrypt_be(key, b, X0);
+			err = bt_encrypt_be_key(key, b, X0);
 			if (err) {
 				return err;
 			}
@@ -85,7 +85,7 @@ static int ccm_calculate_X0(const uint8_t key[16], const uint8_t *aad, uint8_t a
 			b[i] = X0[i];
 		}
 
-		err = bt_encrypt_be(key, b, X0);
+		err = bt_encrypt_be_key(key, b, X0);
 		if (err) {
 			return err;
 		}
@@ -94,7 +94,7 @@ static int ccm_calculate_X0(const uint8_t key[16], const uint8_t *aad, uint8_t a
 	return 0;
 }
 
-static int ccm_auth(const uint8_t key[16], uint8_t nonce[13],
+static int ccm_auth(const struct bt_aes_key *key, uint8_t nonce[13],
 		    const uint8_t *cleartext_msg, size_t msg_len, const uint8_t *aad,
 		    size_t aad_len, uint8_t *mic, size_t mic_size)
 {
@@ -114,7 +114,7 @@ static int ccm_auth(const uint8_t key[16], uint8_t nonce[13],
 	/* S[0] = e(AppKey, 0x01 || nonce || 0x0000) */
 	sys_put_be16(0x0000, &b[14]);
 
-	err = bt_encrypt_be(key, b, s0);
+	err = bt_encrypt_be_key(key, b, s0);
 	if (err) {
 		return err;
 	}
@@ -133,7 +133,7 @@ static int ccm_auth(const uint8_t key[16], uint8_t nonce[13],
 			xor16(b, Xn, &cleartext_msg[j * 16]);
 		}
 
-		err = bt_encrypt_be(key, b, Xn);
+		err = bt_encrypt_be_key(key, b, Xn);
 		if (err) {
 			return err;
 		}
@@ -147,7 +147,7 @@ static int ccm_auth(const uint8_t key[16], uint8_t nonce[13],
 	return 0;
 }
 
-static int ccm_crypt(const uint8_t key[16], const uint8_t nonce[13],
+static int ccm_crypt(const struct bt_aes_key *key, const uint8_t nonce[13],
 		     const uint8_t *in_msg, uint8_t *out_msg, size_t msg_len)
 {
 	uint8_t a_i[16], s_i[16];
@@ -168,7 +168,7 @@ static int ccm_crypt(const uint8_t key[16], const uint8_t nonce[13],
 		/* S_1 = e(AppKey, 0x01 || nonce || 0x0001) */
 		sys_put_be16(j + 1, &a_i[14]);
 
-		err = bt_encrypt_be(key, a_i, s_i);
+		err = bt_encrypt_be_key(key, a_i, s_i);
 		if (err) {
 			return err;
 		}
@@ -186,9 +186,9 @@ static int ccm_crypt(const uint8_t key[16], const uint8_t nonce[13],
 	return 0;
 }
 
-int bt_ccm_decrypt(const uint8_t key[16], uint8_t nonce[13], const uint8_t *enc_msg,
-		   size_t msg_len, const uint8_t *aad, size_t aad_len,
-		   uint8_t *out_msg, size_t mic_size)
+int bt_ccm_decrypt_key(const struct bt_aes_key *key, uint8_t nonce[13],
+		       const uint8_t *enc_msg, size_t msg_len, const uint8_t *aad,
+		       size_t aad_len, uint8_t *out_msg, size_t mic_size)
 {
 	uint8_t mic[16];
 
@@ -207,13 +207,12 @@ int bt_ccm_decrypt(const uint8_t key[16], uint8_t nonce[13], const uint8_t *enc_
 	return 0;
 }
 
-int bt_ccm_encrypt(const uint8_t key[16], uint8_t nonce[13], const uint8_t *msg,
-		   size_t msg_len, const uint8_t *aad, size_t aad_len,
-		   uint8_t *out_msg, size_t mic_size)
+int bt_ccm_encrypt_key(const struct bt_aes_key *key, uint8_t nonce[13],
+		       const uint8_t *msg, size_t msg_len, const uint8_t *aad,
+		       size_t aad_len, uint8_t *out_msg, size_t mic_size)
 {
 	uint8_t *mic = out_msg + msg_len;
 
-	BT_DBG("key %s", bt_hex(key, 16));
 	BT_DBG("nonce %s", bt_hex(nonce, 13));
 	BT_DBG("msg (len %zu) %s", msg_len, bt_hex(msg, msg_len));
 	BT_DBG("aad_len %zu mic_size %zu", aad_len, mic_size);
@@ -229,3 +228,37 @@ int bt_ccm_encrypt(const uint8_t key[16], uint8_t nonce[13], const uint8_t *msg,
 
 	return 0;
 }
+
+int bt_ccm_decrypt(const uint8_t key[16], uint8_t nonce[13], const uint8_t *enc_msg,
+		   size_t msg_len, const uint8_t *aad, size_t aad_len,
+		   uint8_t *out_msg, size_t mic_size)
+{
+	struct bt_aes_key aes_key;
+	int err;
+
+	err = bt_aes_key_set(&aes_key, key);
+	if (err) {
+		return err;
+	}
+
+	return bt_ccm_decrypt_key(&aes_key, nonce, enc_msg, msg_len, aad,
+				  aad_len, out_msg, mic_size);
+}
+
+int bt_ccm_encrypt(const uint8_t key[16], uint8_t nonce[13], const uint8_t *msg,
+		   size_t msg_len, const uint8_t *aad, size_t aad_len,
+		   uint8_t *out_msg, size_t mic_size)
+{
+	struct bt_aes_key aes_key;
+	int err;
+
+	BT_DBG("key %s", bt_hex(key, 16));
+
+	err = bt_aes_key_set(&aes_key, key);
+	if (err) {
+		return err;
+	}
+
+	return bt_ccm_encrypt_key(&aes_key, nonce, msg, msg_len, aad, aad_len,
+				  out_msg, mic_size);
+}
@@ -163,3 +163,27 @@ int bt_encrypt_be(const uint8_t key[16], const uint8_t plaintext[16],
 
 	return 0;
 }
+
+BUILD_ASSERT(sizeof(struct bt_aes_key) ==
+	     sizeof(struct tc_aes_key_sched_struct));
+
+int bt_aes_key_set(struct bt_aes_key *aes_key, const uint8_t key[16])
+{
+	if (tc_aes128_set_encrypt_key((TCAesKeySched_t)aes_key->sched,
+				      key) == TC_CRYPTO_FAIL) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int bt_encrypt_be_key(const struct bt_aes_key *key,
+		      const uint8_t plaintext[16], uint8_t enc_data[16])
+{
+	if (tc_aes_encrypt(enc_data, plaintext,
+			   (TCAesKeySched_t)key->sched) == TC_CRYPTO_FAIL) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
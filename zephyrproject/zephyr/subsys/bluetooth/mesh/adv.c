@@ -27,6 +27,7 @@
 #include "beacon.h"
 #include "prov.h"
 #include "proxy.h"
+#include "stats.h"
 
 /* Window and Interval are equal for continuous scanning */
 #define MESH_SCAN_INTERVAL    BT_MESH_ADV_SCAN_UNIT(BT_MESH_SCAN_INTERVAL_MS)
@@ -39,10 +40,56 @@ const uint8_t bt_mesh_adv_type[BT_MESH_ADV_TYPES] = {
 	[BT_MESH_ADV_URI]    = BT_DATA_URI,
 };
 
-K_FIFO_DEFINE(bt_mesh_adv_queue);
+static K_FIFO_DEFINE(ack_queue);
+static K_FIFO_DEFINE(friend_queue);
+static K_FIFO_DEFINE(prov_queue);
+static K_FIFO_DEFINE(relay_queue);
+static K_FIFO_DEFINE(local_queue);
+static K_FIFO_DEFINE(beacon_queue);
+
+static struct k_fifo *const adv_queues[BT_MESH_ADV_TAGS] = {
+	[BT_MESH_ACK_ADV]      = &ack_queue,
+	[BT_MESH_FRIEND_ADV]   = &friend_queue,
+	[BT_MESH_PROV_PDU_ADV] = &prov_queue,
+	[BT_MESH_RELAY_ADV]    = &relay_queue,
+	[BT_MESH_LOCAL_ADV]    = &local_queue,
+	[BT_MESH_BEACON_ADV]   = &beacon_queue,
+};
+
+/* Buffer quotas of the classes that may take over the buffer pool */
+static K_SEM_DEFINE(relay_quota, CONFIG_BT_MESH_ADV_RELAY_BUF_QUOTA,
+		    CONFIG_BT_MESH_ADV_RELAY_BUF_QUOTA);
+static K_SEM_DEFINE(local_quota, CONFIG_BT_MESH_ADV_LOCAL_BUF_QUOTA,
+		    CONFIG_BT_MESH_ADV_LOCAL_BUF_QUOTA);
+static K_SEM_DEFINE(beacon_quota, CONFIG_BT_MESH_ADV_BEACON_BUF_QUOTA,
+		    CONFIG_BT_MESH_ADV_BEACON_BUF_QUOTA);
+
+static struct k_sem *const adv_quotas[BT_MESH_ADV_TAGS] = {
+	[BT_MESH_RELAY_ADV]  = &relay_quota,
+	[BT_MESH_LOCAL_ADV]  = &local_quota,
+	[BT_MESH_BEACON_ADV] = &beacon_quota,
+};
+
+#if defined(CONFIG_BT_MESH_ADV_SCHED_WEIGHTED)
+/* The classes before the relayed messages are always served first, the
+ * others get a number of buffers sent in turn.
+ */
+static const uint8_t adv_weights[BT_MESH_ADV_TAGS] = {
+	[BT_MESH_RELAY_ADV]  = CONFIG_BT_MESH_ADV_RELAY_WEIGHT,
+	[BT_MESH_LOCAL_ADV]  = CONFIG_BT_MESH_ADV_LOCAL_WEIGHT,
+	[BT_MESH_BEACON_ADV] = 1,
+};
+
+static uint8_t adv_credits[BT_MESH_ADV_TAGS];
+#endif
+
+static struct bt_mesh_adv_stats adv_stats[BT_MESH_ADV_TAGS];
+
+static void adv_buf_destroy(struct net_buf *buf);
 
 NET_BUF_POOL_DEFINE(adv_buf_pool, CONFIG_BT_MESH_ADV_BUF_COUNT,
-		    BT_MESH_ADV_DATA_SIZE, BT_MESH_ADV_USER_DATA_SIZE, NULL);
+		    BT_MESH_ADV_DATA_SIZE, BT_MESH_ADV_USER_DATA_SIZE,
+		    adv_buf_destroy);
 
 static struct bt_mesh_adv adv_pool[CONFIG_BT_MESH_ADV_BUF_COUNT];
 
@@ -51,9 +98,21 @@ static struct bt_mesh_adv *adv_alloc(int id)
 	return &adv_pool[id];
 }
 
+static void adv_buf_destroy(struct net_buf *buf)
+{
+	struct k_sem *quota = adv_quotas[BT_MESH_ADV(buf)->tag];
+
+	if (quota) {
+		k_sem_give(quota);
+	}
+
+	net_buf_destroy(buf);
+}
+
 struct net_buf *bt_mesh_adv_create_from_pool(struct net_buf_pool *pool,
 					     bt_mesh_adv_alloc_t get_id,
 					     enum bt_mesh_adv_type type,
+					     enum bt_mesh_adv_tag tag,
 					     uint8_t xmit, k_timeout_t timeout)
 {
 	struct bt_mesh_adv *adv;
@@ -75,30 +134,205 @@ struct net_buf *bt_mesh_adv_create_from_pool(struct net_buf_pool *pool,
 	(void)memset(adv, 0, sizeof(*adv));
 
 	adv->type         = type;
+	adv->tag          = tag;
 	adv->xmit         = xmit;
 
 	return buf;
 }
 
-struct net_buf *bt_mesh_adv_create(enum bt_mesh_adv_type type, uint8_t xmit,
-				   k_timeout_t timeout)
+struct net_buf *bt_mesh_adv_create(enum bt_mesh_adv_type type,
+				   enum bt_mesh_adv_tag tag,
+				   uint8_t xmit, k_timeout_t timeout)
 {
-	return bt_mesh_adv_create_from_pool(&adv_buf_pool, adv_alloc, type,
-					    xmit, timeout);
+	struct k_sem *quota = adv_quotas[tag];
+	uint64_t end = z_timeout_end_calc(timeout);
+	struct net_buf *buf;
+
+	if (quota && k_sem_take(quota, timeout)) {
+		BT_DBG("Buffer quota of class %u used up", tag);
+		adv_stats[tag].no_quota++;
+		return NULL;
+	}
+
+	/* The pool gets what is left of the caller's timeout */
+	if (quota && !K_TIMEOUT_EQ(timeout, K_NO_WAIT) &&
+	    !K_TIMEOUT_EQ(timeout, K_FOREVER)) {
+		int64_t remaining = end - z_tick_get();
+
+		if (remaining <= 0) {
+			timeout = K_NO_WAIT;
+		} else {
+			timeout = Z_TIMEOUT_TICKS(remaining);
+		}
+	}
+
+	buf = bt_mesh_adv_create_from_pool(&adv_buf_pool, adv_alloc, type,
+					   tag, xmit, timeout);
+	if (!buf && quota) {
+		k_sem_give(quota);
+	}
+
+	return buf;
 }
 
 void bt_mesh_adv_send(struct net_buf *buf, const struct bt_mesh_send_cb *cb,
 		      void *cb_data)
 {
+	struct bt_mesh_adv_stats *stats = &adv_stats[BT_MESH_ADV(buf)->tag];
+	unsigned int key;
+
 	BT_DBG("type 0x%02x len %u: %s", BT_MESH_ADV(buf)->type, buf->len,
 	       bt_hex(buf->data, buf->len));
 
 	BT_MESH_ADV(buf)->cb = cb;
 	BT_MESH_ADV(buf)->cb_data = cb_data;
 	BT_MESH_ADV(buf)->busy = 1U;
+	BT_MESH_ADV(buf)->queued = k_uptime_get_32();
+
+	key = irq_lock();
+	stats->depth++;
+	stats->max_depth = MAX(stats->max_depth, stats->depth);
+	irq_unlock(key);
+
+	bt_mesh_stats_evt(BT_MESH_STATS_ADV_QUEUED, BT_MESH_ADV(buf)->tag);
+
+	net_buf_put(adv_queues[BT_MESH_ADV(buf)->tag], net_buf_ref(buf));
+	bt_mesh_adv_buf_ready(BT_MESH_ADV(buf)->tag);
+}
+
+/* Pick the class to send from next out of the ones with queued buffers */
+static int adv_class_next(uint8_t pending)
+{
+	int i;
+
+#if defined(CONFIG_BT_MESH_ADV_SCHED_WEIGHTED)
+	for (i = 0; i < BT_MESH_RELAY_ADV; i++) {
+		if (pending & BIT(i)) {
+			return i;
+		}
+	}
+
+	for (i = BT_MESH_RELAY_ADV; i < BT_MESH_ADV_TAGS; i++) {
+		if ((pending & BIT(i)) && adv_credits[i]) {
+			return i;
+		}
+	}
+
+	/* All pending classes had their turn, start the next round */
+	for (i = BT_MESH_RELAY_ADV; i < BT_MESH_ADV_TAGS; i++) {
+		adv_credits[i] = adv_weights[i];
+	}
+#endif
+
+	for (i = 0; i < BT_MESH_ADV_TAGS; i++) {
+		if (pending & BIT(i)) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static uint8_t adv_pending(uint8_t tags)
+{
+	uint8_t pending = 0U;
+	int i;
+
+	for (i = 0; i < BT_MESH_ADV_TAGS; i++) {
+		if ((tags & BIT(i)) && !k_fifo_is_empty(adv_queues[i])) {
+			pending |= BIT(i);
+		}
+	}
+
+	return pending;
+}
+
+struct net_buf *bt_mesh_adv_buf_get(uint8_t tags)
+{
+	struct bt_mesh_adv_stats *stats;
+	struct net_buf *buf;
+	uint32_t wait;
+	unsigned int key;
+	int i;
+
+	while ((i = adv_class_next(adv_pending(tags))) >= 0) {
+		buf = net_buf_get(adv_queues[i], K_NO_WAIT);
+		if (!buf) {
+			continue;
+		}
+
+		stats = &adv_stats[i];
+
+		key = irq_lock();
+		stats->depth--;
+		irq_unlock(key);
+
+		/* busy == 0 means this was canceled */
+		if (!BT_MESH_ADV(buf)->busy) {
+			stats->canceled++;
+			bt_mesh_stats_evt(BT_MESH_STATS_ADV_CANCELED, i);
+			net_buf_unref(buf);
+			continue;
+		}
+
+		BT_MESH_ADV(buf)->busy = 0U;
+
+		wait = k_uptime_get_32() - BT_MESH_ADV(buf)->queued;
+		stats->sent++;
+		stats->wait_ms += wait;
+		stats->max_wait_ms = MAX(stats->max_wait_ms, wait);
+		bt_mesh_stats_evt(BT_MESH_STATS_ADV_SENT, wait);
+
+#if defined(CONFIG_BT_MESH_ADV_SCHED_WEIGHTED)
+		if (adv_credits[i]) {
+			adv_credits[i]--;
+		}
+#endif
+
+		return buf;
+	}
+
+	return NULL;
+}
+
+struct net_buf *bt_mesh_adv_buf_get_wait(k_timeout_t timeout)
+{
+	struct k_poll_event events[BT_MESH_ADV_TAGS];
+	struct net_buf *buf;
+	int i;
+
+	buf = bt_mesh_adv_buf_get(BT_MESH_ADV_TAG_ALL);
+	if (buf || K_TIMEOUT_EQ(timeout, K_NO_WAIT)) {
+		return buf;
+	}
+
+	for (i = 0; i < BT_MESH_ADV_TAGS; i++) {
+		k_poll_event_init(&events[i], K_POLL_TYPE_FIFO_DATA_AVAILABLE,
+				  K_POLL_MODE_NOTIFY_ONLY, adv_queues[i]);
+	}
+
+	(void)k_poll(events, ARRAY_SIZE(events), timeout);
+
+	return bt_mesh_adv_buf_get(BT_MESH_ADV_TAG_ALL);
+}
+
+void bt_mesh_adv_buf_get_cancel(void)
+{
+	k_fifo_cancel_wait(&local_queue);
+}
+
+bool bt_mesh_adv_buf_pending(uint8_t tags)
+{
+	return adv_pending(tags) != 0U;
+}
+
+void bt_mesh_adv_stats_get(enum bt_mesh_adv_tag tag,
+			   struct bt_mesh_adv_stats *stats)
+{
+	unsigned int key = irq_lock();
 
-	net_buf_put(&bt_mesh_adv_queue, net_buf_ref(buf));
-	bt_mesh_adv_buf_ready();
+	*stats = adv_stats[tag];
+	irq_unlock(key);
 }
 
 static void bt_mesh_scan_cb(const bt_addr_le_t *addr, int8_t rssi,
@@ -133,6 +367,7 @@ static void bt_mesh_scan_cb(const bt_addr_le_t *addr, int8_t rssi,
 
 		switch (type) {
 		case BT_DATA_MESH_MESSAGE:
+			bt_mesh_stats_evt(BT_MESH_STATS_ADV_HEARD, 0);
 			bt_mesh_net_recv(buf, rssi, BT_MESH_NET_IF_ADV);
 			break;
 #if defined(CONFIG_BT_MESH_PB_ADV)
@@ -27,6 +27,22 @@ enum bt_mesh_adv_type {
 	BT_MESH_ADV_TYPES,
 };
 
+/* Class of an advertising buffer, each one has its own queue. The queues
+ * are served in this order of priority.
+ */
+enum bt_mesh_adv_tag {
+	BT_MESH_ACK_ADV,      /* Segment Acknowledgments */
+	BT_MESH_FRIEND_ADV,   /* Friend Poll responses */
+	BT_MESH_PROV_PDU_ADV, /* Provisioning PDUs */
+	BT_MESH_RELAY_ADV,    /* Relayed messages */
+	BT_MESH_LOCAL_ADV,    /* Other locally originated messages */
+	BT_MESH_BEACON_ADV,   /* Secure Network and Unprovisioned beacons */
+
+	BT_MESH_ADV_TAGS,
+};
+
+#define BT_MESH_ADV_TAG_ALL BIT_MASK(BT_MESH_ADV_TAGS)
+
 typedef void (*bt_mesh_adv_func_t)(struct net_buf *buf, uint16_t duration,
 				   int err, void *user_data);
 
@@ -35,26 +51,54 @@ struct bt_mesh_adv {
 	void *cb_data;
 
 	uint8_t      type:2,
+		  tag:3,
 		  busy:1;
 	uint8_t      xmit;
+	uint32_t     queued;  /* Uptime when queued for sending */
 };
 
-typedef struct bt_mesh_adv *(*bt_mesh_adv_alloc_t)(int id);
+struct bt_mesh_adv_stats {
+	uint32_t sent;         /* Buffers taken for sending */
+	uint32_t canceled;     /* Buffers canceled while queued */
+	uint32_t no_quota;     /* Allocations failed on the buffer quota */
+	uint16_t depth;        /* Buffers in the queue */
+	uint16_t max_depth;    /* Most buffers in the queue */
+	uint32_t wait_ms;      /* Total time waited in the queue */
+	uint32_t max_wait_ms;  /* Longest time waited in the queue */
+};
 
-extern struct k_fifo bt_mesh_adv_queue;
+typedef struct bt_mesh_adv *(*bt_mesh_adv_alloc_t)(int id);
 
 /* Lookup table for Advertising data types for bt_mesh_adv_type: */
 extern const uint8_t bt_mesh_adv_type[BT_MESH_ADV_TYPES];
 
 /* xmit_count: Number of retransmissions, i.e. 0 == 1 transmission */
-struct net_buf *bt_mesh_adv_create(enum bt_mesh_adv_type type, uint8_t xmit,
-				   k_timeout_t timeout);
+struct net_buf *bt_mesh_adv_create(enum bt_mesh_adv_type type,
+				   enum bt_mesh_adv_tag tag,
+				   uint8_t xmit, k_timeout_t timeout);
 
 struct net_buf *bt_mesh_adv_create_from_pool(struct net_buf_pool *pool,
 					     bt_mesh_adv_alloc_t get_id,
 					     enum bt_mesh_adv_type type,
+					     enum bt_mesh_adv_tag tag,
 					     uint8_t xmit, k_timeout_t timeout);
 
+/* Get the next buffer to send with one of the given tags, skipping the
+ * canceled ones.
+ */
+struct net_buf *bt_mesh_adv_buf_get(uint8_t tags);
+
+/* Wait for the next buffer to send with any tag */
+struct net_buf *bt_mesh_adv_buf_get_wait(k_timeout_t timeout);
+
+/* Make bt_mesh_adv_buf_get_wait() return early */
+void bt_mesh_adv_buf_get_cancel(void);
+
+bool bt_mesh_adv_buf_pending(uint8_t tags);
+
+void bt_mesh_adv_stats_get(enum bt_mesh_adv_tag tag,
+			   struct bt_mesh_adv_stats *stats);
+
 void bt_mesh_adv_send(struct net_buf *buf, const struct bt_mesh_send_cb *cb,
 		      void *cb_data);
 
@@ -68,7 +112,7 @@ int bt_mesh_scan_disable(void);
 
 int bt_mesh_adv_enable(void);
 
-void bt_mesh_adv_buf_ready(void);
+void bt_mesh_adv_buf_ready(enum bt_mesh_adv_tag tag);
 
 int bt_mesh_adv_start(const struct bt_le_adv_param *param, int32_t duration,
 		      const struct bt_data *ad, size_t ad_len,
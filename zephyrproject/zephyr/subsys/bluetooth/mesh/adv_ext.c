@@ -27,14 +27,8 @@
 /* Convert from ms to 0.625ms units */
 #define ADV_INT_FAST_MS    20
 
-static struct bt_le_adv_param adv_param = {
-	.id = BT_ID_DEFAULT,
-	.interval_min = BT_MESH_ADV_SCAN_UNIT(ADV_INT_FAST_MS),
-	.interval_max = BT_MESH_ADV_SCAN_UNIT(ADV_INT_FAST_MS),
-#if defined(CONFIG_BT_MESH_DEBUG_USE_ID_ADDR)
-	.options = BT_LE_ADV_OPT_USE_IDENTITY,
-#endif
-};
+/* Buffers sent on the relay sets */
+#define ADV_TAGS_RELAY     (BIT(BT_MESH_FRIEND_ADV) | BIT(BT_MESH_RELAY_ADV))
 
 enum {
 	/** Controller is currently advertising */
@@ -52,63 +46,70 @@ enum {
 	ADV_FLAGS_NUM
 };
 
-static struct {
+/* Advertising set, the first one also does the proxy advertising */
+struct ext_adv {
+	/* Tags of the buffers sent with this set */
+	uint8_t tags;
 	ATOMIC_DEFINE(flags, ADV_FLAGS_NUM);
 	struct bt_le_ext_adv *instance;
+	struct bt_le_adv_param adv_param;
 	const struct bt_mesh_send_cb *cb;
 	void *cb_data;
 	uint64_t timestamp;
 	struct k_delayed_work work;
-} adv;
+};
+
+static struct ext_adv adv_sets[CONFIG_BT_MESH_ADV_EXT_SETS];
 
-static int adv_start(const struct bt_le_adv_param *param,
+static int adv_start(struct ext_adv *adv,
+		     const struct bt_le_adv_param *param,
 		     struct bt_le_ext_adv_start_param *start,
 		     const struct bt_data *ad, size_t ad_len,
 		     const struct bt_data *sd, size_t sd_len)
 {
 	int err;
 
-	if (!adv.instance) {
+	if (!adv->instance) {
 		BT_ERR("Mesh advertiser not enabled");
 		return -ENODEV;
 	}
 
-	if (atomic_test_and_set_bit(adv.flags, ADV_FLAG_ACTIVE)) {
+	if (atomic_test_and_set_bit(adv->flags, ADV_FLAG_ACTIVE)) {
 		BT_ERR("Advertiser is busy");
 		return -EBUSY;
 	}
 
-	if (atomic_test_bit(adv.flags, ADV_FLAG_UPDATE_PARAMS)) {
-		err = bt_le_ext_adv_update_param(adv.instance, param);
+	if (atomic_test_bit(adv->flags, ADV_FLAG_UPDATE_PARAMS)) {
+		err = bt_le_ext_adv_update_param(adv->instance, param);
 		if (err) {
 			BT_ERR("Failed updating adv params: %d", err);
-			atomic_clear_bit(adv.flags, ADV_FLAG_ACTIVE);
+			atomic_clear_bit(adv->flags, ADV_FLAG_ACTIVE);
 			return err;
 		}
 
-		atomic_set_bit_to(adv.flags, ADV_FLAG_UPDATE_PARAMS,
-				  param != &adv_param);
+		atomic_set_bit_to(adv->flags, ADV_FLAG_UPDATE_PARAMS,
+				  param != &adv->adv_param);
 	}
 
-	err = bt_le_ext_adv_set_data(adv.instance, ad, ad_len, sd, sd_len);
+	err = bt_le_ext_adv_set_data(adv->instance, ad, ad_len, sd, sd_len);
 	if (err) {
 		BT_ERR("Failed setting adv data: %d", err);
-		atomic_clear_bit(adv.flags, ADV_FLAG_ACTIVE);
+		atomic_clear_bit(adv->flags, ADV_FLAG_ACTIVE);
 		return err;
 	}
 
-	adv.timestamp = k_uptime_get();
+	adv->timestamp = k_uptime_get();
 
-	err = bt_le_ext_adv_start(adv.instance, start);
+	err = bt_le_ext_adv_start(adv->instance, start);
 	if (err) {
 		BT_ERR("Advertising failed: err %d", err);
-		atomic_clear_bit(adv.flags, ADV_FLAG_ACTIVE);
+		atomic_clear_bit(adv->flags, ADV_FLAG_ACTIVE);
 	}
 
 	return err;
 }
 
-static int buf_send(struct net_buf *buf)
+static int buf_send(struct ext_adv *adv, struct net_buf *buf)
 {
 	struct bt_le_ext_adv_start_param start = {
 		.num_events =
@@ -123,8 +124,8 @@ static int buf_send(struct net_buf *buf)
 	/* Upper boundary estimate: */
 	duration = start.num_events * (adv_int + 10);
 
-	BT_DBG("type %u len %u: %s", BT_MESH_ADV(buf)->type,
-	       buf->len, bt_hex(buf->data, buf->len));
+	BT_DBG("set %u type %u len %u: %s", (uint8_t)(adv - adv_sets),
+	       BT_MESH_ADV(buf)->type, buf->len, bt_hex(buf->data, buf->len));
 	BT_DBG("count %u interval %ums duration %ums",
 	       BT_MESH_TRANSMIT_COUNT(BT_MESH_ADV(buf)->xmit) + 1, adv_int,
 	       duration);
@@ -134,65 +135,59 @@ static int buf_send(struct net_buf *buf)
 	ad.data = buf->data;
 
 	/* Only update advertising parameters if they're different */
-	if (adv_param.interval_min != BT_MESH_ADV_SCAN_UNIT(adv_int)) {
-		adv_param.interval_min = BT_MESH_ADV_SCAN_UNIT(adv_int);
-		adv_param.interval_max = adv_param.interval_min;
-		atomic_set_bit(adv.flags, ADV_FLAG_UPDATE_PARAMS);
+	if (adv->adv_param.interval_min != BT_MESH_ADV_SCAN_UNIT(adv_int)) {
+		adv->adv_param.interval_min = BT_MESH_ADV_SCAN_UNIT(adv_int);
+		adv->adv_param.interval_max = adv->adv_param.interval_min;
+		atomic_set_bit(adv->flags, ADV_FLAG_UPDATE_PARAMS);
 	}
 
-	adv.cb = BT_MESH_ADV(buf)->cb;
-	adv.cb_data = BT_MESH_ADV(buf)->cb_data;
+	adv->cb = BT_MESH_ADV(buf)->cb;
+	adv->cb_data = BT_MESH_ADV(buf)->cb_data;
 
-	err = adv_start(&adv_param, &start, &ad, 1, NULL, 0);
+	err = adv_start(adv, &adv->adv_param, &start, &ad, 1, NULL, 0);
 	net_buf_unref(buf);
-	bt_mesh_adv_send_start(duration, err, adv.cb, adv.cb_data);
+	bt_mesh_adv_send_start(duration, err, adv->cb, adv->cb_data);
 
 	return err;
 }
 
 static void send_pending_adv(struct k_work *work)
 {
+	struct ext_adv *adv = CONTAINER_OF(work, struct ext_adv, work);
 	struct net_buf *buf;
 	int err;
 
-	atomic_clear_bit(adv.flags, ADV_FLAG_SCHEDULED);
-
-	while ((buf = net_buf_get(&bt_mesh_adv_queue, K_NO_WAIT))) {
-		/* busy == 0 means this was canceled */
-		if (!BT_MESH_ADV(buf)->busy) {
-			net_buf_unref(buf);
-			continue;
-		}
+	atomic_clear_bit(adv->flags, ADV_FLAG_SCHEDULED);
 
-		BT_MESH_ADV(buf)->busy = 0U;
-		err = buf_send(buf);
+	while ((buf = bt_mesh_adv_buf_get(adv->tags))) {
+		err = buf_send(adv, buf);
 		if (!err) {
 			return; /* Wait for advertising to finish */
 		}
 	}
 
 	/* No more pending buffers */
-	if (IS_ENABLED(CONFIG_BT_MESH_PROXY)) {
+	if (IS_ENABLED(CONFIG_BT_MESH_PROXY) && adv == &adv_sets[0]) {
 		BT_DBG("Proxy Advertising");
 		err = bt_mesh_proxy_adv_start();
 		if (!err) {
-			atomic_set_bit(adv.flags, ADV_FLAG_PROXY);
+			atomic_set_bit(adv->flags, ADV_FLAG_PROXY);
 		}
 	}
 }
 
-static void schedule_send(void)
+static void schedule_send(struct ext_adv *adv)
 {
-	uint64_t timestamp = adv.timestamp;
+	uint64_t timestamp = adv->timestamp;
 	int64_t delta;
 
-	if (atomic_test_and_clear_bit(adv.flags, ADV_FLAG_PROXY)) {
-		bt_le_ext_adv_stop(adv.instance);
-		atomic_clear_bit(adv.flags, ADV_FLAG_ACTIVE);
+	if (atomic_test_and_clear_bit(adv->flags, ADV_FLAG_PROXY)) {
+		bt_le_ext_adv_stop(adv->instance);
+		atomic_clear_bit(adv->flags, ADV_FLAG_ACTIVE);
 	}
 
-	if (atomic_test_bit(adv.flags, ADV_FLAG_ACTIVE) ||
-	    atomic_test_and_set_bit(adv.flags, ADV_FLAG_SCHEDULED)) {
+	if (atomic_test_bit(adv->flags, ADV_FLAG_ACTIVE) ||
+	    atomic_test_and_set_bit(adv->flags, ADV_FLAG_SCHEDULED)) {
 		return;
 	}
 
@@ -201,52 +196,126 @@ static void schedule_send(void)
 	 * to the previous packet than what's permitted by the specification.
 	 */
 	delta = k_uptime_delta(&timestamp);
-	k_delayed_work_submit(&adv.work, K_MSEC(ADV_INT_FAST_MS - delta));
+	k_delayed_work_submit(&adv->work, K_MSEC(ADV_INT_FAST_MS - delta));
 }
 
 void bt_mesh_adv_update(void)
 {
 	BT_DBG("");
 
-	schedule_send();
+	schedule_send(&adv_sets[0]);
 }
 
-void bt_mesh_adv_buf_ready(void)
+void bt_mesh_adv_buf_ready(enum bt_mesh_adv_tag tag)
 {
-	schedule_send();
+	struct ext_adv *proxy = NULL;
+	int i;
+
+	/* Prefer an idle set to one that first has to stop proxy advertising.
+	 * If all sets are busy, the first one to finish sends the buffer.
+	 */
+	for (i = ARRAY_SIZE(adv_sets) - 1; i >= 0; i--) {
+		struct ext_adv *adv = &adv_sets[i];
+
+		if (!(adv->tags & BIT(tag))) {
+			continue;
+		}
+
+		if (atomic_test_bit(adv->flags, ADV_FLAG_PROXY)) {
+			proxy = adv;
+		} else if (!atomic_test_bit(adv->flags, ADV_FLAG_ACTIVE) &&
+			   !atomic_test_bit(adv->flags, ADV_FLAG_SCHEDULED)) {
+			schedule_send(adv);
+			return;
+		}
+	}
+
+	if (proxy) {
+		schedule_send(proxy);
+	}
 }
 
 void bt_mesh_adv_init(void)
 {
-	k_delayed_work_init(&adv.work, send_pending_adv);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(adv_sets); i++) {
+		adv_sets[i].adv_param.id = BT_ID_DEFAULT;
+		adv_sets[i].adv_param.interval_min =
+			BT_MESH_ADV_SCAN_UNIT(ADV_INT_FAST_MS);
+		adv_sets[i].adv_param.interval_max =
+			BT_MESH_ADV_SCAN_UNIT(ADV_INT_FAST_MS);
+#if defined(CONFIG_BT_MESH_DEBUG_USE_ID_ADDR)
+		adv_sets[i].adv_param.options = BT_LE_ADV_OPT_USE_IDENTITY;
+#endif
+		k_delayed_work_init(&adv_sets[i].work, send_pending_adv);
+	}
+
+	/* The first set sends the local traffic, the others relay and
+	 * serve Friend Polls, so local messages do not queue behind them.
+	 */
+	if (ARRAY_SIZE(adv_sets) == 1) {
+		adv_sets[0].tags = BT_MESH_ADV_TAG_ALL;
+		return;
+	}
+
+	adv_sets[0].tags = BT_MESH_ADV_TAG_ALL & ~ADV_TAGS_RELAY;
+	for (i = 1; i < ARRAY_SIZE(adv_sets); i++) {
+		adv_sets[i].tags = ADV_TAGS_RELAY;
+	}
+}
+
+static struct ext_adv *adv_get(struct bt_le_ext_adv *instance)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(adv_sets); i++) {
+		if (adv_sets[i].instance == instance) {
+			return &adv_sets[i];
+		}
+	}
+
+	return NULL;
 }
 
 static void adv_sent(struct bt_le_ext_adv *instance,
 		     struct bt_le_ext_adv_sent_info *info)
 {
+	struct ext_adv *adv = adv_get(instance);
+	int64_t duration;
+
+	if (!adv) {
+		return;
+	}
+
 	/* Calling k_uptime_delta on a timestamp moves it to the current time.
 	 * This is essential here, as schedule_send() uses the end of the event
 	 * as a reference to avoid sending the next advertisement too soon.
 	 */
-	int64_t duration = k_uptime_delta(&adv.timestamp);
+	duration = k_uptime_delta(&adv->timestamp);
 
 	BT_DBG("Advertising stopped after %u ms", (uint32_t)duration);
 
-	atomic_clear_bit(adv.flags, ADV_FLAG_ACTIVE);
+	atomic_clear_bit(adv->flags, ADV_FLAG_ACTIVE);
 
-	if (!atomic_test_and_clear_bit(adv.flags, ADV_FLAG_PROXY)) {
-		bt_mesh_adv_send_end(0, adv.cb, adv.cb_data);
+	if (!atomic_test_and_clear_bit(adv->flags, ADV_FLAG_PROXY)) {
+		bt_mesh_adv_send_end(0, adv->cb, adv->cb_data);
 	}
 
-	schedule_send();
+	/* Only the first set keeps running to do proxy advertising */
+	if (adv == &adv_sets[0] || bt_mesh_adv_buf_pending(adv->tags)) {
+		schedule_send(adv);
+	}
 }
 
 static void connected(struct bt_le_ext_adv *instance,
 		      struct bt_le_ext_adv_connected_info *info)
 {
-	if (atomic_test_and_clear_bit(adv.flags, ADV_FLAG_PROXY)) {
-		atomic_clear_bit(adv.flags, ADV_FLAG_ACTIVE);
-		schedule_send();
+	struct ext_adv *adv = adv_get(instance);
+
+	if (adv && atomic_test_and_clear_bit(adv->flags, ADV_FLAG_PROXY)) {
+		atomic_clear_bit(adv->flags, ADV_FLAG_ACTIVE);
+		schedule_send(adv);
 	}
 }
 
@@ -256,13 +325,22 @@ int bt_mesh_adv_enable(void)
 		.sent = adv_sent,
 		.connected = connected,
 	};
+	int i, err;
 
-	if (adv.instance) {
-		/* Already initialized */
-		return 0;
+	for (i = 0; i < ARRAY_SIZE(adv_sets); i++) {
+		if (adv_sets[i].instance) {
+			/* Already initialized */
+			continue;
+		}
+
+		err = bt_le_ext_adv_create(&adv_sets[i].adv_param, &adv_cb,
+					   &adv_sets[i].instance);
+		if (err) {
+			return err;
+		}
 	}
 
-	return bt_le_ext_adv_create(&adv_param, &adv_cb, &adv.instance);
+	return 0;
 }
 
 int bt_mesh_adv_start(const struct bt_le_adv_param *param, int32_t duration,
@@ -276,7 +354,7 @@ int bt_mesh_adv_start(const struct bt_le_adv_param *param, int32_t duration,
 
 	BT_DBG("Start advertising %d ms", duration);
 
-	atomic_set_bit(adv.flags, ADV_FLAG_UPDATE_PARAMS);
+	atomic_set_bit(adv_sets[0].flags, ADV_FLAG_UPDATE_PARAMS);
 
-	return adv_start(param, &start, ad, ad_len, sd, sd_len);
+	return adv_start(&adv_sets[0], param, &start, ad, ad_len, sd, sd_len);
 }
@@ -111,7 +111,7 @@ static void adv_thread(void *p1, void *p2, void *p3)
 		struct net_buf *buf;
 
 		if (IS_ENABLED(CONFIG_BT_MESH_PROXY)) {
-			buf = net_buf_get(&bt_mesh_adv_queue, K_NO_WAIT);
+			buf = bt_mesh_adv_buf_get(BT_MESH_ADV_TAG_ALL);
 			while (!buf) {
 
 				/* Adv timeout may be set by a call from proxy
@@ -121,24 +121,16 @@ static void adv_thread(void *p1, void *p2, void *p3)
 				bt_mesh_proxy_adv_start();
 				BT_DBG("Proxy Advertising");
 
-				buf = net_buf_get(&bt_mesh_adv_queue,
-						  SYS_TIMEOUT_MS(adv_timeout));
+				buf = bt_mesh_adv_buf_get_wait(
+					SYS_TIMEOUT_MS(adv_timeout));
 				bt_le_adv_stop();
 			}
 		} else {
-			buf = net_buf_get(&bt_mesh_adv_queue, K_FOREVER);
+			buf = bt_mesh_adv_buf_get_wait(K_FOREVER);
 		}
 
-		if (!buf) {
-			continue;
-		}
-
-		/* busy == 0 means this was canceled */
-		if (BT_MESH_ADV(buf)->busy) {
-			BT_MESH_ADV(buf)->busy = 0U;
+		if (buf) {
 			adv_send(buf);
-		} else {
-			net_buf_unref(buf);
 		}
 
 		/* Give other threads a chance to run */
@@ -150,10 +142,10 @@ void bt_mesh_adv_update(void)
 {
 	BT_DBG("");
 
-	k_fifo_cancel_wait(&bt_mesh_adv_queue);
+	bt_mesh_adv_buf_get_cancel();
 }
 
-void bt_mesh_adv_buf_ready(void)
+void bt_mesh_adv_buf_ready(enum bt_mesh_adv_tag tag)
 {
 	/* Will be handled automatically */
 }
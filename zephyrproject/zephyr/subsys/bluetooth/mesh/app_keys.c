@@ -100,6 +100,25 @@ static void app_key_revoke(struct bt_mesh_app_key *app)
 	app_key_evt(app, BT_MESH_KEY_REVOKED);
 }
 
+static int app_cred_create(struct bt_mesh_app_cred *cred, const uint8_t key[16])
+{
+	int err;
+
+	err = bt_mesh_app_id(key, &cred->id);
+	if (err) {
+		return err;
+	}
+
+	err = bt_aes_key_set(&cred->aes, key);
+	if (err) {
+		return err;
+	}
+
+	memcpy(cred->val, key, 16);
+
+	return 0;
+}
+
 uint8_t bt_mesh_app_key_add(uint16_t app_idx, uint16_t net_idx,
 			const uint8_t key[16])
 {
@@ -129,7 +148,7 @@ uint8_t bt_mesh_app_key_add(uint16_t app_idx, uint16_t net_idx,
 		return STATUS_SUCCESS;
 	}
 
-	if (bt_mesh_app_id(key, &app->keys[0].id)) {
+	if (app_cred_create(&app->keys[0], key)) {
 		return STATUS_CANNOT_SET;
 	}
 
@@ -138,7 +157,6 @@ uint8_t bt_mesh_app_key_add(uint16_t app_idx, uint16_t net_idx,
 	app->net_idx = net_idx;
 	app->app_idx = app_idx;
 	app->updated = false;
-	memcpy(app->keys[0].val, key, 16);
 
 	if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
 		BT_DBG("Storing AppKey persistently");
@@ -202,14 +220,13 @@ uint8_t bt_mesh_app_key_update(uint16_t app_idx, uint16_t net_idx,
 		return STATUS_SUCCESS;
 	}
 
-	if (bt_mesh_app_id(key, &app->keys[1].id)) {
+	if (app_cred_create(&app->keys[1], key)) {
 		return STATUS_CANNOT_UPDATE;
 	}
 
 	BT_DBG("app_idx 0x%04x AID 0x%02x", app_idx, app->keys[1].id);
 
 	app->updated = true;
-	memcpy(app->keys[1].val, key, 16);
 
 	if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
 		BT_DBG("Storing AppKey persistently");
@@ -262,18 +279,14 @@ int bt_mesh_app_key_set(uint16_t app_idx, uint16_t net_idx,
 		return 0;
 	}
 
-	BT_DBG("AppIdx 0x%04x AID 0x%02x", app_idx, app->keys[0].id);
-
-	memcpy(app->keys[0].val, old_key, 16);
-	if (bt_mesh_app_id(old_key, &app->keys[0].id)) {
+	if (app_cred_create(&app->keys[0], old_key)) {
 		return -EIO;
 	}
 
-	if (new_key) {
-		memcpy(app->keys[1].val, new_key, 16);
-		if (bt_mesh_app_id(new_key, &app->keys[1].id)) {
-			return -EIO;
-		}
+	BT_DBG("AppIdx 0x%04x AID 0x%02x", app_idx, app->keys[0].id);
+
+	if (new_key && app_cred_create(&app->keys[1], new_key)) {
+		return -EIO;
 	}
 
 	app->net_idx = net_idx;
@@ -327,9 +340,11 @@ ssize_t bt_mesh_app_keys_get(uint16_t net_idx, uint16_t app_idxs[], size_t max,
 
 int bt_mesh_keys_resolve(struct bt_mesh_msg_ctx *ctx,
 			 struct bt_mesh_subnet **sub,
-			 const uint8_t *app_key[16], uint8_t *aid)
+			 const struct bt_aes_key **app_key, uint8_t *aid,
+			 struct bt_aes_key *dev_key)
 {
 	struct bt_mesh_app_key *app = NULL;
+	int err;
 
 	if (BT_MESH_IS_DEV_KEY(ctx->app_idx)) {
 		/* With device keys, the application has to decide which subnet
@@ -356,11 +371,16 @@ int bt_mesh_keys_resolve(struct bt_mesh_msg_ctx *ctx,
 				return -EINVAL;
 			}
 
-			*app_key = node->dev_key;
+			err = bt_aes_key_set(dev_key, node->dev_key);
 		} else {
-			*app_key = bt_mesh.dev_key;
+			err = bt_aes_key_set(dev_key, bt_mesh.dev_key);
 		}
 
+		if (err) {
+			return err;
+		}
+
+		*app_key = dev_key;
 		*aid = 0;
 		return 0;
 	}
@@ -379,10 +399,10 @@ int bt_mesh_keys_resolve(struct bt_mesh_msg_ctx *ctx,
 
 	if ((*sub)->kr_phase == BT_MESH_KR_PHASE_2 && app->updated) {
 		*aid = app->keys[1].id;
-		*app_key = app->keys[1].val;
+		*app_key = &app->keys[1].aes;
 	} else {
 		*aid = app->keys[0].id;
-		*app_key = app->keys[0].val;
+		*app_key = &app->keys[0].aes;
 	}
 
 	return 0;
@@ -391,12 +411,15 @@ int bt_mesh_keys_resolve(struct bt_mesh_msg_ctx *ctx,
 uint16_t bt_mesh_app_key_find(bool dev_key, uint8_t aid,
 			      struct bt_mesh_net_rx *rx,
 			      int (*cb)(struct bt_mesh_net_rx *rx,
-					const uint8_t key[16], void *cb_data),
+					const struct bt_aes_key *key,
+					void *cb_data),
 			      void *cb_data)
 {
 	int err, i;
 
 	if (dev_key) {
+		struct bt_aes_key key;
+
 		/* Attempt remote dev key first, as that is only available for
 		 * provisioner devices, which normally don't interact with nodes
 		 * that know their local dev key.
@@ -406,7 +429,8 @@ uint16_t bt_mesh_app_key_find(bool dev_key, uint8_t aid,
 			struct bt_mesh_cdb_node *node;
 
 			node = bt_mesh_cdb_node_get(rx->ctx.addr);
-			if (node && !cb(rx, node->dev_key, cb_data)) {
+			if (node && !bt_aes_key_set(&key, node->dev_key) &&
+			    !cb(rx, &key, cb_data)) {
 				return BT_MESH_KEY_DEV_REMOTE;
 			}
 		}
@@ -415,8 +439,8 @@ uint16_t bt_mesh_app_key_find(bool dev_key, uint8_t aid,
 		 *  The Device key is only valid for unicast addresses.
 		 */
 		if (BT_MESH_ADDR_IS_UNICAST(rx->ctx.recv_dst)) {
-			err = cb(rx, bt_mesh.dev_key, cb_data);
-			if (!err) {
+			err = bt_aes_key_set(&key, bt_mesh.dev_key);
+			if (!err && !cb(rx, &key, cb_data)) {
 				return BT_MESH_KEY_DEV_LOCAL;
 			}
 		}
@@ -446,7 +470,7 @@ uint16_t bt_mesh_app_key_find(bool dev_key, uint8_t aid,
 			continue;
 		}
 
-		err = cb(rx, cred->val, cb_data);
+		err = cb(rx, &cred->aes, cb_data);
 		if (err) {
 			continue;
 		}
@@ -18,6 +18,7 @@ struct bt_mesh_app_key {
 	struct bt_mesh_app_cred {
 		uint8_t id;
 		uint8_t val[16];
+		struct bt_aes_key aes;  /* Expanded AppKey */
 	} keys[2];
 };
 
@@ -51,16 +52,21 @@ int bt_mesh_app_key_set(uint16_t app_idx, uint16_t net_idx,
  *  @c ctx::net_idx will be used to determine the net key. Otherwise, the
  *  @c ctx::net_idx parameter will be ignored.
  *
+ *  Application keys are returned in their cached expanded form. Device keys
+ *  are expanded into @c dev_key, and @c app_key points to it.
+ *
  *  @param ctx     Message context.
  *  @param sub     Subnet return parameter.
- *  @param app_key Application return parameter.
+ *  @param app_key Expanded application key return parameter.
  *  @param aid     Application ID return parameter.
+ *  @param dev_key Storage for an expanded device key.
  *
  *  @return 0 on success, or (negative) error code on failure.
  */
 int bt_mesh_keys_resolve(struct bt_mesh_msg_ctx *ctx,
 			 struct bt_mesh_subnet **sub,
-			 const uint8_t *app_key[16], uint8_t *aid);
+			 const struct bt_aes_key **app_key, uint8_t *aid,
+			 struct bt_aes_key *dev_key);
 
 /** @brief Iterate through all matching application keys and call @c cb on each.
  *
@@ -75,7 +81,8 @@ int bt_mesh_keys_resolve(struct bt_mesh_msg_ctx *ctx,
 uint16_t bt_mesh_app_key_find(bool dev_key, uint8_t aid,
 			      struct bt_mesh_net_rx *rx,
 			      int (*cb)(struct bt_mesh_net_rx *rx,
-					const uint8_t key[16], void *cb_data),
+					const struct bt_aes_key *key,
+					void *cb_data),
 			      void *cb_data);
 
 #endif /* ZEPHYR_SUBSYS_BLUETOOTH_MESH_APP_KEYS_H_ */
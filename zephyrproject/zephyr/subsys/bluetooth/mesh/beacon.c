@@ -106,7 +106,8 @@ static int secure_beacon_send(struct bt_mesh_subnet *sub, void *cb_data)
 		return 0;
 	}
 
-	buf = bt_mesh_adv_create(BT_MESH_ADV_BEACON, PROV_XMIT, K_NO_WAIT);
+	buf = bt_mesh_adv_create(BT_MESH_ADV_BEACON, BT_MESH_BEACON_ADV,
+				 PROV_XMIT, K_NO_WAIT);
 	if (!buf) {
 		BT_ERR("Unable to allocate beacon buffer");
 		return -ENOMEM;
@@ -129,7 +130,8 @@ static int unprovisioned_beacon_send(void)
 
 	BT_DBG("");
 
-	buf = bt_mesh_adv_create(BT_MESH_ADV_BEACON, UNPROV_XMIT, K_NO_WAIT);
+	buf = bt_mesh_adv_create(BT_MESH_ADV_BEACON, BT_MESH_BEACON_ADV,
+				 UNPROV_XMIT, K_NO_WAIT);
 	if (!buf) {
 		BT_ERR("Unable to allocate beacon buffer");
 		return -ENOBUFS;
@@ -155,8 +157,8 @@ static int unprovisioned_beacon_send(void)
 	if (prov->uri) {
 		size_t len;
 
-		buf = bt_mesh_adv_create(BT_MESH_ADV_URI, UNPROV_XMIT,
-					 K_NO_WAIT);
+		buf = bt_mesh_adv_create(BT_MESH_ADV_URI, BT_MESH_BEACON_ADV,
+					 UNPROV_XMIT, K_NO_WAIT);
 		if (!buf) {
 			BT_ERR("Unable to allocate URI buffer");
 			return -ENOBUFS;
@@ -278,7 +280,7 @@ static bool auth_match(struct bt_mesh_subnet_keys *keys,
 		return false;
 	}
 
-	bt_mesh_beacon_auth(keys->beacon, params->flags, keys->net_id,
+	bt_mesh_beacon_auth(&keys->beacon, params->flags, keys->net_id,
 			    params->iv_index, net_auth);
 
 	if (memcmp(params->auth, net_auth, 8)) {
@@ -412,7 +414,7 @@ void bt_mesh_beacon_update(struct bt_mesh_subnet *sub)
 	       SUBNET_KEY_TX_IDX(sub) ? "new" : "current");
 	BT_DBG("flags 0x%02x, IVI 0x%08x", flags, bt_mesh.iv_index);
 
-	err = bt_mesh_beacon_auth(keys->beacon, flags, keys->net_id,
+	err = bt_mesh_beacon_auth(&keys->beacon, flags, keys->net_id,
 				   bt_mesh.iv_index, sub->auth);
 	if (err) {
 		BT_ERR("Failed updating net beacon for 0x%03x", sub->net_idx);
@@ -39,6 +39,186 @@ static int32_t msg_timeout;
 
 static struct bt_mesh_cfg_cli *cli;
 
+#if CONFIG_BT_MESH_CFG_CLI_ASYNC_COUNT > 0
+/* Asynchronous request waiting for its status message. A request is free
+ * when op is 0. The status must come from addr and echo back param.
+ */
+struct async_req {
+	struct k_delayed_work timer;
+	bt_mesh_cfg_cli_async_cb_t cb;
+	void *user_data;
+	int64_t deadline;
+	uint32_t op;
+	uint16_t addr;
+	uint16_t param[4];
+};
+
+static struct async_req async_reqs[CONFIG_BT_MESH_CFG_CLI_ASYNC_COUNT];
+static struct k_spinlock async_lock;
+
+static struct async_req *async_find(uint16_t addr, uint32_t op,
+				    const uint16_t param[4])
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(async_reqs); i++) {
+		struct async_req *req = &async_reqs[i];
+
+		if (req->op == op && req->addr == addr &&
+		    !memcmp(req->param, param, sizeof(req->param))) {
+			return req;
+		}
+	}
+
+	return NULL;
+}
+
+static bool async_complete(uint16_t addr, uint32_t op, const uint16_t param[4],
+			   uint8_t status)
+{
+	bt_mesh_cfg_cli_async_cb_t cb;
+	struct async_req *req;
+	void *user_data;
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&async_lock);
+
+	req = async_find(addr, op, param);
+	if (!req) {
+		k_spin_unlock(&async_lock, key);
+		return false;
+	}
+
+	cb = req->cb;
+	user_data = req->user_data;
+	req->op = 0U;
+	k_delayed_work_cancel(&req->timer);
+
+	k_spin_unlock(&async_lock, key);
+
+	cb(addr, 0, status, user_data);
+
+	return true;
+}
+
+/* A status does not tell which request it answers, e.g. a Model App Status
+ * may answer a Bind or an Unbind. A synchronous request therefore may not
+ * wait for the status a pending asynchronous request is waiting for.
+ */
+static bool async_busy(uint16_t addr, uint32_t op, const uint16_t param[4])
+{
+	k_spinlock_key_t key;
+	bool busy;
+
+	key = k_spin_lock(&async_lock);
+	busy = async_find(addr, op, param) != NULL;
+	k_spin_unlock(&async_lock, key);
+
+	return busy;
+}
+
+static void async_timeout(struct k_work *work)
+{
+	struct async_req *req = CONTAINER_OF(work, struct async_req, timer.work);
+	bt_mesh_cfg_cli_async_cb_t cb;
+	void *user_data;
+	k_spinlock_key_t key;
+	uint16_t addr;
+
+	key = k_spin_lock(&async_lock);
+
+	/* The request may have completed and the slot been reused while
+	 * this timeout was already queued.
+	 */
+	if (!req->op || k_uptime_get() < req->deadline) {
+		k_spin_unlock(&async_lock, key);
+		return;
+	}
+
+	cb = req->cb;
+	user_data = req->user_data;
+	addr = req->addr;
+	req->op = 0U;
+
+	k_spin_unlock(&async_lock, key);
+
+	BT_WARN("No status from 0x%04x", addr);
+	cb(addr, -ETIMEDOUT, 0, user_data);
+}
+
+static int async_send(uint16_t addr, uint32_t op, const uint16_t param[4],
+		      struct bt_mesh_msg_ctx *ctx, struct net_buf_simple *msg,
+		      bt_mesh_cfg_cli_async_cb_t cb, void *user_data)
+{
+	struct async_req *req = NULL;
+	k_spinlock_key_t key;
+	int err, i;
+
+	if (!cli) {
+		BT_ERR("No available Configuration Client context!");
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&async_lock);
+
+	/* The target of a pending synchronous request is not known, any
+	 * status it waits for could be taken for the answer of this one.
+	 */
+	if (async_find(addr, op, param) || cli->op_pending == op) {
+		k_spin_unlock(&async_lock, key);
+		return -EBUSY;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(async_reqs); i++) {
+		if (!async_reqs[i].op) {
+			req = &async_reqs[i];
+			break;
+		}
+	}
+
+	if (!req) {
+		k_spin_unlock(&async_lock, key);
+		return -ENOMEM;
+	}
+
+	req->cb = cb;
+	req->user_data = user_data;
+	req->deadline = k_uptime_get() + msg_timeout;
+	req->op = op;
+	req->addr = addr;
+	memcpy(req->param, param, sizeof(req->param));
+	k_delayed_work_submit(&req->timer, K_MSEC(msg_timeout));
+
+	k_spin_unlock(&async_lock, key);
+
+	err = bt_mesh_model_send(cli->model, ctx, msg, NULL, NULL);
+	if (err) {
+		BT_ERR("model_send() failed (err %d)", err);
+		key = k_spin_lock(&async_lock);
+		/* A status may already have completed it */
+		if (req->op == op && req->addr == addr &&
+		    !memcmp(req->param, param, sizeof(req->param))) {
+			req->op = 0U;
+			k_delayed_work_cancel(&req->timer);
+		}
+		k_spin_unlock(&async_lock, key);
+	}
+
+	return err;
+}
+#else
+static bool async_complete(uint16_t addr, uint32_t op, const uint16_t param[4],
+			   uint8_t status)
+{
+	return false;
+}
+
+static bool async_busy(uint16_t addr, uint32_t op, const uint16_t param[4])
+{
+	return false;
+}
+#endif /* CONFIG_BT_MESH_CFG_CLI_ASYNC_COUNT > 0 */
+
 static void comp_data_status(struct bt_mesh_model *model,
 			     struct bt_mesh_msg_ctx *ctx,
 			     struct net_buf_simple *buf,int8_t rssi)
@@ -254,14 +434,19 @@ static void app_key_status(struct bt_mesh_model *model,
 	       ctx->net_idx, ctx->app_idx, ctx->addr, buf->len,
 	       bt_hex(buf->data, buf->len));
 
+	status = net_buf_simple_pull_u8(buf);
+	key_idx_unpack(buf, &net_idx, &app_idx);
+
+	if (async_complete(ctx->addr, OP_APP_KEY_STATUS,
+			   (uint16_t[4]) { net_idx, app_idx }, status)) {
+		return;
+	}
+
 	if (cli->op_pending != OP_APP_KEY_STATUS) {
 		BT_WARN("Unexpected App Key Status message");
 		return;
 	}
 
-	status = net_buf_simple_pull_u8(buf);
-	key_idx_unpack(buf, &net_idx, &app_idx);
-
 	param = cli->op_param;
 	if (param->net_idx != net_idx || param->app_idx != app_idx) {
 		BT_WARN("App Key Status key indices did not match");
@@ -345,11 +530,6 @@ static void mod_app_status(struct bt_mesh_model *model,
 	       ctx->net_idx, ctx->app_idx, ctx->addr, buf->len,
 	       bt_hex(buf->data, buf->len));
 
-	if (cli->op_pending != OP_MOD_APP_STATUS) {
-		BT_WARN("Unexpected Model App Status message");
-		return;
-	}
-
 	status = net_buf_simple_pull_u8(buf);
 	elem_addr = net_buf_simple_pull_le16(buf);
 	mod_app_idx = net_buf_simple_pull_le16(buf);
@@ -362,6 +542,17 @@ static void mod_app_status(struct bt_mesh_model *model,
 
 	mod_id = net_buf_simple_pull_le16(buf);
 
+	if (async_complete(ctx->addr, OP_MOD_APP_STATUS,
+			   (uint16_t[4]) { elem_addr, mod_app_idx, mod_id, cid },
+			   status)) {
+		return;
+	}
+
+	if (cli->op_pending != OP_MOD_APP_STATUS) {
+		BT_WARN("Unexpected Model App Status message");
+		return;
+	}
+
 	param = cli->op_param;
 	if (param->elem_addr != elem_addr ||
 	    param->mod_app_idx != mod_app_idx || param->mod_id != mod_id ||
@@ -740,6 +931,12 @@ static int cfg_cli_init(struct bt_mesh_model *model)
 
 	k_sem_init(&cli->op_sync, 0, 1);
 
+#if CONFIG_BT_MESH_CFG_CLI_ASYNC_COUNT > 0
+	for (int i = 0; i < ARRAY_SIZE(async_reqs); i++) {
+		k_delayed_work_init(&async_reqs[i].timer, async_timeout);
+	}
+#endif
+
 	return 0;
 }
 
@@ -1137,6 +1334,11 @@ int bt_mesh_cfg_app_key_add(uint16_t net_idx, uint16_t addr, uint16_t key_net_id
 	};
 	int err;
 
+	if (async_busy(addr, OP_APP_KEY_STATUS,
+		       (uint16_t[4]) { key_net_idx, key_app_idx })) {
+		return -EBUSY;
+	}
+
 	err = cli_prepare(&param, OP_APP_KEY_STATUS);
 	if (err) {
 		return err;
@@ -1252,6 +1454,11 @@ int bt_mesh_cfg_app_key_del(uint16_t net_idx, uint16_t addr,
 	};
 	int err;
 
+	if (async_busy(addr, OP_APP_KEY_STATUS,
+		       (uint16_t[4]) { key_net_idx, key_app_idx })) {
+		return -EBUSY;
+	}
+
 	err = cli_prepare(&param, OP_APP_KEY_STATUS);
 	if (err) {
 		return err;
@@ -1295,6 +1502,11 @@ static int mod_app_bind(uint16_t net_idx, uint16_t addr, uint16_t elem_addr,
 	};
 	int err;
 
+	if (async_busy(addr, OP_MOD_APP_STATUS,
+		       (uint16_t[4]) { elem_addr, mod_app_idx, mod_id, cid })) {
+		return -EBUSY;
+	}
+
 	err = cli_prepare(&param, OP_MOD_APP_STATUS);
 	if (err) {
 		return err;
@@ -1344,6 +1556,81 @@ int bt_mesh_cfg_mod_app_bind_vnd(uint16_t net_idx, uint16_t addr, uint16_t elem_
 			    status);
 }
 
+#if CONFIG_BT_MESH_CFG_CLI_ASYNC_COUNT > 0
+int bt_mesh_cfg_app_key_add_async(uint16_t net_idx, uint16_t addr,
+				  uint16_t key_net_idx, uint16_t key_app_idx,
+				  const uint8_t app_key[16],
+				  bt_mesh_cfg_cli_async_cb_t cb, void *user_data)
+{
+	BT_MESH_MODEL_BUF_DEFINE(msg, OP_APP_KEY_ADD, 19);
+	struct bt_mesh_msg_ctx ctx = {
+		.net_idx = net_idx,
+		.app_idx = BT_MESH_KEY_DEV_REMOTE,
+		.addr = addr,
+		.send_ttl = BT_MESH_TTL_DEFAULT,
+	};
+	uint16_t param[4] = { key_net_idx, key_app_idx };
+
+	bt_mesh_model_msg_init(&msg, OP_APP_KEY_ADD);
+	key_idx_pack(&msg, key_net_idx, key_app_idx);
+	net_buf_simple_add_mem(&msg, app_key, 16);
+
+	return async_send(addr, OP_APP_KEY_STATUS, param, &ctx, &msg, cb,
+			  user_data);
+}
+
+static int mod_app_bind_async(uint16_t net_idx, uint16_t addr,
+			      uint16_t elem_addr, uint16_t mod_app_idx,
+			      uint16_t mod_id, uint16_t cid,
+			      bt_mesh_cfg_cli_async_cb_t cb, void *user_data)
+{
+	BT_MESH_MODEL_BUF_DEFINE(msg, OP_MOD_APP_BIND, 8);
+	struct bt_mesh_msg_ctx ctx = {
+		.net_idx = net_idx,
+		.app_idx = BT_MESH_KEY_DEV_REMOTE,
+		.addr = addr,
+		.send_ttl = BT_MESH_TTL_DEFAULT,
+	};
+	uint16_t param[4] = { elem_addr, mod_app_idx, mod_id, cid };
+
+	bt_mesh_model_msg_init(&msg, OP_MOD_APP_BIND);
+	net_buf_simple_add_le16(&msg, elem_addr);
+	net_buf_simple_add_le16(&msg, mod_app_idx);
+
+	if (cid != CID_NVAL) {
+		net_buf_simple_add_le16(&msg, cid);
+	}
+
+	net_buf_simple_add_le16(&msg, mod_id);
+
+	return async_send(addr, OP_MOD_APP_STATUS, param, &ctx, &msg, cb,
+			  user_data);
+}
+
+int bt_mesh_cfg_mod_app_bind_async(uint16_t net_idx, uint16_t addr,
+				   uint16_t elem_addr, uint16_t mod_app_idx,
+				   uint16_t mod_id,
+				   bt_mesh_cfg_cli_async_cb_t cb, void *user_data)
+{
+	return mod_app_bind_async(net_idx, addr, elem_addr, mod_app_idx,
+				  mod_id, CID_NVAL, cb, user_data);
+}
+
+int bt_mesh_cfg_mod_app_bind_vnd_async(uint16_t net_idx, uint16_t addr,
+				       uint16_t elem_addr, uint16_t mod_app_idx,
+				       uint16_t mod_id, uint16_t cid,
+				       bt_mesh_cfg_cli_async_cb_t cb,
+				       void *user_data)
+{
+	if (cid == CID_NVAL) {
+		return -EINVAL;
+	}
+
+	return mod_app_bind_async(net_idx, addr, elem_addr, mod_app_idx,
+				  mod_id, cid, cb, user_data);
+}
+#endif /* CONFIG_BT_MESH_CFG_CLI_ASYNC_COUNT > 0 */
+
 static int mod_app_unbind(uint16_t net_idx, uint16_t addr, uint16_t elem_addr,
 			uint16_t mod_app_idx, uint16_t mod_id, uint16_t cid,
 			uint8_t *status)
@@ -1364,6 +1651,11 @@ static int mod_app_unbind(uint16_t net_idx, uint16_t addr, uint16_t elem_addr,
 	};
 	int err;
 
+	if (async_busy(addr, OP_MOD_APP_STATUS,
+		       (uint16_t[4]) { elem_addr, mod_app_idx, mod_id, cid })) {
+		return -EBUSY;
+	}
+
 	err = cli_prepare(&param, OP_MOD_APP_STATUS);
 	if (err) {
 		return err;
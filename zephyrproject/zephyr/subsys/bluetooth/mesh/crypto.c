@@ -57,6 +57,67 @@ int bt_mesh_aes_cmac(const uint8_t key[16], struct bt_mesh_sg *sg,
 	return 0;
 }
 
+/* Multiply by x in GF(2^128), used to derive the CMAC subkeys */
+static void cmac_subkey_double(uint8_t k[16])
+{
+	uint8_t msb = k[0] & 0x80;
+	int i;
+
+	for (i = 0; i < 15; i++) {
+		k[i] = (k[i] << 1) | (k[i + 1] >> 7);
+	}
+
+	k[15] <<= 1;
+
+	if (msb) {
+		k[15] ^= 0x87;
+	}
+}
+
+/* AES-CMAC (RFC 4493) with an already expanded key */
+static int aes_cmac_key(const struct bt_aes_key *key, const uint8_t *m,
+			size_t len, uint8_t mac[16])
+{
+	uint8_t k[16] = { 0 };
+	uint8_t x[16] = { 0 };
+	int err, i;
+
+	/* K1 = L << 1, where L = AES(K, 0) */
+	err = bt_encrypt_be_key(key, k, k);
+	if (err) {
+		return err;
+	}
+
+	cmac_subkey_double(k);
+
+	for (; len > 16; len -= 16, m += 16) {
+		for (i = 0; i < 16; i++) {
+			x[i] ^= m[i];
+		}
+
+		err = bt_encrypt_be_key(key, x, x);
+		if (err) {
+			return err;
+		}
+	}
+
+	/* An incomplete last block is padded and masked with K2 */
+	if (len < 16) {
+		cmac_subkey_double(k);
+		x[len] ^= 0x80;
+	}
+
+	for (i = 0; i < len; i++) {
+		x[i] ^= m[i];
+	}
+
+	for (i = 0; i < 16; i++) {
+		x[i] ^= k[i];
+	}
+
+	return bt_encrypt_be_key(key, x, mac);
+}
+
 int bt_mesh_k1(const uint8_t *ikm, size_t ikm_len, const uint8_t salt[16],
 	       const char *info, uint8_t okm[16])
 {
@@ -255,21 +316,28 @@ static void create_net_nonce(uint8_t nonce[13], const uint8_t *pdu,
 	sys_put_be32(iv_index, &nonce[9]);
 }
 
-int bt_mesh_net_obfuscate(uint8_t *pdu, uint32_t iv_index,
-			  const uint8_t privacy_key[16])
+static int net_privacy(const uint8_t *pdu, uint32_t iv_index,
+			const struct bt_aes_key *privacy_key, uint8_t pecb[16])
 {
 	uint8_t priv_rand[16] = { 0x00, 0x00, 0x00, 0x00, 0x00, };
-	uint8_t tmp[16];
-	int err, i;
 
-	BT_DBG("IVIndex %u, PrivacyKey %s", iv_index, bt_hex(privacy_key, 16));
+	BT_DBG("IVIndex %u", iv_index);
 
 	sys_put_be32(iv_index, &priv_rand[5]);
 	memcpy(&priv_rand[9], &pdu[7], 7);
 
 	BT_DBG("PrivacyRandom %s", bt_hex(priv_rand, 16));
 
-	err = bt_encrypt_be(privacy_key, priv_rand, tmp);
+	return bt_encrypt_be_key(privacy_key, priv_rand, pecb);
+}
+
+int bt_mesh_net_obfuscate(uint8_t *pdu, uint32_t iv_index,
+			  const struct bt_aes_key *privacy_key)
+{
+	uint8_t tmp[16];
+	int err, i;
+
+	err = net_privacy(pdu, iv_index, privacy_key, tmp);
 	if (err) {
 		return err;
 	}
@@ -281,15 +349,36 @@ int bt_mesh_net_obfuscate(uint8_t *pdu, uint32_t iv_index,
 	return 0;
 }
 
-int bt_mesh_net_encrypt(const uint8_t key[16], struct net_buf_simple *buf,
-			uint32_t iv_index, bool proxy)
+int bt_mesh_net_deobfuscate(const uint8_t *pdu, uint8_t hdr[7],
+			    uint32_t iv_index,
+			    const struct bt_aes_key *privacy_key)
+{
+	uint8_t tmp[16];
+	int err, i;
+
+	err = net_privacy(pdu, iv_index, privacy_key, tmp);
+	if (err) {
+		return err;
+	}
+
+	hdr[0] = pdu[0];
+
+	for (i = 0; i < 6; i++) {
+		hdr[1 + i] = pdu[1 + i] ^ tmp[i];
+	}
+
+	return 0;
+}
+
+int bt_mesh_net_encrypt(const struct bt_aes_key *key,
+			struct net_buf_simple *buf, uint32_t iv_index,
+			bool proxy)
 {
 	uint8_t mic_len = NET_MIC_LEN(buf->data);
 	uint8_t nonce[13];
 	int err;
 
-	BT_DBG("IVIndex %u EncKey %s mic_len %u", iv_index, bt_hex(key, 16),
-	       mic_len);
+	BT_DBG("IVIndex %u mic_len %u", iv_index, mic_len);
 	BT_DBG("PDU (len %u) %s", buf->len, bt_hex(buf->data, buf->len));
 
 	if (IS_ENABLED(CONFIG_BT_MESH_PROXY) && proxy) {
@@ -300,8 +389,8 @@ int bt_mesh_net_encrypt(const uint8_t key[16], struct net_buf_simple *buf,
 
 	BT_DBG("Nonce %s", bt_hex(nonce, 13));
 
-	err = bt_ccm_encrypt(key, nonce, &buf->data[7], buf->len - 7, NULL, 0,
-			     &buf->data[7], mic_len);
+	err = bt_ccm_encrypt_key(key, nonce, &buf->data[7], buf->len - 7, NULL,
+				 0, &buf->data[7], mic_len);
 	if (!err) {
 		net_buf_simple_add(buf, mic_len);
 	}
@@ -309,28 +398,29 @@ int bt_mesh_net_encrypt(const uint8_t key[16], struct net_buf_simple *buf,
 	return err;
 }
 
-int bt_mesh_net_decrypt(const uint8_t key[16], struct net_buf_simple *buf,
-			uint32_t iv_index, bool proxy)
+int bt_mesh_net_decrypt(const struct bt_aes_key *key,
+			const struct net_buf_simple *in,
+			struct net_buf_simple *out, uint32_t iv_index,
+			bool proxy)
 {
-	uint8_t mic_len = NET_MIC_LEN(buf->data);
+	uint8_t mic_len = NET_MIC_LEN(out->data);
 	uint8_t nonce[13];
 
-	BT_DBG("PDU (%u bytes) %s", buf->len, bt_hex(buf->data, buf->len));
-	BT_DBG("iv_index %u, key %s mic_len %u", iv_index, bt_hex(key, 16),
-	       mic_len);
+	BT_DBG("PDU (%u bytes) %s", in->len, bt_hex(in->data, in->len));
+	BT_DBG("iv_index %u mic_len %u", iv_index, mic_len);
 
 	if (IS_ENABLED(CONFIG_BT_MESH_PROXY) && proxy) {
-		create_proxy_nonce(nonce, buf->data, iv_index);
+		create_proxy_nonce(nonce, out->data, iv_index);
 	} else {
-		create_net_nonce(nonce, buf->data, iv_index);
+		create_net_nonce(nonce, out->data, iv_index);
 	}
 
 	BT_DBG("Nonce %s", bt_hex(nonce, 13));
 
-	buf->len -= mic_len;
+	out->len = in->len - mic_len;
 
-	return bt_ccm_decrypt(key, nonce, &buf->data[7], buf->len - 7, NULL, 0,
-			      &buf->data[7], mic_len);
+	return bt_ccm_decrypt_key(key, nonce, &in->data[7], out->len - 7, NULL,
+				  0, &out->data[7], mic_len);
 }
 
 static void create_app_nonce(uint8_t nonce[13],
@@ -350,14 +440,13 @@ static void create_app_nonce(uint8_t nonce[13],
 	sys_put_be32(ctx->iv_index, &nonce[9]);
 }
 
-int bt_mesh_app_encrypt(const uint8_t key[16],
+int bt_mesh_app_encrypt(const struct bt_aes_key *key,
 			const struct bt_mesh_app_crypto_ctx *ctx,
 			struct net_buf_simple *buf)
 {
 	uint8_t nonce[13];
 	int err;
 
-	BT_DBG("AppKey %s", bt_hex(key, 16));
 	BT_DBG("dev_key %u src 0x%04x dst 0x%04x", ctx->dev_key, ctx->src,
 	       ctx->dst);
 	BT_DBG("seq_num 0x%08x iv_index 0x%08x", ctx->seq_num, ctx->iv_index);
@@ -367,9 +456,9 @@ int bt_mesh_app_encrypt(const uint8_t key[16],
 
 	BT_DBG("Nonce  %s", bt_hex(nonce, 13));
 
-	err = bt_ccm_encrypt(key, nonce, buf->data, buf->len, ctx->ad,
-			     ctx->ad ? 16 : 0, buf->data,
-			     APP_MIC_LEN(ctx->aszmic));
+	err = bt_ccm_encrypt_key(key, nonce, buf->data, buf->len, ctx->ad,
+				 ctx->ad ? 16 : 0, buf->data,
+				 APP_MIC_LEN(ctx->aszmic));
 	if (!err) {
 		net_buf_simple_add(buf, APP_MIC_LEN(ctx->aszmic));
 		BT_DBG("Encr: %s", bt_hex(buf->data, buf->len));
@@ -378,7 +467,7 @@ int bt_mesh_app_encrypt(const uint8_t key[16],
 	return err;
 }
 
-int bt_mesh_app_decrypt(const uint8_t key[16],
+int bt_mesh_app_decrypt(const struct bt_aes_key *key,
 			const struct bt_mesh_app_crypto_ctx *ctx,
 			struct net_buf_simple *buf, struct net_buf_simple *out)
 {
@@ -390,12 +479,11 @@ int bt_mesh_app_decrypt(const uint8_t key[16],
 
 	create_app_nonce(nonce, ctx);
 
-	BT_DBG("AppKey %s", bt_hex(key, 16));
 	BT_DBG("Nonce  %s", bt_hex(nonce, 13));
 
-	err = bt_ccm_decrypt(key, nonce, buf->data, buf->len, ctx->ad,
-			     ctx->ad ? 16 : 0, out->data,
-			     APP_MIC_LEN(ctx->aszmic));
+	err = bt_ccm_decrypt_key(key, nonce, buf->data, buf->len, ctx->ad,
+				 ctx->ad ? 16 : 0, out->data,
+				 APP_MIC_LEN(ctx->aszmic));
 	if (!err) {
 		net_buf_simple_add(out, buf->len);
 	}
@@ -530,14 +618,13 @@ int bt_mesh_prov_encrypt(const uint8_t key[16], uint8_t nonce[13],
 	return bt_ccm_encrypt(key, nonce, data, 25, NULL, 0, out, 8);
 }
 
-int bt_mesh_beacon_auth(const uint8_t beacon_key[16], uint8_t flags,
+int bt_mesh_beacon_auth(const struct bt_aes_key *beacon_key, uint8_t flags,
 			const uint8_t net_id[8], uint32_t iv_index,
 			uint8_t auth[8])
 {
 	uint8_t msg[13], tmp[16];
 	int err;
 
-	BT_DBG("BeaconKey %s", bt_hex(beacon_key, 16));
 	BT_DBG("NetId %s", bt_hex(net_id, 8));
 	BT_DBG("IV Index 0x%08x", iv_index);
 
@@ -547,7 +634,7 @@ int bt_mesh_beacon_auth(const uint8_t beacon_key[16], uint8_t flags,
 
 	BT_DBG("BeaconMsg %s", bt_hex(msg, sizeof(msg)));
 
-	err = bt_mesh_aes_cmac_one(beacon_key, msg, sizeof(msg), tmp);
+	err = aes_cmac_key(beacon_key, msg, sizeof(msg), tmp);
 	if (!err) {
 		memcpy(auth, tmp, 8);
 	}
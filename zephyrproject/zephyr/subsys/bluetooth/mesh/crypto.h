@@ -6,6 +6,8 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+struct bt_aes_key;
+
 struct bt_mesh_sg {
 	const void *data;
 	size_t len;
@@ -65,7 +67,7 @@ static inline int bt_mesh_beacon_key(const uint8_t net_key[16],
 	return bt_mesh_id128(net_key, "nkbk", beacon_key);
 }
 
-int bt_mesh_beacon_auth(const uint8_t beacon_key[16], uint8_t flags,
+int bt_mesh_beacon_auth(const struct bt_aes_key *beacon_key, uint8_t flags,
 			const uint8_t net_id[16], uint32_t iv_index,
 			uint8_t auth[8]);
 
@@ -119,13 +121,26 @@ static inline int bt_mesh_prov_salt(const uint8_t conf_salt[16],
 }
 
 int bt_mesh_net_obfuscate(uint8_t *pdu, uint32_t iv_index,
-			  const uint8_t privacy_key[16]);
+			  const struct bt_aes_key *privacy_key);
+
+/* Write the deobfuscated header of the Network PDU in pdu to hdr,
+ * leaving pdu itself untouched.
+ */
+int bt_mesh_net_deobfuscate(const uint8_t *pdu, uint8_t hdr[7],
+			    uint32_t iv_index,
+			    const struct bt_aes_key *privacy_key);
 
-int bt_mesh_net_encrypt(const uint8_t key[16], struct net_buf_simple *buf,
-			uint32_t iv_index, bool proxy);
+int bt_mesh_net_encrypt(const struct bt_aes_key *key,
+			struct net_buf_simple *buf, uint32_t iv_index,
+			bool proxy);
 
-int bt_mesh_net_decrypt(const uint8_t key[16], struct net_buf_simple *buf,
-			uint32_t iv_index, bool proxy);
+/* Decrypt the Network PDU in, whose deobfuscated header is already in out,
+ * straight into out. in and out may be the same buffer.
+ */
+int bt_mesh_net_decrypt(const struct bt_aes_key *key,
+			const struct net_buf_simple *in,
+			struct net_buf_simple *out, uint32_t iv_index,
+			bool proxy);
 
 
 struct bt_mesh_app_crypto_ctx {
@@ -138,11 +153,11 @@ struct bt_mesh_app_crypto_ctx {
 	const uint8_t *ad;
 };
 
-int bt_mesh_app_encrypt(const uint8_t key[16],
+int bt_mesh_app_encrypt(const struct bt_aes_key *key,
 			const struct bt_mesh_app_crypto_ctx *ctx,
 			struct net_buf_simple *buf);
 
-int bt_mesh_app_decrypt(const uint8_t key[16],
+int bt_mesh_app_decrypt(const struct bt_aes_key *key,
 			const struct bt_mesh_app_crypto_ctx *ctx,
 			struct net_buf_simple *buf, struct net_buf_simple *out);
 
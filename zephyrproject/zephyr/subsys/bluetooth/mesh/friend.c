@@ -30,9 +30,10 @@
 
 /* We reserve one extra buffer for each friendship, since we need to be able
  * to resend the last sent PDU, which sits separately outside of the queue.
+ * The same goes for the rest of a burst.
  */
-#define FRIEND_BUF_COUNT    ((CONFIG_BT_MESH_FRIEND_QUEUE_SIZE + 1) * \
-			     CONFIG_BT_MESH_FRIEND_LPN_COUNT)
+#define FRIEND_BUF_COUNT    ((CONFIG_BT_MESH_FRIEND_QUEUE_SIZE + 1 + \
+			      FRIEND_BURST) * CONFIG_BT_MESH_FRIEND_LPN_COUNT)
 
 #define FRIEND_ADV(buf) CONTAINER_OF(BT_MESH_ADV(buf), struct friend_adv, adv)
 
@@ -59,11 +60,38 @@ NET_BUF_POOL_FIXED_DEFINE(friend_buf_pool, FRIEND_BUF_COUNT,
 static struct friend_adv {
 	struct bt_mesh_adv adv;
 	uint16_t app_idx;
+	uint8_t  ack:1;         /* In the acks of the friendship */
 } adv_pool[FRIEND_BUF_COUNT];
 
+/* Established friendships ordered by LPN address, and the Friend
+ * Subscription List entries hashed by group address, so that incoming PDUs
+ * are matched without going through every friendship.
+ *
+ * A Subscription List entry is referred to by its index in the lists of
+ * all friendships plus one, so that zero ends a hash chain.
+ */
+#define SUB_STRIDE  MAX(FRIEND_SUB_LIST_SIZE, 1)
+#define SUB_BUCKETS (CONFIG_BT_MESH_FRIEND_LPN_COUNT * SUB_STRIDE)
+
+BUILD_ASSERT(SUB_BUCKETS < UINT16_MAX,
+	     "Too many Friend Subscription List entries to index");
+
+#define SUB_IDX(frnd, i)                                                    \
+	((uint16_t)(((frnd) - bt_mesh.frnd) * SUB_STRIDE + (i) + 1))
+#define SUB_FRND(idx) (&bt_mesh.frnd[((idx) - 1) / SUB_STRIDE])
+#define SUB_ADDR(idx) (SUB_FRND(idx)->sub_list[((idx) - 1) % SUB_STRIDE])
+
+static struct {
+	uint16_t lpn[CONFIG_BT_MESH_FRIEND_LPN_COUNT];
+	uint16_t lpn_count;
+	uint16_t bucket[SUB_BUCKETS];
+	uint16_t next[SUB_BUCKETS];
+} frnd_index;
+
 static struct bt_mesh_adv *adv_alloc(int id)
 {
 	adv_pool[id].app_idx = BT_MESH_KEY_UNUSED;
+	adv_pool[id].ack = 0U;
 	return &adv_pool[id].adv;
 }
 
@@ -76,6 +104,126 @@ static bool is_lpn_unicast(struct bt_mesh_friend *frnd, uint16_t addr)
 	return (addr >= frnd->lpn && addr < (frnd->lpn + frnd->num_elem));
 }
 
+/* Position of the first LPN in the index with an address above addr */
+static int lpn_index_search(uint16_t addr)
+{
+	int lo = 0, hi = frnd_index.lpn_count;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (bt_mesh.frnd[frnd_index.lpn[mid]].lpn <= addr) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+static void lpn_index_add(struct bt_mesh_friend *frnd)
+{
+	int pos = lpn_index_search(frnd->lpn);
+
+	memmove(&frnd_index.lpn[pos + 1], &frnd_index.lpn[pos],
+		(frnd_index.lpn_count - pos) * sizeof(frnd_index.lpn[0]));
+	frnd_index.lpn[pos] = frnd - bt_mesh.frnd;
+	frnd_index.lpn_count++;
+}
+
+static void lpn_index_rem(struct bt_mesh_friend *frnd)
+{
+	int pos;
+
+	for (pos = 0; pos < frnd_index.lpn_count; pos++) {
+		if (&bt_mesh.frnd[frnd_index.lpn[pos]] == frnd) {
+			break;
+		}
+	}
+
+	if (pos == frnd_index.lpn_count) {
+		return;
+	}
+
+	frnd_index.lpn_count--;
+	memmove(&frnd_index.lpn[pos], &frnd_index.lpn[pos + 1],
+		(frnd_index.lpn_count - pos) * sizeof(frnd_index.lpn[0]));
+}
+
+static uint16_t *sub_bucket(uint16_t addr)
+{
+	return &frnd_index.bucket[addr % SUB_BUCKETS];
+}
+
+static void sub_link(struct bt_mesh_friend *frnd, int i)
+{
+	uint16_t *bucket = sub_bucket(frnd->sub_list[i]);
+	uint16_t idx = SUB_IDX(frnd, i);
+
+	frnd_index.next[idx - 1] = *bucket;
+	*bucket = idx;
+}
+
+static void sub_unlink(struct bt_mesh_friend *frnd, int i)
+{
+	uint16_t *cur = sub_bucket(frnd->sub_list[i]);
+	uint16_t idx = SUB_IDX(frnd, i);
+
+	while (*cur) {
+		if (*cur == idx) {
+			*cur = frnd_index.next[idx - 1];
+			frnd_index.next[idx - 1] = 0U;
+			return;
+		}
+
+		cur = &frnd_index.next[*cur - 1];
+	}
+}
+
+/* Get the next established friendship in the subnet that addr belongs to,
+ * either as an LPN element or through the Friend Subscription List. Start
+ * with *iter at zero, NULL is returned when there are no more.
+ */
+static struct bt_mesh_friend *friend_lpn_next(uint16_t net_idx, uint16_t addr,
+					       uint16_t *iter)
+{
+	struct bt_mesh_friend *frnd;
+	uint16_t idx;
+
+	if (BT_MESH_ADDR_IS_UNICAST(addr)) {
+		int pos = *iter ? *iter - 1 : lpn_index_search(addr);
+
+		/* The same LPN may be friends with us in several subnets,
+		 * their entries are next to each other.
+		 */
+		while (pos > 0) {
+			frnd = &bt_mesh.frnd[frnd_index.lpn[--pos]];
+			if (!is_lpn_unicast(frnd, addr)) {
+				break;
+			}
+
+			if (frnd->subnet->net_idx == net_idx) {
+				*iter = pos + 1;
+				return frnd;
+			}
+		}
+
+		return NULL;
+	}
+
+	for (idx = *iter ? frnd_index.next[*iter - 1] : *sub_bucket(addr); idx;
+	     idx = frnd_index.next[idx - 1]) {
+		frnd = SUB_FRND(idx);
+		if (SUB_ADDR(idx) == addr && frnd->subnet->net_idx == net_idx) {
+			*iter = idx;
+			return frnd;
+		}
+	}
+
+	return NULL;
+}
+
 struct bt_mesh_friend *bt_mesh_friend_find(uint16_t net_idx, uint16_t lpn_addr,
 					   bool valid, bool established)
 {
@@ -143,6 +291,20 @@ static int32_t recv_delay(struct bt_mesh_friend *frnd)
 #endif
 }
 
+static void friend_burst_clear(struct bt_mesh_friend *frnd)
+{
+	int i;
+
+	for (i = 0; i < frnd->burst_len; i++) {
+		net_buf_unref(frnd->burst_buf[i]);
+	}
+
+	frnd->burst_len = 0U;
+	frnd->burst_next = 0U;
+	frnd->bursting = 0U;
+	frnd->burst_end = 0U;
+}
+
 static void friend_clear(struct bt_mesh_friend *frnd)
 {
 	int i;
@@ -152,6 +314,7 @@ static void friend_clear(struct bt_mesh_friend *frnd)
 	k_delayed_work_cancel(&frnd->timer);
 
 	memset(frnd->cred, 0, sizeof(frnd->cred));
+	bt_mesh_net_creds_changed();
 
 	if (frnd->last) {
 		/* Cancel the sending if necessary */
@@ -163,7 +326,15 @@ static void friend_clear(struct bt_mesh_friend *frnd)
 		frnd->last = NULL;
 	}
 
+	for (i = 0; frnd->pending_buf && i < frnd->burst_len; i++) {
+		BT_MESH_ADV(frnd->burst_buf[i])->busy = 0U;
+	}
+
+	friend_burst_clear(frnd);
+
 	purge_buffers(&frnd->queue);
+	(void)memset(frnd->acks, 0, sizeof(frnd->acks));
+	frnd->acks_untracked = 0U;
 
 	for (i = 0; i < ARRAY_SIZE(frnd->seg); i++) {
 		struct bt_mesh_friend_seg *seg = &frnd->seg[i];
@@ -172,6 +343,18 @@ static void friend_clear(struct bt_mesh_friend *frnd)
 		seg->seg_count = 0U;
 	}
 
+	frnd->seg_reserved = 0U;
+
+	if (frnd->established) {
+		lpn_index_rem(frnd);
+
+		for (i = 0; i < ARRAY_SIZE(frnd->sub_list); i++) {
+			if (frnd->sub_list[i] != BT_MESH_ADDR_UNASSIGNED) {
+				sub_unlink(frnd, i);
+			}
+		}
+	}
+
 	Z_STRUCT_SECTION_FOREACH(bt_mesh_friend_cb, cb) {
 		if (frnd->established && cb->terminated) {
 			cb->terminated(frnd->subnet->net_idx, frnd->lpn);
@@ -183,6 +366,16 @@ static void friend_clear(struct bt_mesh_friend *frnd)
 	frnd->pending_buf = 0U;
 	frnd->fsn = 0U;
 	frnd->queue_size = 0U;
+	frnd->queue_max = 0U;
+	frnd->dropped = 0U;
+	frnd->superseded = 0U;
+	frnd->polls = 0U;
+	frnd->sent = 0U;
+	frnd->repeated = 0U;
+	frnd->drain_ms = 0U;
+	frnd->drain_max_ms = 0U;
+	frnd->drain_start = 0U;
+	frnd->burst = 0U;
 	frnd->pending_req = 0U;
 	(void)memset(frnd->sub_list, 0, sizeof(frnd->sub_list));
 }
@@ -280,13 +473,32 @@ int bt_mesh_friend_clear(struct bt_mesh_net_rx *rx, struct net_buf_simple *buf)
 	return 0;
 }
 
+/* Index of addr in the Friend Subscription List, -1 if it isn't there */
+static int friend_sub_find(struct bt_mesh_friend *frnd, uint16_t addr)
+{
+	uint16_t idx;
+
+	for (idx = *sub_bucket(addr); idx; idx = frnd_index.next[idx - 1]) {
+		if (SUB_FRND(idx) == frnd && SUB_ADDR(idx) == addr) {
+			return (idx - 1) % SUB_STRIDE;
+		}
+	}
+
+	return -1;
+}
+
 static void friend_sub_add(struct bt_mesh_friend *frnd, uint16_t addr)
 {
 	int i;
 
+	if (addr == BT_MESH_ADDR_UNASSIGNED || friend_sub_find(frnd, addr) >= 0) {
+		return;
+	}
+
 	for (i = 0; i < ARRAY_SIZE(frnd->sub_list); i++) {
 		if (frnd->sub_list[i] == BT_MESH_ADDR_UNASSIGNED) {
 			frnd->sub_list[i] = addr;
+			sub_link(frnd, i);
 			return;
 		}
 	}
@@ -298,12 +510,13 @@ static void friend_sub_rem(struct bt_mesh_friend *frnd, uint16_t addr)
 {
 	int i;
 
-	for (i = 0; i < ARRAY_SIZE(frnd->sub_list); i++) {
-		if (frnd->sub_list[i] == addr) {
-			frnd->sub_list[i] = BT_MESH_ADDR_UNASSIGNED;
-			return;
-		}
+	i = friend_sub_find(frnd, addr);
+	if (i < 0) {
+		return;
 	}
+
+	sub_unlink(frnd, i);
+	frnd->sub_list[i] = BT_MESH_ADDR_UNASSIGNED;
 }
 
 static struct net_buf *create_friend_pdu(struct bt_mesh_friend *frnd,
@@ -313,7 +526,7 @@ static struct net_buf *create_friend_pdu(struct bt_mesh_friend *frnd,
 	struct net_buf *buf;
 
 	buf = bt_mesh_adv_create_from_pool(&friend_buf_pool, adv_alloc,
-					   BT_MESH_ADV_DATA,
+					   BT_MESH_ADV_DATA, BT_MESH_FRIEND_ADV,
 					   FRIEND_XMIT, K_NO_WAIT);
 	if (!buf) {
 		return NULL;
@@ -339,7 +552,8 @@ static struct net_buf *create_friend_pdu(struct bt_mesh_friend *frnd,
 
 struct unseg_app_sdu_meta {
 	struct bt_mesh_app_crypto_ctx crypto;
-	const uint8_t *key;
+	const struct bt_aes_key *key;
+	struct bt_aes_key dev_key;
 	struct bt_mesh_subnet *subnet;
 	uint8_t aid;
 };
@@ -354,7 +568,8 @@ static int unseg_app_sdu_unpack(struct bt_mesh_friend *frnd,
 
 	meta->subnet = frnd->subnet;
 	bt_mesh_net_header_parse(&buf->b, &net);
-	err = bt_mesh_keys_resolve(&net.ctx, &net.sub, &meta->key, &meta->aid);
+	err = bt_mesh_keys_resolve(&net.ctx, &net.sub, &meta->key, &meta->aid,
+				   &meta->dev_key);
 	if (err) {
 		return err;
 	}
@@ -479,12 +694,12 @@ static int encrypt_friend_pdu(struct bt_mesh_friend *frnd, struct net_buf *buf,
 
 	buf->data[0] = (cred->nid | (iv_index & 1) << 7);
 
-	if (bt_mesh_net_encrypt(cred->enc, &buf->b, iv_index, false)) {
+	if (bt_mesh_net_encrypt(&cred->enc, &buf->b, iv_index, false)) {
 		BT_ERR("Encrypting failed");
 		return -EINVAL;
 	}
 
-	if (bt_mesh_net_obfuscate(buf->data, iv_index, cred->privacy)) {
+	if (bt_mesh_net_obfuscate(buf->data, iv_index, &cred->privacy)) {
 		BT_ERR("Obfuscating failed");
 		return -EINVAL;
 	}
@@ -528,6 +743,10 @@ static struct net_buf *encode_update(struct bt_mesh_friend *frnd, uint8_t md)
 
 	upd = net_buf_simple_add(&sdu, sizeof(*upd));
 	upd->flags = bt_mesh_net_flags(frnd->subnet);
+	if (frnd->burst) {
+		upd->flags |= BT_MESH_FRIEND_FLAG_BURST;
+	}
+
 	upd->iv_index = sys_cpu_to_be32(bt_mesh.iv_index);
 	upd->md = md;
 
@@ -571,6 +790,7 @@ static void friend_recv_delay(struct bt_mesh_friend *frnd)
 	int32_t delay = recv_delay(frnd);
 
 	frnd->pending_req = 1U;
+	frnd->bursting = 0U;
 	k_delayed_work_submit(&frnd->timer, K_MSEC(delay));
 	BT_DBG("Waiting RecvDelay of %d ms", delay);
 }
@@ -649,6 +869,64 @@ static void enqueue_buf(struct bt_mesh_friend *frnd, struct net_buf *buf)
 {
 	net_buf_slist_put(&frnd->queue, buf);
 	frnd->queue_size++;
+	frnd->queue_max = MAX(frnd->queue_max, frnd->queue_size);
+}
+
+static void friend_ack_track(struct bt_mesh_friend *frnd, struct net_buf *buf)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(frnd->acks); i++) {
+		if (!frnd->acks[i]) {
+			frnd->acks[i] = buf;
+			FRIEND_ADV(buf)->ack = 1U;
+			return;
+		}
+	}
+
+	/* Superseded acks have to be searched for in the queue until it has
+	 * drained.
+	 */
+	frnd->acks_untracked = 1U;
+}
+
+static void friend_ack_untrack(struct bt_mesh_friend *frnd, struct net_buf *buf)
+{
+	int i;
+
+	if (!FRIEND_ADV(buf)->ack) {
+		return;
+	}
+
+	FRIEND_ADV(buf)->ack = 0U;
+
+	for (i = 0; i < ARRAY_SIZE(frnd->acks); i++) {
+		if (frnd->acks[i] == buf) {
+			frnd->acks[i] = NULL;
+			return;
+		}
+	}
+}
+
+/* Take the next PDU off the Friend Queue */
+static struct net_buf *friend_queue_get(struct bt_mesh_friend *frnd)
+{
+	struct net_buf *buf;
+
+	buf = (void *)sys_slist_get(&frnd->queue);
+	if (!buf) {
+		return NULL;
+	}
+
+	friend_ack_untrack(frnd, buf);
+
+	if (sys_slist_is_empty(&frnd->queue)) {
+		frnd->acks_untracked = 0U;
+	}
+
+	frnd->queue_size--;
+
+	return buf;
 }
 
 static void enqueue_update(struct bt_mesh_friend *frnd, uint8_t md)
@@ -697,6 +975,7 @@ int bt_mesh_friend_poll(struct bt_mesh_net_rx *rx, struct net_buf_simple *buf)
 	if (!frnd->established) {
 		BT_DBG("Friendship established with 0x%04x", frnd->lpn);
 		frnd->established = 1U;
+		lpn_index_add(frnd);
 
 		Z_STRUCT_SECTION_FOREACH(bt_mesh_friend_cb, cb) {
 			if (cb->established) {
@@ -706,20 +985,31 @@ int bt_mesh_friend_poll(struct bt_mesh_net_rx *rx, struct net_buf_simple *buf)
 		}
 	}
 
+	frnd->polls++;
+
 	if (msg->fsn == frnd->fsn && frnd->last) {
 		BT_DBG("Re-sending last PDU");
 		frnd->send_last = 1U;
+		frnd->repeated++;
+
+		/* The rest of the burst goes again after it */
+		frnd->bursting = (frnd->burst_len != 0U);
+		frnd->burst_next = 0U;
 	} else {
 		if (frnd->last) {
 			net_buf_unref(frnd->last);
 			frnd->last = NULL;
 		}
 
+		friend_burst_clear(frnd);
+
 		frnd->fsn = msg->fsn;
 
-		if (sys_slist_is_empty(&frnd->queue)) {
+		if (!frnd->queue_size) {
 			enqueue_update(frnd, 0);
 			BT_DBG("Enqueued Friend Update to empty queue");
+		} else if (!frnd->drain_start) {
+			frnd->drain_start = MAX(k_uptime_get_32(), 1U);
 		}
 	}
 
@@ -992,6 +1282,8 @@ init_friend:
 	frnd->poll_to = poll_to * 100U;
 	frnd->lpn_counter = sys_be16_to_cpu(msg->lpn_counter);
 	frnd->clear.frnd = sys_be16_to_cpu(msg->prev_addr);
+	frnd->burst = (FRIEND_BURST > 0 &&
+		       (msg->criteria & BT_MESH_FRIEND_CRIT_BURST));
 
 	err = friend_cred_create(frnd, SUBNET_KEY_TX_IDX(frnd->subnet));
 	if (err) {
@@ -1000,6 +1292,8 @@ init_friend:
 		return -EIO;
 	}
 
+	bt_mesh_net_creds_changed();
+
 	BT_DBG("LPN 0x%04x rssi %d recv_delay %u poll_to %ums",
 	       frnd->lpn, rx->ctx.recv_rssi, frnd->recv_delay, frnd->poll_to);
 
@@ -1018,23 +1312,8 @@ init_friend:
 
 static bool is_seg(struct bt_mesh_friend_seg *seg, uint16_t src, uint16_t seq_zero)
 {
-	struct net_buf *buf = (void *)sys_slist_peek_head(&seg->queue);
-	struct net_buf_simple_state state;
-	uint16_t buf_seq_zero;
-	uint16_t buf_src;
-
-	if (!buf) {
-		return false;
-	}
-
-	net_buf_simple_save(&buf->b, &state);
-	net_buf_skip(buf, 5);   /* skip IVI, NID, CTL, TTL, SEQ */
-	buf_src = net_buf_pull_be16(buf);
-	net_buf_skip(buf, 3);   /* skip DST, OP/AID */
-	buf_seq_zero = ((net_buf_pull_be16(buf) >> 2) & TRANS_SEQ_ZERO_MASK);
-	net_buf_simple_restore(&buf->b, &state);
-
-	return ((src == buf_src) && (seq_zero == buf_seq_zero));
+	return (!sys_slist_is_empty(&seg->queue) && seg->src == src &&
+		seg->seq_zero == seq_zero);
 }
 
 static struct bt_mesh_friend_seg *get_seg(struct bt_mesh_friend *frnd,
@@ -1057,7 +1336,10 @@ static struct bt_mesh_friend_seg *get_seg(struct bt_mesh_friend *frnd,
 	}
 
 	if (unassigned) {
+		unassigned->src = src;
+		unassigned->seq_zero = seq_zero;
 		unassigned->seg_count = seg_count;
+		frnd->seg_reserved += seg_count;
 	}
 
 	return unassigned;
@@ -1092,6 +1374,8 @@ static void enqueue_friend_pdu(struct bt_mesh_friend *frnd,
 		sys_slist_merge_slist(&frnd->queue, &seg->queue);
 
 		frnd->queue_size += seg->seg_count;
+		frnd->queue_max = MAX(frnd->queue_max, frnd->queue_size);
+		frnd->seg_reserved -= seg->seg_count;
 		seg->seg_count = 0U;
 	} else {
 		/* Mark the buffer as having more to come after it */
@@ -1099,6 +1383,112 @@ static void enqueue_friend_pdu(struct bt_mesh_friend *frnd,
 	}
 }
 
+/* Returns true if buf is a Friend Update */
+static bool update_overwrite(struct net_buf *buf, uint8_t md)
+{
+	struct net_buf_simple_state state;
+	struct bt_mesh_ctl_friend_update *upd;
+	bool found = false;
+
+	if (buf->len != 16) {
+		return false;
+	}
+
+	net_buf_simple_save(&buf->b, &state);
+
+	net_buf_skip(buf, 1); /* skip IVI, NID */
+
+	if (!(net_buf_pull_u8(buf) >> 7)) {
+		goto end;
+	}
+
+	net_buf_skip(buf, 7); /* skip seqnum src dec*/
+
+	if (TRANS_CTL_OP((uint8_t *) net_buf_pull_mem(buf, 1))
+			!= TRANS_CTL_OP_FRIEND_UPDATE) {
+		goto end;
+	}
+
+	upd = net_buf_pull_mem(buf, sizeof(*upd));
+	BT_DBG("Update Previous Friend Update MD 0x%02x -> 0x%02x", upd->md, md);
+	upd->md = md;
+	found = true;
+
+end:
+	net_buf_simple_restore(&buf->b, &state);
+	return found;
+}
+
+static void friend_drain_check(struct bt_mesh_friend *frnd)
+{
+	if (frnd->queue_size || !frnd->drain_start) {
+		return;
+	}
+
+	frnd->drain_ms = k_uptime_get_32() - frnd->drain_start;
+	frnd->drain_max_ms = MAX(frnd->drain_max_ms, frnd->drain_ms);
+	frnd->drain_start = 0U;
+
+	BT_DBG("Friend Queue of 0x%04x drained in %u ms", frnd->lpn,
+	       frnd->drain_ms);
+}
+
+static bool friend_burst_more(struct bt_mesh_friend *frnd)
+{
+	return (frnd->burst_next < frnd->burst_len ||
+		(!frnd->burst_end && frnd->burst_len < ARRAY_SIZE(frnd->burst_buf)));
+}
+
+/* Get the next PDU of a burst, resending the ones of a repeated Poll first */
+static struct net_buf *friend_burst_next(struct bt_mesh_friend *frnd)
+{
+	struct net_buf *buf;
+	uint8_t md;
+
+	if (frnd->burst_next < frnd->burst_len) {
+		return frnd->burst_buf[frnd->burst_next++];
+	}
+
+	/* The last slot is kept for the Friend Update ending the burst */
+	if (frnd->burst_len < ARRAY_SIZE(frnd->burst_buf) - 1) {
+		buf = friend_queue_get(frnd);
+	} else {
+		buf = NULL;
+	}
+
+	md = (uint8_t)(frnd->queue_size != 0U);
+
+	if (buf) {
+		friend_drain_check(frnd);
+	} else {
+		buf = encode_update(frnd, md);
+		if (!buf) {
+			BT_ERR("Unable to encode Friend Update");
+			return NULL;
+		}
+	}
+
+	/* The LPN only acknowledges a burst once it got the Friend Update
+	 * ending it, and polls with the same FSN for a repeat otherwise.
+	 */
+	if (update_overwrite(buf, md)) {
+		frnd->burst_end = 1U;
+	}
+
+	buf->flags &= ~NET_BUF_FRAGS;
+	buf->frags = NULL;
+
+	if (encrypt_friend_pdu(frnd, buf, false)) {
+		net_buf_unref(buf);
+		return NULL;
+	}
+
+	frnd->burst_buf[frnd->burst_len++] = buf;
+	frnd->burst_next++;
+
+	return buf;
+}
+
 static void buf_send_start(uint16_t duration, int err, void *user_data)
 {
 	struct bt_mesh_friend *frnd = user_data;
@@ -1125,6 +1515,13 @@ static void buf_send_end(int err, void *user_data)
 		return;
 	}
 
+	if (frnd->bursting && friend_burst_more(frnd)) {
+		k_delayed_work_submit(&frnd->timer, K_NO_WAIT);
+		return;
+	}
+
+	frnd->bursting = 0U;
+
 	if (frnd->established) {
 		k_delayed_work_submit(&frnd->timer, K_MSEC(frnd->poll_to));
 		BT_DBG("Waiting %u ms for next poll", frnd->poll_to);
@@ -1135,38 +1532,6 @@ static void buf_send_end(int err, void *user_data)
 	}
 }
 
-static void update_overwrite(struct net_buf *buf, uint8_t md)
-{
-	struct net_buf_simple_state state;
-	struct bt_mesh_ctl_friend_update *upd;
-
-	if (buf->len != 16) {
-		return;
-	}
-
-	net_buf_simple_save(&buf->b, &state);
-
-	net_buf_skip(buf, 1); /* skip IVI, NID */
-
-	if (!(net_buf_pull_u8(buf) >> 7)) {
-		goto end;
-	}
-
-	net_buf_skip(buf, 7); /* skip seqnum src dec*/
-
-	if (TRANS_CTL_OP((uint8_t *) net_buf_pull_mem(buf, 1))
-			!= TRANS_CTL_OP_FRIEND_UPDATE) {
-		goto end;
-	}
-
-	upd = net_buf_pull_mem(buf, sizeof(*upd));
-	BT_DBG("Update Previous Friend Update MD 0x%02x -> 0x%02x", upd->md, md);
-	upd->md = md;
-
-end:
-	net_buf_simple_restore(&buf->b, &state);
-}
-
 static void friend_timeout(struct k_work *work)
 {
 	struct bt_mesh_friend *frnd = CONTAINER_OF(work, struct bt_mesh_friend,
@@ -1176,6 +1541,7 @@ static void friend_timeout(struct k_work *work)
 		.end = buf_send_end,
 	};
 
+	struct net_buf *buf;
 	uint8_t md;
 
 	__ASSERT_NO_MSG(frnd->pending_buf == 0U);
@@ -1183,6 +1549,22 @@ static void friend_timeout(struct k_work *work)
 	BT_DBG("lpn 0x%04x send_last %u last %p", frnd->lpn,
 	       frnd->send_last, frnd->last);
 
+	if (frnd->bursting && !frnd->send_last) {
+		buf = friend_burst_next(frnd);
+		if (!buf) {
+			frnd->bursting = 0U;
+			k_delayed_work_submit(&frnd->timer,
+					      K_MSEC(frnd->poll_to));
+			return;
+		}
+
+		BT_DBG("Sending buf %p of burst to LPN 0x%04x", buf, frnd->lpn);
+		frnd->pending_buf = 1U;
+		frnd->sent++;
+		bt_mesh_adv_send(buf, &buf_sent_cb, frnd);
+		return;
+	}
+
 	if (frnd->send_last && frnd->last) {
 		BT_DBG("Sending frnd->last %p", frnd->last);
 		frnd->send_last = 0U;
@@ -1195,7 +1577,7 @@ static void friend_timeout(struct k_work *work)
 		return;
 	}
 
-	frnd->last = (void *)sys_slist_get(&frnd->queue);
+	frnd->last = friend_queue_get(frnd);
 	if (!frnd->last) {
 		BT_WARN("Friendship not established with 0x%04x",
 			frnd->lpn);
@@ -1203,9 +1585,12 @@ static void friend_timeout(struct k_work *work)
 		return;
 	}
 
-	md = (uint8_t)(sys_slist_peek_head(&frnd->queue) != NULL);
+	md = (uint8_t)(frnd->queue_size != 0U);
+	friend_drain_check(frnd);
 
-	update_overwrite(frnd->last, md);
+	/* A burst ends with a Friend Update */
+	frnd->burst_end = update_overwrite(frnd->last, md);
+	frnd->bursting = (frnd->burst && !frnd->burst_end);
 
 	if (encrypt_friend_pdu(frnd, frnd->last, false)) {
 		return;
@@ -1217,11 +1602,11 @@ static void friend_timeout(struct k_work *work)
 
 	BT_DBG("Sending buf %p from Friend Queue of LPN 0x%04x",
 	       frnd->last, frnd->lpn);
-	frnd->queue_size--;
 
 send_last:
 	frnd->pending_req = 0U;
 	frnd->pending_buf = 1U;
+	frnd->sent++;
 	bt_mesh_adv_send(frnd->last, &buf_sent_cb, frnd);
 }
 
@@ -1332,26 +1717,55 @@ end:
 static void friend_purge_old_ack(struct bt_mesh_friend *frnd,
 				 const uint64_t *seq_auth, uint16_t src)
 {
+	struct net_buf *old = NULL;
 	sys_snode_t *cur, *prev = NULL;
+	int i;
 
 	BT_DBG("SeqAuth %llx src 0x%04x", *seq_auth, src);
 
-	for (cur = sys_slist_peek_head(&frnd->queue);
-	     cur != NULL; prev = cur, cur = sys_slist_peek_next(cur)) {
-		struct net_buf *buf = (void *)cur;
+	/* The tracked acks spare the search of the queue, unless some didn't
+	 * fit in the tracker.
+	 */
+	for (i = 0; i < ARRAY_SIZE(frnd->acks); i++) {
+		struct net_buf *buf = frnd->acks[i];
 
-		if (is_segack(buf, seq_auth, src)) {
-			BT_DBG("Removing old ack from Friend Queue");
+		if (buf && is_segack(buf, seq_auth, src)) {
+			old = buf;
+			break;
+		}
+	}
 
-			sys_slist_remove(&frnd->queue, prev, cur);
-			frnd->queue_size--;
-			/* Make sure old slist entry state doesn't remain */
-			buf->frags = NULL;
+	if (old) {
+		friend_ack_untrack(frnd, old);
+		sys_slist_find_and_remove(&frnd->queue, &old->node);
+	} else if (frnd->acks_untracked) {
+		for (cur = sys_slist_peek_head(&frnd->queue);
+		     cur != NULL; prev = cur, cur = sys_slist_peek_next(cur)) {
+			struct net_buf *buf = (void *)cur;
 
-			net_buf_unref(buf);
-			break;
+			if (is_segack(buf, seq_auth, src)) {
+				sys_slist_remove(&frnd->queue, prev, cur);
+				old = buf;
+				break;
+			}
 		}
 	}
+
+	if (!old) {
+		return;
+	}
+
+	BT_DBG("Removing old ack from Friend Queue");
+
+	/* The buffer goes back to the pool right away, so that it doesn't
+	 * take up room the queue size doesn't account for.
+	 */
+	frnd->queue_size--;
+	frnd->superseded++;
+	/* Make sure old slist entry state doesn't remain */
+	old->frags = NULL;
+
+	net_buf_unref(old);
 }
 
 static void friend_lpn_enqueue_rx(struct bt_mesh_friend *frnd,
@@ -1400,6 +1814,10 @@ static void friend_lpn_enqueue_rx(struct bt_mesh_friend *frnd,
 
 	enqueue_friend_pdu(frnd, type, info.src, seg_count, buf);
 
+	if (type == BT_MESH_FRIEND_PDU_SINGLE && seq_auth) {
+		friend_ack_track(frnd, buf);
+	}
+
 	BT_DBG("Queued message for LPN 0x%04x, queue_size %u",
 	       frnd->lpn, frnd->queue_size);
 }
@@ -1445,47 +1863,22 @@ static void friend_lpn_enqueue_tx(struct bt_mesh_friend *frnd,
 
 	enqueue_friend_pdu(frnd, type, info.src, seg_count, buf);
 
-	BT_DBG("Queued message for LPN 0x%04x", frnd->lpn);
-}
-
-static bool friend_lpn_matches(struct bt_mesh_friend *frnd, uint16_t net_idx,
-			       uint16_t addr)
-{
-	int i;
-
-	if (!frnd->established) {
-		return false;
-	}
-
-	if (net_idx != frnd->subnet->net_idx) {
-		return false;
-	}
-
-	if (BT_MESH_ADDR_IS_UNICAST(addr)) {
-		return is_lpn_unicast(frnd, addr);
-	}
-
-	for (i = 0; i < ARRAY_SIZE(frnd->sub_list); i++) {
-		if (frnd->sub_list[i] == addr) {
-			return true;
-		}
+	if (type == BT_MESH_FRIEND_PDU_SINGLE && seq_auth) {
+		friend_ack_track(frnd, buf);
 	}
 
-	return false;
+	BT_DBG("Queued message for LPN 0x%04x", frnd->lpn);
 }
 
 bool bt_mesh_friend_match(uint16_t net_idx, uint16_t addr)
 {
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(bt_mesh.frnd); i++) {
-		struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
+	struct bt_mesh_friend *frnd;
+	uint16_t iter = 0U;
 
-		if (friend_lpn_matches(frnd, net_idx, addr)) {
-			BT_DBG("LPN 0x%04x matched address 0x%04x",
-			       frnd->lpn, addr);
-			return true;
-		}
+	frnd = friend_lpn_next(net_idx, addr, &iter);
+	if (frnd) {
+		BT_DBG("LPN 0x%04x matched address 0x%04x", frnd->lpn, addr);
+		return true;
 	}
 
 	BT_DBG("No matching LPN for address 0x%04x", addr);
@@ -1496,24 +1889,21 @@ bool bt_mesh_friend_match(uint16_t net_idx, uint16_t addr)
 static bool friend_queue_has_space(struct bt_mesh_friend *frnd, uint16_t addr,
 				   const uint64_t *seq_auth, uint8_t seg_count)
 {
-	uint32_t total = 0;
 	int i;
 
 	if (seg_count > CONFIG_BT_MESH_FRIEND_QUEUE_SIZE) {
 		return false;
 	}
 
-	for (i = 0; i < ARRAY_SIZE(frnd->seg); i++) {
+	for (i = 0; seq_auth && i < ARRAY_SIZE(frnd->seg); i++) {
 		struct bt_mesh_friend_seg *seg = &frnd->seg[i];
 
-		if (seq_auth && is_seg(seg, addr, *seq_auth & TRANS_SEQ_ZERO_MASK)) {
+		if (is_seg(seg, addr, *seq_auth & TRANS_SEQ_ZERO_MASK)) {
 			/* If there's a segment queue for this message then the
 			 * space verification has already happened.
 			 */
 			return true;
 		}
-
-		total += seg->seg_count;
 	}
 
 	/* If currently pending segments combined with this segmented message
@@ -1521,22 +1911,17 @@ static bool friend_queue_has_space(struct bt_mesh_friend *frnd, uint16_t addr,
 	 * is because we don't have a mechanism of aborting already pending
 	 * segmented messages to free up buffers.
 	 */
-	return (CONFIG_BT_MESH_FRIEND_QUEUE_SIZE - total) > seg_count;
+	return (CONFIG_BT_MESH_FRIEND_QUEUE_SIZE - frnd->seg_reserved) > seg_count;
 }
 
 bool bt_mesh_friend_queue_has_space(uint16_t net_idx, uint16_t src, uint16_t dst,
 				    uint64_t *seq_auth, uint8_t seg_count)
 {
 	bool someone_has_space = false, friend_match = false;
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(bt_mesh.frnd); i++) {
-		struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
-
-		if (!friend_lpn_matches(frnd, net_idx, dst)) {
-			continue;
-		}
+	struct bt_mesh_friend *frnd;
+	uint16_t iter = 0U;
 
+	while ((frnd = friend_lpn_next(net_idx, dst, &iter))) {
 		friend_match = true;
 
 		if (friend_queue_has_space(frnd, src, seq_auth, seg_count)) {
@@ -1573,14 +1958,14 @@ static bool friend_queue_prepare_space(struct bt_mesh_friend *frnd, uint16_t add
 	pending_segments = false;
 
 	while (pending_segments || avail_space < seg_count) {
-		struct net_buf *buf = (void *)sys_slist_get(&frnd->queue);
+		struct net_buf *buf = friend_queue_get(frnd);
 
 		if (!buf) {
 			BT_ERR("Unable to free up enough buffers");
 			return false;
 		}
 
-		frnd->queue_size--;
+		frnd->dropped++;
 		avail_space++;
 
 		pending_segments = (buf->flags & NET_BUF_FRAGS);
@@ -1600,7 +1985,8 @@ void bt_mesh_friend_enqueue_rx(struct bt_mesh_net_rx *rx,
 			       const uint64_t *seq_auth, uint8_t seg_count,
 			       struct net_buf_simple *sbuf)
 {
-	int i;
+	struct bt_mesh_friend *frnd;
+	uint16_t iter = 0U;
 
 	if (!rx->friend_match ||
 	    (rx->ctx.recv_ttl <= 1U && rx->net_if != BT_MESH_NET_IF_LOCAL) ||
@@ -1612,14 +1998,8 @@ void bt_mesh_friend_enqueue_rx(struct bt_mesh_net_rx *rx,
 	       rx->ctx.recv_ttl, rx->sub->net_idx, rx->ctx.addr,
 	       rx->ctx.recv_dst);
 
-	for (i = 0; i < ARRAY_SIZE(bt_mesh.frnd); i++) {
-		struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
-
-		if (!friend_lpn_matches(frnd, rx->sub->net_idx,
-					rx->ctx.recv_dst)) {
-			continue;
-		}
-
+	while ((frnd = friend_lpn_next(rx->sub->net_idx, rx->ctx.recv_dst,
+				       &iter))) {
 		if (!friend_queue_prepare_space(frnd, rx->ctx.addr, seq_auth,
 						seg_count)) {
 			continue;
@@ -1635,8 +2015,9 @@ bool bt_mesh_friend_enqueue_tx(struct bt_mesh_net_tx *tx,
 			       const uint64_t *seq_auth, uint8_t seg_count,
 			       struct net_buf_simple *sbuf)
 {
+	struct bt_mesh_friend *frnd;
 	bool matched = false;
-	int i;
+	uint16_t iter = 0U;
 
 	if (!bt_mesh_friend_match(tx->sub->net_idx, tx->ctx->addr) ||
 	    bt_mesh_friend_get() != BT_MESH_FRIEND_ENABLED) {
@@ -1646,14 +2027,8 @@ bool bt_mesh_friend_enqueue_tx(struct bt_mesh_net_tx *tx,
 	BT_DBG("net_idx 0x%04x dst 0x%04x src 0x%04x", tx->sub->net_idx,
 	       tx->ctx->addr, tx->src);
 
-	for (i = 0; i < ARRAY_SIZE(bt_mesh.frnd); i++) {
-		struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
-
-		if (!friend_lpn_matches(frnd, tx->sub->net_idx,
-					tx->ctx->addr)) {
-			continue;
-		}
-
+	while ((frnd = friend_lpn_next(tx->sub->net_idx, tx->ctx->addr,
+				       &iter))) {
 		if (!friend_queue_prepare_space(frnd, tx->src, seq_auth,
 						seg_count)) {
 			continue;
@@ -1684,18 +2059,14 @@ int bt_mesh_friend_terminate(uint16_t lpn_addr)
 void bt_mesh_friend_clear_incomplete(struct bt_mesh_subnet *sub, uint16_t src,
 				     uint16_t dst, uint64_t *seq_auth)
 {
-	int i;
+	struct bt_mesh_friend *frnd;
+	uint16_t iter = 0U;
 
 	BT_DBG("");
 
-	for (i = 0; i < ARRAY_SIZE(bt_mesh.frnd); i++) {
-		struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
+	while ((frnd = friend_lpn_next(sub->net_idx, dst, &iter))) {
 		int j;
 
-		if (!friend_lpn_matches(frnd, sub->net_idx, dst)) {
-			continue;
-		}
-
 		for (j = 0; j < ARRAY_SIZE(frnd->seg); j++) {
 			struct bt_mesh_friend_seg *seg = &frnd->seg[j];
 
@@ -1706,6 +2077,7 @@ void bt_mesh_friend_clear_incomplete(struct bt_mesh_subnet *sub, uint16_t src,
 			BT_WARN("Clearing incomplete segments for 0x%04x", src);
 
 			purge_buffers(&seg->queue);
+			frnd->seg_reserved -= seg->seg_count;
 			seg->seg_count = 0U;
 			break;
 		}
@@ -35,6 +35,19 @@
 #define LPN_AUTO_TIMEOUT 0
 #endif
 
+#if defined(CONFIG_BT_MESH_LPN_BURST)
+/* The Friend only queues the next PDU of a burst once the previous one has
+ * been advertised. It sends a single transmission, which takes a scan
+ * window plus the advertising interval and 10 ms of advertising delay. The
+ * interval is 100 ms on controllers before Bluetooth 5.0, which the LPN has
+ * to assume for the Friend.
+ */
+#define BURST_PDU_MS (BT_MESH_SCAN_WINDOW_MS + 100 + 10)
+#define BURST_WAIT (BURST_PDU_MS + CONFIG_BT_MESH_LPN_BURST_WAIT)
+#else
+#define BURST_WAIT 0
+#endif
+
 #define LPN_RECV_DELAY            CONFIG_BT_MESH_LPN_RECV_DELAY
 #define SCAN_LATENCY              MIN(CONFIG_BT_MESH_LPN_SCAN_LATENCY, \
 				      LPN_RECV_DELAY)
@@ -65,7 +78,9 @@
 
 #define LPN_CRITERIA ((CONFIG_BT_MESH_LPN_MIN_QUEUE_SIZE) | \
 		      (CONFIG_BT_MESH_LPN_RSSI_FACTOR << 3) | \
-		      (CONFIG_BT_MESH_LPN_RECV_WIN_FACTOR << 5))
+		      (CONFIG_BT_MESH_LPN_RECV_WIN_FACTOR << 5) | \
+		      (IS_ENABLED(CONFIG_BT_MESH_LPN_BURST) ? \
+		       BT_MESH_FRIEND_CRIT_BURST : 0))
 
 #define POLL_TO(to) { (uint8_t)((to) >> 16), (uint8_t)((to) >> 8), (uint8_t)(to) }
 #define LPN_POLL_TO POLL_TO(CONFIG_BT_MESH_LPN_POLL_TIMEOUT)
@@ -148,6 +163,32 @@ static inline void group_clear(atomic_t *target, atomic_t *source)
 #endif
 }
 
+/* Scanning is what the LPN spends most of its energy on, so keep track of
+ * the time it's enabled.
+ */
+static void scan_enable(void)
+{
+	struct bt_mesh_lpn *lpn = &bt_mesh.lpn;
+
+	if (!lpn->scan_start) {
+		lpn->scan_start = MAX(k_uptime_get_32(), 1U);
+	}
+
+	bt_mesh_scan_enable();
+}
+
+static void scan_disable(void)
+{
+	struct bt_mesh_lpn *lpn = &bt_mesh.lpn;
+
+	if (lpn->scan_start) {
+		lpn->scan_ms += k_uptime_get_32() - lpn->scan_start;
+		lpn->scan_start = 0U;
+	}
+
+	bt_mesh_scan_disable();
+}
+
 static void clear_friendship(bool force, bool disable);
 
 static void friend_clear_sent(int err, void *user_data)
@@ -236,6 +277,9 @@ static void clear_friendship(bool force, bool disable)
 	lpn->sent_req = 0U;
 	lpn->established = 0U;
 	lpn->clear_success = 0U;
+	lpn->burst = 0U;
+	lpn->burst_rx = 0U;
+	lpn->drain_start = 0U;
 	lpn->sub = NULL;
 
 	group_zero(lpn->added);
@@ -330,6 +374,10 @@ static void req_sent(uint16_t duration, int err, void *user_data)
 		return;
 	}
 
+	if (lpn->sent_req == TRANS_CTL_OP_FRIEND_POLL) {
+		lpn->polls++;
+	}
+
 	Z_STRUCT_SECTION_FOREACH(bt_mesh_lpn_cb, cb) {
 		if (cb->polled) {
 			cb->polled(lpn->sub->net_idx, lpn->frnd, !!(lpn->req_attempts));
@@ -433,7 +481,7 @@ int bt_mesh_lpn_set(bool enable)
 		lpn_set_state(BT_MESH_LPN_ENABLED);
 
 		if (IS_ENABLED(CONFIG_BT_MESH_LPN_ESTABLISHMENT)) {
-			bt_mesh_scan_disable();
+			scan_disable();
 		}
 
 		send_friend_req(lpn);
@@ -454,15 +502,33 @@ static void friend_response_received(struct bt_mesh_lpn *lpn)
 {
 	BT_DBG("lpn->sent_req 0x%02x", lpn->sent_req);
 
-	if (lpn->sent_req == TRANS_CTL_OP_FRIEND_POLL) {
+	/* A burst is only acknowledged once the Friend Update ending it
+	 * has come in.
+	 */
+	if (lpn->sent_req == TRANS_CTL_OP_FRIEND_POLL || lpn->burst_rx) {
 		lpn->fsn++;
 	}
 
 	k_delayed_work_cancel(&lpn->timer);
-	bt_mesh_scan_disable();
+	scan_disable();
 	lpn_set_state(BT_MESH_LPN_ESTABLISHED);
 	lpn->req_attempts = 0U;
 	lpn->sent_req = 0U;
+	lpn->burst_rx = 0U;
+}
+
+/* Keep scanning for the rest of a burst from the Friend. The FSN stays
+ * until the Friend Update ending the burst, so that the Friend repeats
+ * the whole burst if that doesn't come.
+ */
+static void burst_recv(struct bt_mesh_lpn *lpn)
+{
+	if (lpn->sent_req == TRANS_CTL_OP_FRIEND_POLL) {
+		lpn->sent_req = 0U;
+		lpn->burst_rx = 1U;
+	}
+
+	k_delayed_work_submit(&lpn->timer, K_MSEC(BURST_WAIT));
 }
 
 void bt_mesh_lpn_msg_received(struct bt_mesh_net_rx *rx)
@@ -475,11 +541,22 @@ void bt_mesh_lpn_msg_received(struct bt_mesh_net_rx *rx)
 		return;
 	}
 
-	if (lpn->sent_req != TRANS_CTL_OP_FRIEND_POLL) {
+	if (lpn->sent_req != TRANS_CTL_OP_FRIEND_POLL && !lpn->burst_rx) {
 		BT_WARN("Unexpected message withouth a preceding Poll");
 		return;
 	}
 
+	lpn->pdus++;
+
+	if (lpn->sent_req == TRANS_CTL_OP_FRIEND_POLL && !lpn->drain_start) {
+		lpn->drain_start = MAX(k_uptime_get_32(), 1U);
+	}
+
+	if (lpn->burst) {
+		burst_recv(lpn);
+		return;
+	}
+
 	friend_response_received(lpn);
 
 	BT_DBG("Requesting more messages from Friend");
@@ -729,14 +806,29 @@ static bool sub_update(uint8_t op)
 
 static void update_timeout(struct bt_mesh_lpn *lpn)
 {
+	/* Polling again with the same FSN has the Friend repeat the burst.
+	 * The attempts are only reset by the Friend Update ending it.
+	 */
+	if (lpn->burst_rx) {
+		lpn->burst_rx = 0U;
+
+		if (lpn->req_attempts < REQ_ATTEMPTS(lpn)) {
+			BT_WARN("Incomplete burst from Friend, polling again");
+			scan_disable();
+			lpn_set_state(BT_MESH_LPN_ESTABLISHED);
+			send_friend_poll();
+			return;
+		}
+	}
+
 	if (lpn->established) {
 		BT_WARN("No response from Friend during ReceiveWindow");
-		bt_mesh_scan_disable();
+		scan_disable();
 		lpn_set_state(BT_MESH_LPN_ESTABLISHED);
 		k_delayed_work_submit(&lpn->timer, K_MSEC(POLL_RETRY_TIMEOUT));
 	} else {
 		if (IS_ENABLED(CONFIG_BT_MESH_LPN_ESTABLISHMENT)) {
-			bt_mesh_scan_disable();
+			scan_disable();
 		}
 
 		if (lpn->req_attempts < REQ_ATTEMPTS(lpn)) {
@@ -770,14 +862,14 @@ static void lpn_timeout(struct k_work *work)
 		BT_DBG("Starting to look for Friend nodes");
 		lpn_set_state(BT_MESH_LPN_ENABLED);
 		if (IS_ENABLED(CONFIG_BT_MESH_LPN_ESTABLISHMENT)) {
-			bt_mesh_scan_disable();
+			scan_disable();
 		}
 		__fallthrough;
 	case BT_MESH_LPN_ENABLED:
 		send_friend_req(lpn);
 		break;
 	case BT_MESH_LPN_REQ_WAIT:
-		bt_mesh_scan_enable();
+		scan_enable();
 		k_delayed_work_submit(&lpn->timer, K_MSEC(lpn->adv_duration +
 							  FRIEND_REQ_SCAN));
 		lpn_set_state(BT_MESH_LPN_WAIT_OFFER);
@@ -785,7 +877,7 @@ static void lpn_timeout(struct k_work *work)
 	case BT_MESH_LPN_WAIT_OFFER:
 		BT_WARN("No acceptable Friend Offers received");
 		if (IS_ENABLED(CONFIG_BT_MESH_LPN_ESTABLISHMENT)) {
-			bt_mesh_scan_disable();
+			scan_disable();
 		}
 		lpn->lpn_counter++;
 		lpn_set_state(BT_MESH_LPN_ENABLED);
@@ -816,7 +908,7 @@ static void lpn_timeout(struct k_work *work)
 		k_delayed_work_submit(&lpn->timer,
 				      K_MSEC(lpn->adv_duration + SCAN_LATENCY +
 					     lpn->recv_win));
-		bt_mesh_scan_enable();
+		scan_enable();
 		lpn_set_state(BT_MESH_LPN_WAIT_UPDATE);
 		break;
 	case BT_MESH_LPN_WAIT_UPDATE:
@@ -957,7 +1049,7 @@ int bt_mesh_lpn_friend_update(struct bt_mesh_net_rx *rx,
 		return -EINVAL;
 	}
 
-	if (lpn->sent_req != TRANS_CTL_OP_FRIEND_POLL) {
+	if (lpn->sent_req != TRANS_CTL_OP_FRIEND_POLL && !lpn->burst_rx) {
 		BT_WARN("Unexpected friend update");
 		return 0;
 	}
@@ -1002,6 +1094,11 @@ int bt_mesh_lpn_friend_update(struct bt_mesh_net_rx *rx,
 					POLL_TIMEOUT_INIT);
 	}
 
+	lpn->burst = (IS_ENABLED(CONFIG_BT_MESH_LPN_BURST) &&
+		      (msg->flags & BT_MESH_FRIEND_FLAG_BURST));
+
+	/* A burst always ends with a Friend Update */
+	lpn->pdus++;
 	friend_response_received(lpn);
 
 	iv_index = sys_be32_to_cpu(msg->iv_index);
@@ -1012,6 +1109,12 @@ int bt_mesh_lpn_friend_update(struct bt_mesh_net_rx *rx,
 	bt_mesh_kr_update(sub, BT_MESH_KEY_REFRESH(msg->flags), rx->new_key);
 	bt_mesh_net_iv_update(iv_index, BT_MESH_IV_UPDATE(msg->flags));
 
+	if (lpn->drain_start && !msg->md) {
+		lpn->drain_ms = k_uptime_get_32() - lpn->drain_start;
+		lpn->drain_max_ms = MAX(lpn->drain_max_ms, lpn->drain_ms);
+		lpn->drain_start = 0U;
+	}
+
 	if (lpn->groups_changed) {
 		sub_update(TRANS_CTL_OP_FRIEND_SUB_ADD);
 		sub_update(TRANS_CTL_OP_FRIEND_SUB_REM);
@@ -1076,9 +1179,9 @@ int bt_mesh_lpn_init(void)
 
 	if (lpn->state == BT_MESH_LPN_ENABLED) {
 		if (IS_ENABLED(CONFIG_BT_MESH_LPN_ESTABLISHMENT)) {
-			bt_mesh_scan_disable();
+			scan_disable();
 		} else {
-			bt_mesh_scan_enable();
+			scan_enable();
 		}
 
 		send_friend_req(lpn);
@@ -38,6 +38,7 @@
 #include "foundation.h"
 #include "proxy.h"
 #include "settings.h"
+#include "stats.h"
 #include "mesh.h"
 
 int bt_mesh_provision(const uint8_t net_key[16], uint16_t net_idx,
@@ -178,6 +179,7 @@ void bt_mesh_reset(void)
 	bt_mesh_net_keys_reset();
 
 	bt_mesh_net_loopback_clear(BT_MESH_KEY_ANY);
+	bt_mesh_net_relay_clear();
 
 	if (IS_ENABLED(CONFIG_BT_MESH_LOW_POWER)) {
 		if (IS_ENABLED(CONFIG_BT_MESH_LPN_SUB_ALL_NODES_ADDR)) {
@@ -333,6 +335,10 @@ int bt_mesh_init(const struct bt_mesh_prov *prov,
 	bt_mesh_beacon_init();
 	bt_mesh_adv_init();
 
+	if (IS_ENABLED(CONFIG_BT_MESH_STATS)) {
+		bt_mesh_stats_init();
+	}
+
 	if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
 		bt_mesh_settings_init();
 	}
@@ -38,6 +38,7 @@
 #include "settings.h"
 #include "prov.h"
 #include "cfg.h"
+#include "stats.h"
 
 /* Minimum valid Mesh Network PDU length. The Network headers
  * themselves take up 9 bytes. After that there is a minimum of 1 byte
@@ -62,11 +63,31 @@
 #define SRC(pdu)           (sys_get_be16(&(pdu)[5]))
 #define DST(pdu)           (sys_get_be16(&(pdu)[7]))
 
-static struct {
-	uint32_t src : 15, /* MSb of source is always 0 */
-	      seq : 17;
-} msg_cache[CONFIG_BT_MESH_MSG_CACHE_SIZE];
-static uint16_t msg_cache_next;
+/* Entry index terminating a hash chain */
+#define CACHE_NONE 0xffff
+/* Entry index of an entry that is in no hash chain */
+#define CACHE_FREE 0xfffe
+
+BUILD_ASSERT(CONFIG_BT_MESH_MSG_CACHE_SIZE < CACHE_FREE);
+
+/* FIFO of recently seen 32 bit keys with a hash chain per bucket, so that
+ * the lookup cost does not depend on the cache size.
+ */
+struct net_cache {
+	uint16_t next;   /* Entry to overwrite next */
+	uint16_t bucket[CONFIG_BT_MESH_MSG_CACHE_SIZE];
+	uint16_t chain[CONFIG_BT_MESH_MSG_CACHE_SIZE];
+	uint32_t key[CONFIG_BT_MESH_MSG_CACHE_SIZE];
+	struct bt_mesh_net_cache_stats stats;
+};
+
+#define NET_CACHE_INIT { \
+	.bucket = { [0 ... (CONFIG_BT_MESH_MSG_CACHE_SIZE - 1)] = CACHE_NONE }, \
+	.chain = { [0 ... (CONFIG_BT_MESH_MSG_CACHE_SIZE - 1)] = CACHE_FREE }, \
+}
+
+/* Network Message Cache, keyed on 15 bit SRC and 17 bit SEQ */
+static struct net_cache msg_cache = NET_CACHE_INIT;
 
 /* Singleton network context (the implementation only supports one) */
 struct bt_mesh_net bt_mesh = {
@@ -76,38 +97,335 @@ struct bt_mesh_net bt_mesh = {
 NET_BUF_POOL_DEFINE(loopback_buf_pool, CONFIG_BT_MESH_LOOPBACK_BUFS,
 		    LOOPBACK_MAX_PDU_LEN, LOOPBACK_USER_DATA_SIZE, NULL);
 
-static uint32_t dup_cache[CONFIG_BT_MESH_MSG_CACHE_SIZE];
-static int   dup_cache_next;
+/* Duplicate filter of encrypted PDUs, keyed on the PDU's last 8 bytes */
+static struct net_cache dup_cache = NET_CACHE_INIT;
 
-static bool check_dup(struct net_buf_simple *data)
+static inline uint16_t cache_bucket(uint32_t key)
+{
+	/* Fibonacci hashing spreads the mostly sequential SEQ values */
+	return ((key * 2654435761U) >> 16) % CONFIG_BT_MESH_MSG_CACHE_SIZE;
+}
+
+static bool cache_find(struct net_cache *cache, uint32_t key)
+{
+	uint16_t i;
+
+	for (i = cache->bucket[cache_bucket(key)]; i != CACHE_NONE;
+	     i = cache->chain[i]) {
+		if (cache->key[i] == key) {
+			cache->stats.hit++;
+			return true;
+		}
+	}
+
+	cache->stats.miss++;
+	return false;
+}
+
+static void cache_unlink(struct net_cache *cache, uint16_t idx)
+{
+	uint16_t *i;
+
+	if (cache->chain[idx] == CACHE_FREE) {
+		return;
+	}
+
+	for (i = &cache->bucket[cache_bucket(cache->key[idx])]; *i != idx;
+	     i = &cache->chain[*i]) {
+	}
+
+	*i = cache->chain[idx];
+	cache->chain[idx] = CACHE_FREE;
+}
+
+static uint16_t cache_add(struct net_cache *cache, uint32_t key)
+{
+	uint16_t idx = cache->next;
+	uint16_t *bucket;
+
+	if (cache->chain[idx] != CACHE_FREE) {
+		cache_unlink(cache, idx);
+		cache->stats.evicted++;
+	}
+
+	bucket = &cache->bucket[cache_bucket(key)];
+	cache->key[idx] = key;
+	cache->chain[idx] = *bucket;
+	*bucket = idx;
+
+	cache->next = (idx + 1) % CONFIG_BT_MESH_MSG_CACHE_SIZE;
+
+	return idx;
+}
+
+static void cache_clear(struct net_cache *cache)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_BT_MESH_MSG_CACHE_SIZE; i++) {
+		cache->bucket[i] = CACHE_NONE;
+		cache->chain[i] = CACHE_FREE;
+	}
+
+	cache->next = 0U;
+}
+
+static inline uint32_t dup_cache_key(struct net_buf_simple *data)
 {
 	const uint8_t *tail = net_buf_simple_tail(data);
-	uint32_t val;
+
+	return sys_get_be32(tail - 4) ^ sys_get_be32(tail - 8);
+}
+
+static inline uint32_t msg_cache_key(uint16_t src, uint32_t seq)
+{
+	/* MSb of source is always 0 */
+	return ((uint32_t)(src & BIT_MASK(15)) << 17) | (seq & BIT_MASK(17));
+}
+
+static struct bt_mesh_net_relay_stats relay_stats;
+static struct bt_mesh_net_rx_stats rx_stats;
+
+#if defined(CONFIG_BT_MESH_RELAY_SUPPRESS)
+/* Relayed message waiting for its backoff */
+struct relay_pending {
+	struct net_buf *buf;    /* NULL if unused */
+	uint32_t msg_key;       /* Message cache key of the message */
+	uint32_t dup_key;       /* Duplicate filter key of the relayed PDU */
+	uint8_t copies;         /* Copies heard from other relays */
+	struct k_delayed_work timer;
+};
+
+static struct {
+	uint8_t threshold;
+	uint16_t max_delay;
+	struct relay_pending pending[CONFIG_BT_MESH_RELAY_SUPPRESS_COUNT];
+} relay = {
+	.threshold = CONFIG_BT_MESH_RELAY_SUPPRESS_THRESHOLD,
+	.max_delay = CONFIG_BT_MESH_RELAY_SUPPRESS_DELAY,
+};
+
+static void relay_pending_free(struct relay_pending *pending)
+{
+	net_buf_unref(pending->buf);
+	pending->buf = NULL;
+}
+
+static void relay_timeout(struct k_work *work)
+{
+	struct relay_pending *pending = CONTAINER_OF(work,
+						     struct relay_pending,
+						     timer.work);
+
+	if (!pending->buf) {
+		return;
+	}
+
+	if (relay.threshold && pending->copies >= relay.threshold) {
+		relay_stats.suppressed++;
+		bt_mesh_stats_evt(BT_MESH_STATS_RELAY_SUPPRESSED, 0);
+	} else {
+		relay_stats.relayed++;
+		bt_mesh_stats_evt(BT_MESH_STATS_RELAY_SENT, 0);
+		bt_mesh_adv_send(pending->buf, NULL, NULL);
+	}
+
+	relay_pending_free(pending);
+}
+
+static uint32_t relay_backoff(int8_t rssi)
+{
+	uint32_t max = relay.max_delay;
+	uint32_t min = 0U;
+	uint16_t rand;
+
+	/* Messages heard well from a near sender get up to half of the
+	 * backoff added, from -100 dBm on to -40 dBm.
+	 */
+	if (IS_ENABLED(CONFIG_BT_MESH_RELAY_SUPPRESS_RSSI)) {
+		min = (max / 2U) * CLAMP(rssi + 100, 0, 60) / 60U;
+	}
+
+	(void)bt_rand(&rand, sizeof(rand));
+
+	return min + rand % (max - min + 1U);
+}
+
+/* Hold the relayed message for a random backoff, returns false if it is to
+ * be sent right away.
+ */
+static bool relay_delay(struct net_buf *buf, struct bt_mesh_net_rx *rx)
+{
+	struct relay_pending *pending = NULL;
 	int i;
 
-	val = sys_get_be32(tail - 4) ^ sys_get_be32(tail - 8);
+	if (!relay.threshold || rx->net_if != BT_MESH_NET_IF_ADV ||
+	    rx->friend_cred) {
+		return false;
+	}
 
-	for (i = 0; i < ARRAY_SIZE(dup_cache); i++) {
-		if (dup_cache[i] == val) {
-			return true;
+	for (i = 0; i < ARRAY_SIZE(relay.pending); i++) {
+		if (!relay.pending[i].buf) {
+			pending = &relay.pending[i];
+			break;
+		}
+	}
+
+	if (!pending) {
+		BT_DBG("No room to delay the relay");
+		return false;
+	}
+
+	pending->buf = net_buf_ref(buf);
+	pending->msg_key = msg_cache_key(rx->ctx.addr, rx->seq);
+	pending->dup_key = dup_cache_key(&buf->b);
+	pending->copies = 0U;
+
+	/* Relays at the same hop send the very same PDU */
+	cache_add(&dup_cache, pending->dup_key);
+
+	k_delayed_work_submit(&pending->timer,
+			      K_MSEC(relay_backoff(rx->ctx.recv_rssi)));
+
+	return true;
+}
+
+/* Another relay was heard sending the message with the given message cache
+ * or duplicate filter key.
+ */
+static void relay_copy_heard(uint32_t key, bool dup)
+{
+	int i;
+
+	if (!relay.threshold) {
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(relay.pending); i++) {
+		struct relay_pending *pending = &relay.pending[i];
+
+		if (!pending->buf ||
+		    key != (dup ? pending->dup_key : pending->msg_key)) {
+			continue;
+		}
+
+		if (++pending->copies < relay.threshold) {
+			return;
 		}
+
+		BT_DBG("Relay suppressed after %u copies", pending->copies);
+
+		if (!k_delayed_work_cancel(&pending->timer)) {
+			relay_stats.suppressed++;
+			bt_mesh_stats_evt(BT_MESH_STATS_RELAY_SUPPRESSED, 0);
+			relay_pending_free(pending);
+		}
+
+		return;
 	}
+}
 
-	dup_cache[dup_cache_next++] = val;
-	dup_cache_next %= ARRAY_SIZE(dup_cache);
+int bt_mesh_relay_suppress_set(uint8_t threshold, uint16_t max_delay)
+{
+	if (max_delay > 1000) {
+		return -EINVAL;
+	}
+
+	relay.threshold = threshold;
+	relay.max_delay = max_delay;
+
+	return 0;
+}
+
+void bt_mesh_net_relay_clear(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(relay.pending); i++) {
+		k_delayed_work_cancel(&relay.pending[i].timer);
+
+		if (relay.pending[i].buf) {
+			relay_pending_free(&relay.pending[i]);
+		}
+	}
+}
+
+static void relay_init(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(relay.pending); i++) {
+		k_delayed_work_init(&relay.pending[i].timer, relay_timeout);
+	}
+}
+#else
+static inline bool relay_delay(struct net_buf *buf, struct bt_mesh_net_rx *rx)
+{
+	return false;
+}
+
+static inline void relay_copy_heard(uint32_t key, bool dup)
+{
+}
+
+int bt_mesh_relay_suppress_set(uint8_t threshold, uint16_t max_delay)
+{
+	return -ENOTSUP;
+}
+
+void bt_mesh_net_relay_clear(void)
+{
+}
+
+static inline void relay_init(void)
+{
+}
+#endif /* CONFIG_BT_MESH_RELAY_SUPPRESS */
+
+void bt_mesh_net_relay_stats_get(struct bt_mesh_net_relay_stats *stats)
+{
+	*stats = relay_stats;
+}
+
+void bt_mesh_net_rx_stats_get(struct bt_mesh_net_rx_stats *stats)
+{
+	*stats = rx_stats;
+}
+
+void bt_mesh_net_rx_alloced(void)
+{
+	rx_stats.alloc++;
+}
+
+void bt_mesh_net_rx_copied(size_t len)
+{
+	rx_stats.copy++;
+	rx_stats.copy_bytes += len;
+}
+
+static bool check_dup(struct net_buf_simple *data)
+{
+	uint32_t val = dup_cache_key(data);
+
+	if (cache_find(&dup_cache, val)) {
+		relay_copy_heard(val, true);
+		bt_mesh_stats_evt(BT_MESH_STATS_DUP_DROP, 0);
+		return true;
+	}
+
+	cache_add(&dup_cache, val);
 
 	return false;
 }
 
 static bool msg_cache_match(struct net_buf_simple *pdu)
 {
-	uint16_t i;
+	uint32_t key = msg_cache_key(SRC(pdu->data), SEQ(pdu->data));
 
-	for (i = 0U; i < ARRAY_SIZE(msg_cache); i++) {
-		if (msg_cache[i].src == SRC(pdu->data) &&
-		    msg_cache[i].seq == (SEQ(pdu->data) & BIT_MASK(17))) {
-			return true;
-		}
+	if (cache_find(&msg_cache, key)) {
+		relay_copy_heard(key, false);
+		bt_mesh_stats_evt(BT_MESH_STATS_CACHE_DROP, 0);
+		return true;
 	}
 
 	return false;
@@ -115,10 +433,15 @@ static bool msg_cache_match(struct net_buf_simple *pdu)
 
 static void msg_cache_add(struct bt_mesh_net_rx *rx)
 {
-	rx->msg_cache_idx = msg_cache_next++;
-	msg_cache[rx->msg_cache_idx].src = rx->ctx.addr;
-	msg_cache[rx->msg_cache_idx].seq = rx->seq;
-	msg_cache_next %= ARRAY_SIZE(msg_cache);
+	rx->msg_cache_idx = cache_add(&msg_cache,
+				      msg_cache_key(rx->ctx.addr, rx->seq));
+}
+
+void bt_mesh_net_cache_stats_get(struct bt_mesh_net_cache_stats *msg,
+				 struct bt_mesh_net_cache_stats *dup)
+{
+	*msg = msg_cache.stats;
+	*dup = dup_cache.stats;
 }
 
 int bt_mesh_net_create(uint16_t idx, uint8_t flags, const uint8_t key[16],
@@ -141,8 +464,7 @@ int bt_mesh_net_create(uint16_t idx, uint8_t flags, const uint8_t key[16],
 		return err;
 	}
 
-	(void)memset(msg_cache, 0, sizeof(msg_cache));
-	msg_cache_next = 0U;
+	cache_clear(&msg_cache);
 
 	bt_mesh.iv_index = iv_index;
 	atomic_set_bit_to(bt_mesh.flags, BT_MESH_IVU_IN_PROGRESS,
@@ -398,12 +720,12 @@ static int net_encrypt(struct net_buf_simple *buf,
 {
 	int err;
 
-	err = bt_mesh_net_encrypt(cred->enc, buf, iv_index, proxy);
+	err = bt_mesh_net_encrypt(&cred->enc, buf, iv_index, proxy);
 	if (err) {
 		return err;
 	}
 
-	return bt_mesh_net_obfuscate(buf->data, iv_index, cred->privacy);
+	return bt_mesh_net_obfuscate(buf->data, iv_index, &cred->privacy);
 }
 
 int bt_mesh_net_encode(struct bt_mesh_net_tx *tx, struct net_buf_simple *buf,
@@ -550,11 +872,17 @@ static bool net_decrypt(struct bt_mesh_net_rx *rx, struct net_buf_simple *in,
 
 	rx->old_iv = (IVI(in->data) != (bt_mesh.iv_index & 0x01));
 
-	net_buf_simple_reset(out);
-	net_buf_simple_add_mem(out, in->data, in->len);
+	if (in->len > out->size) {
+		BT_WARN("Too long mesh packet (len %u)", in->len);
+		return false;
+	}
 
-	if (bt_mesh_net_obfuscate(out->data, BT_MESH_NET_IVI_RX(rx),
-				  cred->privacy)) {
+	/* Only the header is written here, the rest of the PDU is decrypted
+	 * straight from the input buffer once the cheap checks have passed.
+	 */
+	net_buf_simple_reset(out);
+	if (bt_mesh_net_deobfuscate(in->data, net_buf_simple_add(out, 7),
+				    BT_MESH_NET_IVI_RX(rx), &cred->privacy)) {
 		return false;
 	}
 
@@ -576,7 +904,7 @@ static bool net_decrypt(struct bt_mesh_net_rx *rx, struct net_buf_simple *in,
 
 	BT_DBG("src 0x%04x", rx->ctx.addr);
 
-	return bt_mesh_net_decrypt(cred->enc, out, BT_MESH_NET_IVI_RX(rx),
+	return bt_mesh_net_decrypt(&cred->enc, in, out, BT_MESH_NET_IVI_RX(rx),
 				   proxy) == 0;
 }
 
@@ -628,9 +956,11 @@ static void bt_mesh_net_relay(struct net_buf_simple *sbuf,
 		transmit = bt_mesh_net_transmit_get();
 	}
 
-	buf = bt_mesh_adv_create(BT_MESH_ADV_DATA, transmit, K_NO_WAIT);
+	buf = bt_mesh_adv_create(BT_MESH_ADV_DATA, BT_MESH_RELAY_ADV,
+				 transmit, K_NO_WAIT);
 	if (!buf) {
 		BT_ERR("Out of relay buffers");
+		bt_mesh_stats_evt(BT_MESH_STATS_RELAY_NO_BUF, 0);
 		return;
 	}
 
@@ -639,6 +969,8 @@ static void bt_mesh_net_relay(struct net_buf_simple *sbuf,
 	sbuf->data[1] |= rx->ctx.recv_ttl - 1U;
 
 	net_buf_add_mem(buf, sbuf->data, sbuf->len);
+	bt_mesh_net_rx_alloced();
+	bt_mesh_net_rx_copied(sbuf->len);
 
 	cred = &rx->sub->keys[SUBNET_KEY_TX_IDX(rx->sub)].msg;
 
@@ -669,7 +1001,10 @@ static void bt_mesh_net_relay(struct net_buf_simple *sbuf,
 		bt_mesh_proxy_relay(&buf->b, rx->ctx.recv_dst);
 	}
 
-	if (relay_to_adv(rx->net_if) || rx->friend_cred) {
+	if ((relay_to_adv(rx->net_if) || rx->friend_cred) &&
+	    !relay_delay(buf, rx)) {
+		relay_stats.relayed++;
+		bt_mesh_stats_evt(BT_MESH_STATS_RELAY_SENT, 0);
 		bt_mesh_adv_send(buf, NULL, NULL);
 	}
 
@@ -786,9 +1121,9 @@ void bt_mesh_net_recv(struct net_buf_simple *data, int8_t rssi,
 	 */
 	if (bt_mesh_trans_recv(&buf, &rx,rssi) == -EAGAIN) {
 		BT_WARN("Removing rejected message from Network Message Cache");
-		msg_cache[rx.msg_cache_idx].src = BT_MESH_ADDR_UNASSIGNED;
+		cache_unlink(&msg_cache, rx.msg_cache_idx);
 		/* Rewind the next index now that we're not using this entry */
-		msg_cache_next = rx.msg_cache_idx;
+		msg_cache.next = rx.msg_cache_idx;
 	}
 
 	/* Relay if this was a group/virtual address, or if the destination
@@ -832,4 +1167,6 @@ void bt_mesh_net_init(void)
 	k_delayed_work_init(&bt_mesh.ivu_timer, ivu_refresh);
 
 	k_work_init(&bt_mesh.local_work, bt_mesh_net_local);
+
+	relay_init();
 }
@@ -29,9 +29,21 @@ struct bt_mesh_node {
 #if defined(CONFIG_BT_MESH_FRIEND)
 #define FRIEND_SEG_RX CONFIG_BT_MESH_FRIEND_SEG_RX
 #define FRIEND_SUB_LIST_SIZE CONFIG_BT_MESH_FRIEND_SUB_LIST_SIZE
+/* Segment Acknowledgments to an LPN tracked for replacement. The LPN only
+ * sends a few segmented messages at a time, so they usually all fit.
+ */
+#define FRIEND_ACKS 2
+/* PDUs sent after the first one in response to a Friend Poll, the last of
+ * them being the Friend Update that ends the burst. A burst of two would
+ * only add that Friend Update, so it isn't offered.
+ */
+#define FRIEND_BURST (CONFIG_BT_MESH_FRIEND_BURST > 2 ? \
+		      CONFIG_BT_MESH_FRIEND_BURST - 1 : 0)
 #else
 #define FRIEND_SEG_RX 0
 #define FRIEND_SUB_LIST_SIZE 0
+#define FRIEND_ACKS 0
+#define FRIEND_BURST 0
 #endif
 
 struct bt_mesh_friend {
@@ -41,7 +53,11 @@ struct bt_mesh_friend {
 	      send_last:1,
 	      pending_req:1,
 	      pending_buf:1,
-	      established:1;
+	      established:1,
+	      acks_untracked:1;
+	uint8_t  burst:1,       /* LPN takes several PDUs per Poll */
+	      bursting:1,    /* Sending the rest of a burst */
+	      burst_end:1;   /* Burst ended with a Friend Update */
 	int32_t poll_to;
 	uint8_t  num_elem;
 	uint16_t lpn_counter;
@@ -58,6 +74,10 @@ struct bt_mesh_friend {
 	struct bt_mesh_friend_seg {
 		sys_slist_t queue;
 
+		/* Message the segments belong to */
+		uint16_t       src;
+		uint16_t       seq_zero;
+
 		/* The target number of segments, i.e. not necessarily
 		 * the current number of segments, in the queue. This is
 		 * used for Friend Queue free space calculations.
@@ -65,11 +85,39 @@ struct bt_mesh_friend {
 		uint8_t        seg_count;
 	} seg[FRIEND_SEG_RX];
 
+	/* Sum of the seg_count of all segment lists */
+	uint16_t seg_reserved;
+
 	struct net_buf *last;
 
+	/* PDUs sent after last in response to the same Friend Poll, kept
+	 * until the next Poll acknowledges them.
+	 */
+	struct net_buf *burst_buf[FRIEND_BURST];
+	uint8_t burst_len;
+	uint8_t burst_next;     /* Next of them to send */
+
 	sys_slist_t queue;
 	uint32_t queue_size;
 
+	/* Segment Acknowledgments in the queue, so that a newer one for the
+	 * same message finds them without decoding every queued PDU.
+	 */
+	struct net_buf *acks[FRIEND_ACKS];
+
+	/* Friend Queue accounting */
+	uint32_t queue_max;     /* Most PDUs queued at once */
+	uint32_t dropped;       /* PDUs dropped to make room */
+	uint32_t superseded;    /* Acks replaced by newer ones */
+
+	/* Friend Poll accounting */
+	uint32_t polls;         /* Friend Polls answered */
+	uint32_t sent;          /* PDUs sent to the LPN */
+	uint32_t repeated;      /* Polls asking for the same PDUs again */
+	uint32_t drain_ms;      /* Time the last backlog took to send */
+	uint32_t drain_max_ms;
+	uint32_t drain_start;   /* Uptime of the Poll that found it, or 0 */
+
 	/* Friend Clear Procedure */
 	struct {
 		uint32_t start;                  /* Clear Procedure start */
@@ -121,7 +169,9 @@ struct bt_mesh_lpn {
 	      disable:1,        /* Disable LPN after clearing */
 	      fsn:1,            /* Friend Sequence Number */
 	      established:1,    /* Friendship established */
-	      clear_success:1;  /* Friend Clear Confirm received */
+	      clear_success:1,  /* Friend Clear Confirm received */
+	      burst:1,          /* Friend sends several PDUs per Poll */
+	      burst_rx:1;       /* Receiving a burst */
 
 	/* Friend Queue Size */
 	uint8_t  queue_size;
@@ -141,6 +191,15 @@ struct bt_mesh_lpn {
 	/* Next LPN related action timer */
 	struct k_delayed_work timer;
 
+	/* Friend Poll accounting */
+	uint32_t polls;         /* Friend Polls sent */
+	uint32_t pdus;          /* PDUs received from the Friend */
+	uint32_t scan_ms;       /* Time spent scanning */
+	uint32_t scan_start;    /* Uptime scanning was enabled, or 0 */
+	uint32_t drain_ms;      /* Time the last backlog took to receive */
+	uint32_t drain_max_ms;
+	uint32_t drain_start;   /* Uptime of the Poll that found it, or 0 */
+
 	/* Subscribed groups */
 	uint16_t groups[LPN_GROUPS];
 
@@ -239,6 +298,26 @@ struct bt_mesh_net_rx {
 	uint16_t  msg_cache_idx;  /* Index of entry in message cache */
 };
 
+/* Network Message Cache and duplicate filter statistics */
+struct bt_mesh_net_cache_stats {
+	uint32_t hit;      /* Lookups that found the message */
+	uint32_t miss;     /* Lookups that did not find the message */
+	uint32_t evicted;  /* Entries overwritten by newer messages */
+};
+
+/* Relay statistics */
+struct bt_mesh_net_relay_stats {
+	uint32_t relayed;     /* Messages relayed on the advertising bearer */
+	uint32_t suppressed;  /* Messages dropped after hearing other relays */
+};
+
+/* Buffer work done on the receive path */
+struct bt_mesh_net_rx_stats {
+	uint32_t alloc;       /* Buffers allocated for received data */
+	uint32_t copy;        /* Copies of received data */
+	uint32_t copy_bytes;  /* Bytes of received data copied */
+};
+
 /* Encoding context for Network/Transport data */
 struct bt_mesh_net_tx {
 	struct bt_mesh_subnet *sub;
@@ -278,6 +357,19 @@ void bt_mesh_net_recv(struct net_buf_simple *data, int8_t rssi,
 
 void bt_mesh_net_loopback_clear(uint16_t net_idx);
 
+void bt_mesh_net_cache_stats_get(struct bt_mesh_net_cache_stats *msg,
+				 struct bt_mesh_net_cache_stats *dup);
+
+void bt_mesh_net_relay_stats_get(struct bt_mesh_net_relay_stats *stats);
+
+void bt_mesh_net_rx_stats_get(struct bt_mesh_net_rx_stats *stats);
+
+/* Account for a buffer allocated and data copied on the receive path */
+void bt_mesh_net_rx_alloced(void);
+void bt_mesh_net_rx_copied(size_t len);
+
+void bt_mesh_net_relay_clear(void);
+
 uint32_t bt_mesh_next_seq(void);
 
 void bt_mesh_net_init(void);
@@ -29,17 +29,151 @@
 #include "net.h"
 #include "rpl.h"
 #include "settings.h"
+#include "stats.h"
 
 static struct bt_mesh_rpl replay_list[CONFIG_BT_MESH_CRPL];
 
+/* Source address index of replay_list. Entries are referred to by their
+ * index plus one, so that zero ends a list and the zeroed index is empty.
+ * Each entry is either never used, in the hash chain of its source address
+ * or in the free list.
+ */
+static struct {
+	uint16_t bucket[CONFIG_BT_MESH_CRPL];
+	uint16_t next[CONFIG_BT_MESH_CRPL];  /* Hash chain or free list */
+	uint16_t free;                       /* First released entry */
+	uint16_t used;                       /* Entries ever taken */
+} rpl_index;
+
+#define RPL_IDX(rpl)    ((uint16_t)((rpl) - replay_list) + 1)
+#define RPL_ENTRY(idx)  (&replay_list[(idx) - 1])
+
+static inline uint16_t *rpl_bucket(uint16_t src)
+{
+	/* Unicast addresses are mostly assigned in sequence */
+	return &rpl_index.bucket[src % CONFIG_BT_MESH_CRPL];
+}
+
+static struct bt_mesh_rpl *rpl_lookup(uint16_t src)
+{
+	uint16_t idx;
+
+	for (idx = *rpl_bucket(src); idx; idx = rpl_index.next[idx - 1]) {
+		if (RPL_ENTRY(idx)->src == src) {
+			return RPL_ENTRY(idx);
+		}
+	}
+
+	return NULL;
+}
+
+/* Entry a new source gets next, it is only taken by rpl_take() */
+static struct bt_mesh_rpl *rpl_peek_free(void)
+{
+	if (rpl_index.free) {
+		return RPL_ENTRY(rpl_index.free);
+	}
+
+	if (rpl_index.used < ARRAY_SIZE(replay_list)) {
+		return &replay_list[rpl_index.used];
+	}
+
+	return NULL;
+}
+
+static struct bt_mesh_rpl *rpl_take(uint16_t src)
+{
+	struct bt_mesh_rpl *rpl = rpl_peek_free();
+	uint16_t *bucket;
+	uint16_t idx;
+
+	if (!rpl) {
+		return NULL;
+	}
+
+	idx = RPL_IDX(rpl);
+	if (rpl_index.free == idx) {
+		rpl_index.free = rpl_index.next[idx - 1];
+	} else {
+		rpl_index.used++;
+	}
+
+	bucket = rpl_bucket(src);
+	rpl_index.next[idx - 1] = *bucket;
+	*bucket = idx;
+
+	rpl->src = src;
+
+	return rpl;
+}
+
+static void rpl_release(struct bt_mesh_rpl *rpl)
+{
+	uint16_t idx = RPL_IDX(rpl);
+	uint16_t *i;
+
+	if (!rpl->src) {
+		return;
+	}
+
+	for (i = rpl_bucket(rpl->src); *i != idx; i = &rpl_index.next[*i - 1]) {
+	}
+
+	*i = rpl_index.next[idx - 1];
+
+	rpl_index.next[idx - 1] = rpl_index.free;
+	rpl_index.free = idx;
+
+	(void)memset(rpl, 0, sizeof(*rpl));
+}
+
+#if CONFIG_BT_MESH_RPL_STORE_MARGIN > 0
+/* The entry is stored ahead of its sequence number by the margin, and only
+ * needs storing again once that is reached or the IV Index changed.
+ */
+static bool rpl_store_needed(struct bt_mesh_rpl *rpl, bool iv_changed)
+{
+	if (!iv_changed && rpl->seq < rpl->mark) {
+		return false;
+	}
+
+	rpl->mark = MIN(rpl->seq + CONFIG_BT_MESH_RPL_STORE_MARGIN,
+			0xffffff);
+
+	return true;
+}
+#else
+static inline bool rpl_store_needed(struct bt_mesh_rpl *rpl, bool iv_changed)
+{
+	return true;
+}
+#endif
+
 void bt_mesh_rpl_update(struct bt_mesh_rpl *rpl,
 		struct bt_mesh_net_rx *rx)
 {
-	rpl->src = rx->ctx.addr;
+	bool iv_changed;
+
+	/* New sources only take their entry once the message is accepted */
+	if (rpl->src != rx->ctx.addr) {
+		rpl = rpl_lookup(rx->ctx.addr);
+		if (!rpl) {
+			rpl = rpl_take(rx->ctx.addr);
+		}
+
+		if (!rpl) {
+			BT_ERR("RPL is full!");
+			return;
+		}
+	}
+
+	iv_changed = (rpl->old_iv != rx->old_iv);
+
 	rpl->seq = rx->seq;
 	rpl->old_iv = rx->old_iv;
 
-	if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
+	if (IS_ENABLED(CONFIG_BT_SETTINGS) &&
+	    rpl_store_needed(rpl, iv_changed)) {
 		bt_mesh_store_rpl(rpl);
 	}
 }
@@ -52,7 +186,7 @@ void bt_mesh_rpl_update(struct bt_mesh_rpl *rpl,
 bool bt_mesh_rpl_check(struct bt_mesh_net_rx *rx,
 		struct bt_mesh_rpl **match)
 {
-	int i;
+	struct bt_mesh_rpl *rpl;
 
 	/* Don't bother checking messages from ourselves */
 	if (rx->net_if == BT_MESH_NET_IF_LOCAL) {
@@ -64,42 +198,45 @@ bool bt_mesh_rpl_check(struct bt_mesh_net_rx *rx,
 		return false;
 	}
 
-	for (i = 0; i < ARRAY_SIZE(replay_list); i++) {
-		struct bt_mesh_rpl *rpl = &replay_list[i];
+	rpl = rpl_lookup(rx->ctx.addr);
 
-		/* Empty slot */
-		if (!rpl->src) {
-			if (match) {
-				*match = rpl;
-			} else {
-				bt_mesh_rpl_update(rpl, rx);
-			}
+	/* Empty slot */
+	if (!rpl) {
+		rpl = rpl_peek_free();
+		if (!rpl) {
+			BT_ERR("RPL is full!");
+			bt_mesh_stats_evt(BT_MESH_STATS_RPL_REJECT, 0);
+			return true;
+		}
 
-			return false;
+		if (match) {
+			*match = rpl;
+		} else {
+			bt_mesh_rpl_update(rpl, rx);
 		}
 
-		/* Existing slot for given address */
-		if (rpl->src == rx->ctx.addr) {
-			if (rx->old_iv && !rpl->old_iv) {
-				return true;
-			}
+		return false;
+	}
 
-			if ((!rx->old_iv && rpl->old_iv) ||
-			    rpl->seq < rx->seq) {
-				if (match) {
-					*match = rpl;
-				} else {
-					bt_mesh_rpl_update(rpl, rx);
-				}
+	/* Existing slot for given address */
+	if (rx->old_iv && !rpl->old_iv) {
+		bt_mesh_stats_evt(BT_MESH_STATS_RPL_REJECT, 0);
+		return true;
+	}
 
-				return false;
-			} else {
-				return true;
-			}
+	if ((!rx->old_iv && rpl->old_iv) ||
+	    rpl->seq < rx->seq) {
+		if (match) {
+			*match = rpl;
+		} else {
+			bt_mesh_rpl_update(rpl, rx);
 		}
+
+		return false;
 	}
 
-	BT_ERR("RPL is full!");
+	bt_mesh_stats_evt(BT_MESH_STATS_RPL_REJECT, 0);
+
 	return true;
 }
 
@@ -111,34 +248,23 @@ void bt_mesh_rpl_clear(void)
 		bt_mesh_clear_rpl();
 	} else {
 		(void)memset(replay_list, 0, sizeof(replay_list));
+		(void)memset(&rpl_index, 0, sizeof(rpl_index));
 	}
 }
 
 struct bt_mesh_rpl *bt_mesh_rpl_find(uint16_t src)
 {
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(replay_list); i++) {
-		if (replay_list[i].src == src) {
-			return &replay_list[i];
-		}
-	}
-
-	return NULL;
+	return rpl_lookup(src);
 }
 
 struct bt_mesh_rpl *bt_mesh_rpl_alloc(uint16_t src)
 {
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(replay_list); i++) {
-		if (!replay_list[i].src) {
-			replay_list[i].src = src;
-			return &replay_list[i];
-		}
-	}
+	return rpl_take(src);
+}
 
-	return NULL;
+void bt_mesh_rpl_free(struct bt_mesh_rpl *rpl)
+{
+	rpl_release(rpl);
 }
 
 void bt_mesh_rpl_foreach(bt_mesh_rpl_func_t func, void *user_data)
@@ -162,7 +288,7 @@ void bt_mesh_rpl_reset(void)
 
 		if (rpl->src) {
 			if (rpl->old_iv) {
-				(void)memset(rpl, 0, sizeof(*rpl));
+				rpl_release(rpl);
 			} else {
 				rpl->old_iv = true;
 			}
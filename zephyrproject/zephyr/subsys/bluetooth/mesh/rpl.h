@@ -14,6 +14,9 @@ struct bt_mesh_rpl {
 	bool  store;
 #endif
 	uint32_t seq;
+#if CONFIG_BT_MESH_RPL_STORE_MARGIN > 0
+	uint32_t mark;  /* Sequence number of the stored entry */
+#endif
 };
 
 typedef void (*bt_mesh_rpl_func_t)(struct bt_mesh_rpl *rpl,
@@ -25,6 +28,7 @@ bool bt_mesh_rpl_check(struct bt_mesh_net_rx *rx,
 void bt_mesh_rpl_clear(void);
 struct bt_mesh_rpl *bt_mesh_rpl_find(uint16_t src);
 struct bt_mesh_rpl *bt_mesh_rpl_alloc(uint16_t src);
+void bt_mesh_rpl_free(struct bt_mesh_rpl *rpl);
 void bt_mesh_rpl_foreach(bt_mesh_rpl_func_t func, void *user_data);
 void bt_mesh_rpl_update(struct bt_mesh_rpl *rpl,
 			struct bt_mesh_net_rx *rx);
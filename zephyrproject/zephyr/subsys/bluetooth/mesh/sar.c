@@ -0,0 +1,150 @@
+/*  Bluetooth Mesh */
+
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/util.h>
+
+#include <bluetooth/mesh.h>
+
+#define BT_DBG_ENABLED IS_ENABLED(CONFIG_BT_MESH_DEBUG_TRANS)
+#define LOG_MODULE_NAME bt_mesh_sar
+#include "common/log.h"
+
+#include "sar.h"
+
+/* "This timer shall be set to a minimum of 200 + 50 * TTL milliseconds." */
+#define SAR_TIMEOUT_MIN(ttl) (200 + 50 * (ttl))
+
+/* Smoothed loss above the link's own loss floor at which the window is
+ * halved and unanswered rounds back off, in 1/256. A link that is just
+ * lossy gains nothing from sending slower, only congestion does.
+ */
+#define SAR_LOSS_CONGESTED 64
+
+static struct bt_mesh_sar_peer sar_peers[CONFIG_BT_MESH_TX_SEG_PEER_COUNT];
+
+static bool sar_congested(const struct bt_mesh_sar_peer *peer)
+{
+	return peer->loss > peer->loss_floor + SAR_LOSS_CONGESTED;
+}
+
+void bt_mesh_sar_peer_init(struct bt_mesh_sar_peer *peer, uint16_t addr)
+{
+	(void)memset(peer, 0, sizeof(*peer));
+	peer->addr = addr;
+	peer->window = CONFIG_BT_MESH_TX_SEG_WINDOW;
+}
+
+struct bt_mesh_sar_peer *bt_mesh_sar_peer_get(uint16_t addr)
+{
+	struct bt_mesh_sar_peer *peer = NULL;
+	uint32_t now = k_uptime_get_32();
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sar_peers); i++) {
+		if (sar_peers[i].addr == addr) {
+			peer = &sar_peers[i];
+			break;
+		}
+
+		if (!peer || sar_peers[i].addr == BT_MESH_ADDR_UNASSIGNED ||
+		    (peer->addr != BT_MESH_ADDR_UNASSIGNED &&
+		     now - sar_peers[i].used > now - peer->used)) {
+			peer = &sar_peers[i];
+		}
+	}
+
+	if (peer->addr != addr) {
+		BT_DBG("0x%04x replaces 0x%04x", addr, peer->addr);
+		bt_mesh_sar_peer_init(peer, addr);
+	}
+
+	peer->used = now;
+
+	return peer;
+}
+
+void bt_mesh_sar_ack(struct bt_mesh_sar_peer *peer, uint32_t rtt,
+		     uint8_t sent, uint8_t lost)
+{
+	uint16_t sample;
+
+	if (rtt) {
+		rtt = MIN(rtt, UINT16_MAX);
+
+		/* RFC 6298 smoothing, with the gains as shifts */
+		if (!peer->srtt) {
+			peer->srtt = rtt;
+			peer->rttvar = rtt / 2;
+		} else {
+			peer->rttvar = (3 * peer->rttvar +
+					abs((int32_t)peer->srtt - (int32_t)rtt)) / 4;
+			peer->srtt = (7 * peer->srtt + rtt) / 8;
+		}
+	}
+
+	if (!sent) {
+		return;
+	}
+
+	sample = MIN((lost * 256U) / sent, 255);
+	peer->loss = (3 * peer->loss + sample) / 4;
+
+	/* The floor follows drops in the loss at once and rises slowly, so
+	 * that it settles at the loss of the quiet link.
+	 */
+	if (peer->loss < peer->loss_floor) {
+		peer->loss_floor = peer->loss;
+	} else {
+		peer->loss_floor += (peer->loss - peer->loss_floor + 15) / 16;
+	}
+
+	if (sar_congested(peer)) {
+		peer->window = MAX(peer->window / 2, 1);
+	} else if (peer->window < CONFIG_BT_MESH_TX_SEG_WINDOW) {
+		peer->window++;
+	}
+
+	BT_DBG("0x%04x srtt %u rttvar %u loss %u window %u", peer->addr,
+	       peer->srtt, peer->rttvar, peer->loss, peer->window);
+}
+
+int32_t bt_mesh_sar_timeout(const struct bt_mesh_sar_peer *peer, uint8_t ttl,
+			    uint8_t backoff)
+{
+	int32_t timeout;
+
+	if (peer->srtt) {
+		timeout = MAX(peer->srtt + 4 * peer->rttvar,
+			      SAR_TIMEOUT_MIN(ttl));
+	} else {
+		timeout = CONFIG_BT_MESH_TX_SEG_RETRANS_TIMEOUT_UNICAST +
+			  50 * ttl;
+	}
+
+	/* An unanswered round on an uncongested link most likely lost the
+	 * ack, which a timely retransmission recovers best. Only back off
+	 * while the segments are getting lost more than usual as well.
+	 */
+	if (sar_congested(peer)) {
+		timeout <<= MIN(backoff, BT_MESH_SAR_BACKOFF_MAX);
+	}
+
+	/* The configured cap never takes the timer below the spec minimum */
+	return MAX(MIN(timeout, CONFIG_BT_MESH_TX_SEG_RETRANS_TIMEOUT_MAX),
+		   SAR_TIMEOUT_MIN(ttl));
+}
+
+void bt_mesh_sar_reset(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sar_peers); i++) {
+		bt_mesh_sar_peer_init(&sar_peers[i], BT_MESH_ADDR_UNASSIGNED);
+	}
+}
@@ -0,0 +1,42 @@
+/*  Bluetooth Mesh */
+
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Round trip and loss estimate of a destination of segmented messages */
+struct bt_mesh_sar_peer {
+	uint16_t addr;
+	uint16_t srtt;     /* Smoothed round trip time in ms, 0 if unknown */
+	uint16_t rttvar;   /* Round trip time variation in ms */
+	uint8_t  loss;     /* Smoothed fraction of segments lost, in 1/256 */
+	uint8_t  loss_floor; /* Loss the link has without congestion */
+	uint8_t  window;   /* Segments to queue for sending at once */
+	uint32_t used;     /* Uptime of the last lookup */
+};
+
+/* Longest exponential backoff, as a power of two */
+#define BT_MESH_SAR_BACKOFF_MAX 4
+
+void bt_mesh_sar_peer_init(struct bt_mesh_sar_peer *peer, uint16_t addr);
+
+/* Get the estimate of a unicast destination, replacing the least recently
+ * used one if there's none yet.
+ */
+struct bt_mesh_sar_peer *bt_mesh_sar_peer_get(uint16_t addr);
+
+/* Update the estimate from an acknowledgment of a complete round of sent
+ * segments. rtt is the time from the end of the round to the
+ * acknowledgment, 0 if it can't be trusted because it might belong to an
+ * earlier round.
+ */
+void bt_mesh_sar_ack(struct bt_mesh_sar_peer *peer, uint32_t rtt,
+		     uint8_t sent, uint8_t lost);
+
+/* Retransmit timeout in milliseconds after backoff unanswered rounds, which
+ * only back off while the destination is losing more segments than usual.
+ */
+int32_t bt_mesh_sar_timeout(const struct bt_mesh_sar_peer *peer, uint8_t ttl,
+			    uint8_t backoff);
+
+void bt_mesh_sar_reset(void);
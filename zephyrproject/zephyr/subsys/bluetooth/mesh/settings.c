@@ -101,6 +101,34 @@ struct rpl_val {
 	      old_iv:1;
 };
 
+/* Replay Protection List block storage */
+struct rpl_block_val {
+	uint16_t src;
+	uint32_t seq:24,
+	      old_iv:1;
+} __packed;
+
+#if defined(CONFIG_BT_MESH_RPL_STORE_BLOCK)
+#define RPL_BLOCK_SIZE CONFIG_BT_MESH_RPL_STORE_BLOCK_SIZE
+#else
+#define RPL_BLOCK_SIZE 1
+#endif
+
+/* RPL block being collected for storage */
+struct rpl_block {
+	struct rpl_block_val val[RPL_BLOCK_SIZE];
+	uint16_t slot;   /* RPL slot of the next entry */
+	uint8_t count;   /* Entries up to the last one in use */
+	bool changed;
+};
+
+/* RPL entries were restored, and so got new slots */
+static bool rpl_restored;
+/* Per-source RPL entries were restored in block format */
+static bool rpl_entries_restored;
+/* Number of RPL blocks that may be stored */
+static uint16_t rpl_blocks;
+
 /* NetKey storage information */
 struct net_key_val {
 	uint8_t kr_flag:1,
@@ -277,6 +305,38 @@ static int seq_set(const char *name, size_t len_rd, settings_read_cb read_cb,
 	return 0;
 }
 
+/* Restore an RPL entry, keeping the newer one if the source is stored in
+ * both the per-source and the block format.
+ */
+static int rpl_restore(uint16_t src, uint32_t seq, bool old_iv)
+{
+	struct bt_mesh_rpl *entry;
+
+	entry = bt_mesh_rpl_find(src);
+	if (!entry) {
+		entry = bt_mesh_rpl_alloc(src);
+		if (!entry) {
+			BT_ERR("Unable to allocate RPL entry for 0x%04x", src);
+			return -ENOMEM;
+		}
+	} else if (old_iv > entry->old_iv ||
+		   (old_iv == entry->old_iv && seq <= entry->seq)) {
+		return 0;
+	}
+
+	entry->seq = seq;
+	entry->old_iv = old_iv;
+#if CONFIG_BT_MESH_RPL_STORE_MARGIN > 0
+	entry->mark = seq;
+#endif
+	rpl_restored = true;
+
+	BT_DBG("RPL entry for 0x%04x: Seq 0x%06x old_iv %u", entry->src,
+	       entry->seq, entry->old_iv);
+
+	return 0;
+}
+
 static int rpl_set(const char *name, size_t len_rd,
 		   settings_read_cb read_cb, void *cb_arg)
 {
@@ -295,8 +355,14 @@ static int rpl_set(const char *name, size_t len_rd,
 
 	if (len_rd == 0) {
 		BT_DBG("val (null)");
+
+		/* The entry may be stored in a block after this was deleted */
+		if (IS_ENABLED(CONFIG_BT_MESH_RPL_STORE_BLOCK)) {
+			return 0;
+		}
+
 		if (entry) {
-			(void)memset(entry, 0, sizeof(*entry));
+			bt_mesh_rpl_free(entry);
 		} else {
 			BT_WARN("Unable to find RPL entry for 0x%04x", src);
 		}
@@ -304,25 +370,67 @@ static int rpl_set(const char *name, size_t len_rd,
 		return 0;
 	}
 
-	if (!entry) {
-		entry = bt_mesh_rpl_alloc(src);
-		if (!entry) {
-			BT_ERR("Unable to allocate RPL entry for 0x%04x", src);
-			return -ENOMEM;
-		}
-	}
-
 	err = mesh_x_set(read_cb, cb_arg, &rpl, sizeof(rpl));
 	if (err) {
 		BT_ERR("Failed to set `net`");
 		return err;
 	}
 
-	entry->seq = rpl.seq;
-	entry->old_iv = rpl.old_iv;
+	err = rpl_restore(src, rpl.seq, rpl.old_iv);
+	if (err) {
+		return err;
+	}
 
-	BT_DBG("RPL entry for 0x%04x: Seq 0x%06x old_iv %u", entry->src,
-	       entry->seq, entry->old_iv);
+	/* Converted to blocks on the next store */
+	if (IS_ENABLED(CONFIG_BT_MESH_RPL_STORE_BLOCK)) {
+		rpl_entries_restored = true;
+		bt_mesh_store_rpl(bt_mesh_rpl_find(src));
+	}
+
+	return 0;
+}
+
+static int rpl_block_set(const char *name, size_t len_rd,
+			 settings_read_cb read_cb, void *cb_arg)
+{
+	/* Blocks of any configured size */
+	struct rpl_block_val val[64];
+	ssize_t len;
+	int i, err;
+
+	if (!name) {
+		BT_ERR("Insufficient number of arguments");
+		return -ENOENT;
+	}
+
+	rpl_blocks = MAX(rpl_blocks, strtol(name, NULL, 16) + 1);
+
+	if (len_rd == 0) {
+		BT_DBG("val (null)");
+		return 0;
+	}
+
+	len = read_cb(cb_arg, val, sizeof(val));
+	if (len < 0 || len % sizeof(val[0])) {
+		BT_ERR("Failed to read RPL block %s", log_strdup(name));
+		return -EINVAL;
+	}
+
+	for (i = 0; i < len / sizeof(val[0]); i++) {
+		if (!val[i].src) {
+			continue;
+		}
+
+		err = rpl_restore(val[i].src, val[i].seq, val[i].old_iv);
+		if (err) {
+			return err;
+		}
+
+		/* Converted to per-source entries on the next store */
+		if (!IS_ENABLED(CONFIG_BT_MESH_RPL_STORE_BLOCK)) {
+			bt_mesh_store_rpl(bt_mesh_rpl_find(val[i].src));
+		}
+	}
 
 	return 0;
 }
@@ -922,6 +1030,7 @@ const struct mesh_setting {
 	{ "IV", iv_set },
 	{ "Seq", seq_set },
 	{ "RPL", rpl_set },
+	{ "RPLBlk", rpl_block_set }, /* After "RPL", which is its prefix */
 	{ "NetKey", net_key_set },
 	{ "AppKey", app_key_set },
 	{ "HBPub", hb_pub_set },
@@ -1150,6 +1259,15 @@ void bt_mesh_store_seq(void)
 	schedule_store(BT_MESH_SEQ_PENDING);
 }
 
+static uint32_t rpl_stored_seq(struct bt_mesh_rpl *entry)
+{
+#if CONFIG_BT_MESH_RPL_STORE_MARGIN > 0
+	return entry->mark;
+#else
+	return entry->seq;
+#endif
+}
+
 static void store_rpl(struct bt_mesh_rpl *entry)
 {
 	struct rpl_val rpl;
@@ -1159,7 +1277,7 @@ static void store_rpl(struct bt_mesh_rpl *entry)
 	BT_DBG("src 0x%04x seq 0x%06x old_iv %u", entry->src, entry->seq,
 	       entry->old_iv);
 
-	rpl.seq = entry->seq;
+	rpl.seq = rpl_stored_seq(entry);
 	rpl.old_iv = entry->old_iv;
 
 	snprintk(path, sizeof(path), "bt/mesh/RPL/%x", entry->src);
@@ -1172,24 +1290,42 @@ static void store_rpl(struct bt_mesh_rpl *entry)
 	}
 }
 
-static void clear_rpl(struct bt_mesh_rpl *rpl, void *user_data)
+static void clear_rpl_path(const char *path)
 {
 	int err;
-	char path[18];
-
-	if (!rpl->src) {
-		return;
-	}
 
-	snprintk(path, sizeof(path), "bt/mesh/RPL/%x", rpl->src);
 	err = settings_delete(path);
 	if (err) {
 		BT_ERR("Failed to clear RPL");
 	} else {
 		BT_DBG("Cleared RPL");
 	}
+}
+
+static void clear_rpl_entry(struct bt_mesh_rpl *rpl)
+{
+	char path[18];
+
+	snprintk(path, sizeof(path), "bt/mesh/RPL/%x", rpl->src);
+	clear_rpl_path(path);
+}
+
+static void clear_rpl_block(uint16_t block)
+{
+	char path[20];
+
+	snprintk(path, sizeof(path), "bt/mesh/RPLBlk/%x", block);
+	clear_rpl_path(path);
+}
+
+static void clear_rpl(struct bt_mesh_rpl *rpl, void *user_data)
+{
+	if (!rpl->src) {
+		return;
+	}
 
-	(void)memset(rpl, 0, sizeof(*rpl));
+	clear_rpl_entry(rpl);
+	bt_mesh_rpl_free(rpl);
 }
 
 static void store_pending_rpl(struct bt_mesh_rpl *rpl, void *user_data)
@@ -1202,6 +1338,113 @@ static void store_pending_rpl(struct bt_mesh_rpl *rpl, void *user_data)
 	}
 }
 
+static void store_rpl_block(struct rpl_block *block)
+{
+	uint16_t idx = (block->slot - 1) / RPL_BLOCK_SIZE;
+	char path[20];
+	int err;
+
+	if (!block->count) {
+		clear_rpl_block(idx);
+		return;
+	}
+
+	snprintk(path, sizeof(path), "bt/mesh/RPLBlk/%x", idx);
+
+	err = settings_save_one(path, block->val,
+				block->count * sizeof(block->val[0]));
+	if (err) {
+		BT_ERR("Failed to store RPL %s value", log_strdup(path));
+	} else {
+		BT_DBG("Stored RPL %s value", log_strdup(path));
+	}
+}
+
+/* Collect the RPL slots in blocks, and store every block that changed */
+static void store_pending_rpl_block(struct bt_mesh_rpl *rpl, void *user_data)
+{
+	struct rpl_block *block = user_data;
+	uint8_t pos = block->slot++ % RPL_BLOCK_SIZE;
+	struct rpl_block_val *val = &block->val[pos];
+
+	if (rpl->src && !atomic_test_bit(bt_mesh.flags, BT_MESH_VALID)) {
+		bt_mesh_rpl_free(rpl);
+		block->changed = true;
+	}
+
+	if (rpl->store) {
+		rpl->store = false;
+		block->changed = true;
+	}
+
+	val->src = rpl->src;
+	val->seq = rpl_stored_seq(rpl);
+	val->old_iv = rpl->old_iv;
+
+	if (rpl->src) {
+		block->count = pos + 1;
+	}
+
+	if (pos != RPL_BLOCK_SIZE - 1 && block->slot != CONFIG_BT_MESH_CRPL) {
+		return;
+	}
+
+	/* Restored entries may have been stored in other blocks */
+	if (block->changed || rpl_restored) {
+		store_rpl_block(block);
+	}
+
+	block->count = 0U;
+	block->changed = false;
+}
+
+static void clear_pending_rpl_entry(struct bt_mesh_rpl *rpl, void *user_data)
+{
+	if (rpl->src) {
+		clear_rpl_entry(rpl);
+	}
+}
+
+static void store_pending_rpl_blocks(void)
+{
+	struct rpl_block block = { 0 };
+	uint16_t i;
+
+	/* Remove what is left of the per-source entries */
+	if (rpl_entries_restored) {
+		bt_mesh_rpl_foreach(clear_pending_rpl_entry, NULL);
+		rpl_entries_restored = false;
+	}
+
+	bt_mesh_rpl_foreach(store_pending_rpl_block, &block);
+
+	for (i = ceiling_fraction(CONFIG_BT_MESH_CRPL, RPL_BLOCK_SIZE);
+	     i < rpl_blocks; i++) {
+		clear_rpl_block(i);
+	}
+
+	rpl_blocks = 0U;
+	rpl_restored = false;
+}
+
+static void store_pending_rpl_entries(void)
+{
+	uint16_t i;
+
+	if (atomic_test_bit(bt_mesh.flags, BT_MESH_VALID)) {
+		bt_mesh_rpl_foreach(store_pending_rpl, NULL);
+	} else {
+		bt_mesh_rpl_foreach(clear_rpl, NULL);
+	}
+
+	/* Entries restored from blocks are now stored on their own */
+	for (i = 0U; i < rpl_blocks; i++) {
+		clear_rpl_block(i);
+	}
+
+	rpl_blocks = 0U;
+}
+
 static void store_pending_hb_pub(void)
 {
 	struct bt_mesh_hb_pub pub;
@@ -1796,10 +2039,10 @@ static void store_pending(struct k_work *work)
 	BT_DBG("");
 
 	if (atomic_test_and_clear_bit(bt_mesh.flags, BT_MESH_RPL_PENDING)) {
-		if (atomic_test_bit(bt_mesh.flags, BT_MESH_VALID)) {
-			bt_mesh_rpl_foreach(store_pending_rpl, NULL);
+		if (IS_ENABLED(CONFIG_BT_MESH_RPL_STORE_BLOCK)) {
+			store_pending_rpl_blocks();
 		} else {
-			bt_mesh_rpl_foreach(clear_rpl, NULL);
+			store_pending_rpl_entries();
 		}
 	}
 
@@ -23,6 +23,7 @@
 
 /* Private includes for raw Network & Transport layer access */
 #include "mesh.h"
+#include "adv.h"
 #include "net.h"
 #include "rpl.h"
 #include "transport.h"
@@ -449,6 +450,32 @@ static bool str2bool(const char *str)
 	return str2u8(str);
 }
 
+#if defined(CONFIG_BT_MESH_RELAY_SUPPRESS)
+static int cmd_relay_suppress(const struct shell *shell, size_t argc,
+			      char *argv[])
+{
+	uint8_t threshold = strtoul(argv[1], NULL, 0);
+	uint16_t max_delay = strtoul(argv[2], NULL, 0);
+	int err;
+
+	err = bt_mesh_relay_suppress_set(threshold, max_delay);
+	if (err) {
+		shell_error(shell, "Setting relay suppression failed (err %d)",
+			    err);
+		return 0;
+	}
+
+	if (threshold) {
+		shell_print(shell, "Relay suppressed after %u copies, backoff "
+			    "up to %u ms", threshold, max_delay);
+	} else {
+		shell_print(shell, "Relay suppression disabled");
+	}
+
+	return 0;
+}
+#endif
+
 #if defined(CONFIG_BT_MESH_LOW_POWER)
 static int cmd_lpn(const struct shell *shell, size_t argc, char *argv[])
 {
@@ -771,6 +798,97 @@ static int cmd_rpl_clear(const struct shell *shell, size_t argc, char *argv[])
 	return 0;
 }
 
+#if defined(CONFIG_BT_MESH_STATS)
+static int cmd_stats(const struct shell *shell, size_t argc, char *argv[])
+{
+	static const char *const adv_class[BT_MESH_STATS_ADV_CLASSES] = {
+		[BT_MESH_ACK_ADV]      = "ack",
+		[BT_MESH_FRIEND_ADV]   = "friend",
+		[BT_MESH_PROV_PDU_ADV] = "prov",
+		[BT_MESH_RELAY_ADV]    = "relay",
+		[BT_MESH_LOCAL_ADV]    = "local",
+		[BT_MESH_BEACON_ADV]   = "beacon",
+	};
+	struct bt_mesh_stats stats;
+	int i;
+
+	if (argc > 1) {
+		if (strcmp(argv[1], "reset")) {
+			shell_help(shell);
+			return -EINVAL;
+		}
+
+		bt_mesh_stats_reset();
+		return 0;
+	}
+
+	bt_mesh_stats_get(&stats);
+
+	shell_print(shell, "Network: heard %u, duplicate %u, cached %u",
+		    stats.adv_heard, stats.dup_drop, stats.cache_drop);
+	shell_print(shell, "Decrypt: found %u, unknown %u, trials %u "
+		    "(0: %u, 1: %u, 2: %u, 3+: %u)", stats.net_rx,
+		    stats.net_unknown, stats.net_trials,
+		    stats.net_trials_hist[0], stats.net_trials_hist[1],
+		    stats.net_trials_hist[2], stats.net_trials_hist[3]);
+	shell_print(shell, "Relay: sent %u, no buffer %u, suppressed %u",
+		    stats.relay_sent, stats.relay_no_buf,
+		    stats.relay_suppressed);
+	shell_print(shell, "Receive buffers: alloc %u, copy %u (%u bytes)",
+		    stats.rx_alloc, stats.rx_copy, stats.rx_copy_bytes);
+	shell_print(shell, "Transport: segments retransmitted %u, stale "
+		    "SDUs dropped %u, RPL rejects %u", stats.seg_retransmit,
+		    stats.seg_evict, stats.rpl_reject);
+	shell_print(shell, "Acks: sent %u, replaced %u, repeats skipped %u, "
+		    "deferred %u", stats.ack_sent, stats.ack_replaced,
+		    stats.ack_repeated, stats.ack_deferred);
+	shell_print(shell, "Adv queue: queued %u, depth %u (max %u)",
+		    stats.adv_queued, stats.adv_depth, stats.adv_max_depth);
+	shell_print(shell, "Adv wait: <10ms %u, <50ms %u, <100ms %u, "
+		    "<500ms %u, longer %u", stats.adv_wait[0],
+		    stats.adv_wait[1], stats.adv_wait[2], stats.adv_wait[3],
+		    stats.adv_wait[4]);
+
+	for (i = 0; i < BT_MESH_STATS_ADV_CLASSES; i++) {
+		shell_print(shell, "  %-6s sent %u, canceled %u, no quota %u, "
+			    "depth %u/%u, max wait %u ms", adv_class[i],
+			    stats.adv[i].sent, stats.adv[i].canceled,
+			    stats.adv[i].no_quota, stats.adv[i].depth,
+			    stats.adv[i].max_depth, stats.adv[i].max_wait_ms);
+	}
+
+#if defined(CONFIG_BT_MESH_FRIEND)
+	for (i = 0; i < ARRAY_SIZE(bt_mesh.frnd); i++) {
+		struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
+
+		if (!frnd->established) {
+			continue;
+		}
+
+		shell_print(shell, "Friend queue of 0x%04x: queued %u/%u, max %u, "
+			    "reserved %u, dropped %u, superseded %u", frnd->lpn,
+			    frnd->queue_size, CONFIG_BT_MESH_FRIEND_QUEUE_SIZE,
+			    frnd->queue_max, frnd->seg_reserved, frnd->dropped,
+			    frnd->superseded);
+		shell_print(shell, "  polls %u, sent %u, repeated %u, burst %s, "
+			    "drain %u ms (max %u ms)", frnd->polls, frnd->sent,
+			    frnd->repeated, frnd->burst ? "on" : "off",
+			    frnd->drain_ms, frnd->drain_max_ms);
+	}
+#endif
+
+#if defined(CONFIG_BT_MESH_LOW_POWER)
+	shell_print(shell, "LPN: polls %u, received %u, burst %s, scanning %u ms, "
+		    "drain %u ms (max %u ms)", bt_mesh.lpn.polls,
+		    bt_mesh.lpn.pdus, bt_mesh.lpn.burst ? "on" : "off",
+		    bt_mesh.lpn.scan_ms, bt_mesh.lpn.drain_ms,
+		    bt_mesh.lpn.drain_max_ms);
+#endif
+
+	return 0;
+}
+#endif /* CONFIG_BT_MESH_STATS */
+
 static int cmd_beacon(const struct shell *shell, size_t argc, char *argv[])
 {
 	uint8_t status;
@@ -2660,6 +2778,10 @@ SHELL_STATIC_SUBCMD_SET_CREATE(mesh_cmds,
 	SHELL_CMD_ARG(lpn, NULL, "<value: off, on>", cmd_lpn, 2, 0),
 	SHELL_CMD_ARG(poll, NULL, NULL, cmd_poll, 1, 0),
 #endif
+#if defined(CONFIG_BT_MESH_RELAY_SUPPRESS)
+	SHELL_CMD_ARG(relay-suppress, NULL, "<threshold, 0: off> <max delay ms>",
+		      cmd_relay_suppress, 3, 0),
+#endif
 #if defined(CONFIG_BT_MESH_GATT_PROXY)
 	SHELL_CMD_ARG(ident, NULL, NULL, cmd_ident, 1, 0),
 #endif
@@ -2675,6 +2797,9 @@ SHELL_STATIC_SUBCMD_SET_CREATE(mesh_cmds,
 		      cmd_iv_update_test, 2, 0),
 #endif
 	SHELL_CMD_ARG(rpl-clear, NULL, NULL, cmd_rpl_clear, 1, 0),
+#if defined(CONFIG_BT_MESH_STATS)
+	SHELL_CMD_ARG(stats, NULL, "[reset]", cmd_stats, 1, 1),
+#endif
 
 	/* Provisioning operations */
 #if defined(CONFIG_BT_MESH_PB_GATT)
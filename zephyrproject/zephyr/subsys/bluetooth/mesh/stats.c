@@ -0,0 +1,271 @@
+/*  Bluetooth Mesh */
+
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <stats/stats.h>
+
+#include <net/buf.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/mesh.h>
+
+#define BT_DBG_ENABLED IS_ENABLED(CONFIG_BT_MESH_DEBUG)
+#define LOG_MODULE_NAME bt_mesh_stats
+#include "common/log.h"
+
+#include "adv.h"
+#include "net.h"
+#include "stats.h"
+
+STATS_SECT_START(mesh_stats)
+STATS_SECT_ENTRY32(adv_heard)
+STATS_SECT_ENTRY32(dup_drop)
+STATS_SECT_ENTRY32(cache_drop)
+STATS_SECT_ENTRY32(net_rx)
+STATS_SECT_ENTRY32(net_unknown)
+STATS_SECT_ENTRY32(net_trials)
+STATS_SECT_ENTRY32(relay_sent)
+STATS_SECT_ENTRY32(relay_no_buf)
+STATS_SECT_ENTRY32(relay_suppressed)
+STATS_SECT_ENTRY32(seg_retransmit)
+STATS_SECT_ENTRY32(seg_evict)
+STATS_SECT_ENTRY32(ack_sent)
+STATS_SECT_ENTRY32(ack_replaced)
+STATS_SECT_ENTRY32(ack_repeated)
+STATS_SECT_ENTRY32(ack_deferred)
+STATS_SECT_ENTRY32(rpl_reject)
+STATS_SECT_ENTRY32(adv_queued)
+STATS_SECT_ENTRY32(adv_depth)
+STATS_SECT_ENTRY32(adv_max_depth)
+/* Time in queue histogram, must follow each other */
+STATS_SECT_ENTRY32(adv_wait_10ms)
+STATS_SECT_ENTRY32(adv_wait_50ms)
+STATS_SECT_ENTRY32(adv_wait_100ms)
+STATS_SECT_ENTRY32(adv_wait_500ms)
+STATS_SECT_ENTRY32(adv_wait_long)
+STATS_SECT_END;
+
+STATS_NAME_START(mesh_stats)
+STATS_NAME(mesh_stats, adv_heard)
+STATS_NAME(mesh_stats, dup_drop)
+STATS_NAME(mesh_stats, cache_drop)
+STATS_NAME(mesh_stats, net_rx)
+STATS_NAME(mesh_stats, net_unknown)
+STATS_NAME(mesh_stats, net_trials)
+STATS_NAME(mesh_stats, relay_sent)
+STATS_NAME(mesh_stats, relay_no_buf)
+STATS_NAME(mesh_stats, relay_suppressed)
+STATS_NAME(mesh_stats, seg_retransmit)
+STATS_NAME(mesh_stats, seg_evict)
+STATS_NAME(mesh_stats, ack_sent)
+STATS_NAME(mesh_stats, ack_replaced)
+STATS_NAME(mesh_stats, ack_repeated)
+STATS_NAME(mesh_stats, ack_deferred)
+STATS_NAME(mesh_stats, rpl_reject)
+STATS_NAME(mesh_stats, adv_queued)
+STATS_NAME(mesh_stats, adv_depth)
+STATS_NAME(mesh_stats, adv_max_depth)
+STATS_NAME(mesh_stats, adv_wait_10ms)
+STATS_NAME(mesh_stats, adv_wait_50ms)
+STATS_NAME(mesh_stats, adv_wait_100ms)
+STATS_NAME(mesh_stats, adv_wait_500ms)
+STATS_NAME(mesh_stats, adv_wait_long)
+STATS_NAME_END(mesh_stats);
+
+static STATS_SECT_DECL(mesh_stats) mesh_stats;
+
+static const uint16_t wait_bounds[] = { BT_MESH_STATS_WAIT_BOUNDS };
+
+BUILD_ASSERT(ARRAY_SIZE(wait_bounds) == BT_MESH_STATS_WAIT_BUCKETS - 1);
+BUILD_ASSERT(BT_MESH_STATS_ADV_CLASSES == BT_MESH_ADV_TAGS);
+BUILD_ASSERT(BT_MESH_STATS_TRIALS ==
+	     ARRAY_SIZE(((struct bt_mesh_net_cred_stats *)0)->trials));
+
+static bt_mesh_stats_trace_t stats_trace;
+
+static void adv_wait_add(uint32_t wait)
+{
+	uint32_t *bucket = &mesh_stats.adv_wait_10ms;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(wait_bounds); i++) {
+		if (wait < wait_bounds[i]) {
+			break;
+		}
+	}
+
+	bucket[i]++;
+}
+
+void bt_mesh_stats_evt(enum bt_mesh_stats_evt evt, uint32_t val)
+{
+	bt_mesh_stats_trace_t trace = stats_trace;
+	unsigned int key;
+
+	/* Events come from the RX, advertising and system work queue
+	 * threads, and the depth has to stay consistent between them.
+	 */
+	key = irq_lock();
+
+	switch (evt) {
+	case BT_MESH_STATS_ADV_HEARD:
+		STATS_INC(mesh_stats, adv_heard);
+		break;
+	case BT_MESH_STATS_DUP_DROP:
+		STATS_INC(mesh_stats, dup_drop);
+		break;
+	case BT_MESH_STATS_CACHE_DROP:
+		STATS_INC(mesh_stats, cache_drop);
+		break;
+	case BT_MESH_STATS_NET_RX:
+		STATS_INC(mesh_stats, net_rx);
+		STATS_INCN(mesh_stats, net_trials, val);
+		break;
+	case BT_MESH_STATS_NET_UNKNOWN:
+		STATS_INC(mesh_stats, net_unknown);
+		STATS_INCN(mesh_stats, net_trials, val);
+		break;
+	case BT_MESH_STATS_RELAY_SENT:
+		STATS_INC(mesh_stats, relay_sent);
+		break;
+	case BT_MESH_STATS_RELAY_NO_BUF:
+		STATS_INC(mesh_stats, relay_no_buf);
+		break;
+	case BT_MESH_STATS_RELAY_SUPPRESSED:
+		STATS_INC(mesh_stats, relay_suppressed);
+		break;
+	case BT_MESH_STATS_SEG_RETRANSMIT:
+		STATS_INC(mesh_stats, seg_retransmit);
+		break;
+	case BT_MESH_STATS_SEG_EVICT:
+		STATS_INC(mesh_stats, seg_evict);
+		break;
+	case BT_MESH_STATS_ACK_SENT:
+		STATS_INC(mesh_stats, ack_sent);
+		break;
+	case BT_MESH_STATS_ACK_REPLACED:
+		STATS_INC(mesh_stats, ack_replaced);
+		break;
+	case BT_MESH_STATS_ACK_REPEATED:
+		STATS_INC(mesh_stats, ack_repeated);
+		break;
+	case BT_MESH_STATS_ACK_DEFERRED:
+		STATS_INC(mesh_stats, ack_deferred);
+		break;
+	case BT_MESH_STATS_RPL_REJECT:
+		STATS_INC(mesh_stats, rpl_reject);
+		break;
+	case BT_MESH_STATS_ADV_QUEUED:
+		STATS_INC(mesh_stats, adv_queued);
+		STATS_INC(mesh_stats, adv_depth);
+		mesh_stats.adv_max_depth = MAX(mesh_stats.adv_max_depth,
+					       mesh_stats.adv_depth);
+		break;
+	case BT_MESH_STATS_ADV_CANCELED:
+		if (mesh_stats.adv_depth) {
+			mesh_stats.adv_depth--;
+		}
+		break;
+	case BT_MESH_STATS_ADV_SENT:
+		if (mesh_stats.adv_depth) {
+			mesh_stats.adv_depth--;
+		}
+		adv_wait_add(val);
+		break;
+	default:
+		break;
+	}
+
+	irq_unlock(key);
+
+	if (trace) {
+		trace(evt, val);
+	}
+}
+
+void bt_mesh_stats_get(struct bt_mesh_stats *stats)
+{
+	struct bt_mesh_net_cred_stats cred;
+	struct bt_mesh_net_rx_stats rx;
+	unsigned int key;
+	int i;
+
+	key = irq_lock();
+	stats->adv_heard = mesh_stats.adv_heard;
+	stats->dup_drop = mesh_stats.dup_drop;
+	stats->cache_drop = mesh_stats.cache_drop;
+	stats->net_rx = mesh_stats.net_rx;
+	stats->net_unknown = mesh_stats.net_unknown;
+	stats->net_trials = mesh_stats.net_trials;
+	stats->relay_sent = mesh_stats.relay_sent;
+	stats->relay_no_buf = mesh_stats.relay_no_buf;
+	stats->relay_suppressed = mesh_stats.relay_suppressed;
+	stats->seg_retransmit = mesh_stats.seg_retransmit;
+	stats->seg_evict = mesh_stats.seg_evict;
+	stats->ack_sent = mesh_stats.ack_sent;
+	stats->ack_replaced = mesh_stats.ack_replaced;
+	stats->ack_repeated = mesh_stats.ack_repeated;
+	stats->ack_deferred = mesh_stats.ack_deferred;
+	stats->rpl_reject = mesh_stats.rpl_reject;
+	stats->adv_queued = mesh_stats.adv_queued;
+	stats->adv_depth = mesh_stats.adv_depth;
+	stats->adv_max_depth = mesh_stats.adv_max_depth;
+	memcpy(stats->adv_wait, &mesh_stats.adv_wait_10ms,
+	       sizeof(stats->adv_wait));
+	irq_unlock(key);
+
+	/* Per layer details kept by the layers themselves */
+	bt_mesh_net_cred_stats_get(&cred);
+	memcpy(stats->net_trials_hist, cred.trials,
+	       sizeof(stats->net_trials_hist));
+
+	bt_mesh_net_rx_stats_get(&rx);
+	stats->rx_alloc = rx.alloc;
+	stats->rx_copy = rx.copy;
+	stats->rx_copy_bytes = rx.copy_bytes;
+
+	for (i = 0; i < BT_MESH_ADV_TAGS; i++) {
+		struct bt_mesh_adv_stats adv;
+
+		bt_mesh_adv_stats_get(i, &adv);
+		stats->adv[i].sent = adv.sent;
+		stats->adv[i].canceled = adv.canceled;
+		stats->adv[i].no_quota = adv.no_quota;
+		stats->adv[i].depth = adv.depth;
+		stats->adv[i].max_depth = adv.max_depth;
+		stats->adv[i].wait_ms = adv.wait_ms;
+		stats->adv[i].max_wait_ms = adv.max_wait_ms;
+	}
+}
+
+void bt_mesh_stats_reset(void)
+{
+	unsigned int key;
+	uint32_t depth;
+
+	/* The queue depth is a level rather than a count */
+	key = irq_lock();
+	depth = mesh_stats.adv_depth;
+	stats_reset(&mesh_stats.s_hdr);
+	mesh_stats.adv_depth = depth;
+	mesh_stats.adv_max_depth = depth;
+	irq_unlock(key);
+}
+
+void bt_mesh_stats_trace_set(bt_mesh_stats_trace_t trace)
+{
+	stats_trace = trace;
+}
+
+void bt_mesh_stats_init(void)
+{
+	int err;
+
+	err = STATS_INIT_AND_REG(mesh_stats, STATS_SIZE_32, "bt_mesh");
+	if (err) {
+		BT_ERR("Registering statistics failed (err %d)", err);
+	}
+}
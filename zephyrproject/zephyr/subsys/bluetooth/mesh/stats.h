@@ -0,0 +1,23 @@
+/*  Bluetooth Mesh */
+
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* The events, the snapshot and the tracing hook are public, see
+ * include/bluetooth/mesh/stats.h.
+ */
+
+#if defined(CONFIG_BT_MESH_STATS)
+void bt_mesh_stats_evt(enum bt_mesh_stats_evt evt, uint32_t val);
+
+void bt_mesh_stats_init(void);
+#else
+static inline void bt_mesh_stats_evt(enum bt_mesh_stats_evt evt, uint32_t val)
+{
+}
+
+static inline void bt_mesh_stats_init(void)
+{
+}
+#endif
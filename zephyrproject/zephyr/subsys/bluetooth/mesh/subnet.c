@@ -36,6 +36,7 @@
 #include "rpl.h"
 #include "settings.h"
 #include "prov.h"
+#include "stats.h"
 
 static struct bt_mesh_subnet subnets[CONFIG_BT_MESH_SUBNET_COUNT] = {
 	[0 ... (CONFIG_BT_MESH_SUBNET_COUNT - 1)] = {
@@ -43,11 +44,51 @@ static struct bt_mesh_subnet subnets[CONFIG_BT_MESH_SUBNET_COUNT] = {
 	},
 };
 
+#if defined(CONFIG_BT_MESH_FRIEND)
+#define FRIEND_CRED_COUNT (CONFIG_BT_MESH_FRIEND_LPN_COUNT * 2)
+#else
+#define FRIEND_CRED_COUNT 0
+#endif
+
+#define CRED_NONE 0xff
+
+/* NID to network credential index for the RX path, rebuilt on the next
+ * received PDU after any key or Friendship change.
+ */
+struct net_cred_entry {
+	const struct bt_mesh_net_cred *cred;
+	struct bt_mesh_subnet *sub;
+	uint8_t next;               /* Next entry with the same NID */
+	uint8_t new_key:1,
+		friend_cred:1;
+};
+
+enum {
+	CRED_INDEX_VALID,
+
+	CRED_INDEX_FLAGS,
+};
+
+static struct {
+	ATOMIC_DEFINE(flags, CRED_INDEX_FLAGS);
+	uint8_t nid[128];           /* First entry of each NID */
+	uint8_t count;
+	struct net_cred_entry entries[CONFIG_BT_MESH_SUBNET_COUNT * 2 +
+				      FRIEND_CRED_COUNT];
+} cred_index;
+
+BUILD_ASSERT(ARRAY_SIZE(cred_index.entries) < CRED_NONE);
+
+static struct bt_mesh_net_cred_stats cred_stats;
+
 static void subnet_evt(struct bt_mesh_subnet *sub, enum bt_mesh_key_evt evt)
 {
 	Z_STRUCT_SECTION_FOREACH(bt_mesh_subnet_cb, cb) {
 		cb->evt_handler(sub, evt);
 	}
+
+	/* The handlers may have changed Friendship credentials too */
+	bt_mesh_net_creds_changed();
 }
 
 uint8_t bt_mesh_net_flags(struct bt_mesh_subnet *sub)
@@ -143,6 +184,11 @@ static void subnet_del(struct bt_mesh_subnet *sub)
 
 	bt_mesh_net_loopback_clear(sub->net_idx);
 
+	/* Like a revoked key, the credentials are gone before the handlers
+	 * run, so that the NID index can't be rebuilt with them in between.
+	 */
+	(void)memset(sub->keys, 0, sizeof(sub->keys));
+
 	subnet_evt(sub, BT_MESH_KEY_DELETED);
 	(void)memset(sub, 0, sizeof(*sub));
 	sub->net_idx = BT_MESH_KEY_UNUSED;
@@ -151,12 +197,29 @@ static void subnet_del(struct bt_mesh_subnet *sub)
 static int msg_cred_create(struct bt_mesh_net_cred *cred, const uint8_t *p,
 			   size_t p_len, const uint8_t key[16])
 {
-	return bt_mesh_k2(key, p, p_len, &cred->nid, cred->enc, cred->privacy);
+	uint8_t enc[16], privacy[16];
+	int err;
+
+	err = bt_mesh_k2(key, p, p_len, &cred->nid, enc, privacy);
+	if (err) {
+		return err;
+	}
+
+	BT_DBG("NID 0x%02x EncKey %s", cred->nid, bt_hex(enc, 16));
+	BT_DBG("PrivacyKey %s", bt_hex(privacy, 16));
+
+	err = bt_aes_key_set(&cred->enc, enc);
+	if (err) {
+		return err;
+	}
+
+	return bt_aes_key_set(&cred->privacy, privacy);
 }
 
 static int net_keys_create(struct bt_mesh_subnet_keys *keys,
 			   const uint8_t key[16])
 {
+	uint8_t tmp[16];
 	uint8_t p = 0;
 	int err;
 
@@ -168,10 +231,6 @@ static int net_keys_create(struct bt_mesh_subnet_keys *keys,
 
 	memcpy(keys->net, key, 16);
 
-	BT_DBG("NID 0x%02x EncKey %s", keys->msg.nid,
-	       bt_hex(keys->msg.enc, 16));
-	BT_DBG("PrivacyKey %s", bt_hex(keys->msg.privacy, 16));
-
 	err = bt_mesh_k3(key, keys->net_id);
 	if (err) {
 		BT_ERR("Unable to generate Net ID");
@@ -181,22 +240,30 @@ static int net_keys_create(struct bt_mesh_subnet_keys *keys,
 	BT_DBG("NetID %s", bt_hex(keys->net_id, 8));
 
 #if defined(CONFIG_BT_MESH_GATT_PROXY)
-	err = bt_mesh_identity_key(key, keys->identity);
+	err = bt_mesh_identity_key(key, tmp);
+	if (!err) {
+		err = bt_aes_key_set(&keys->identity, tmp);
+	}
+
 	if (err) {
 		BT_ERR("Unable to generate IdentityKey");
 		return err;
 	}
 
-	BT_DBG("IdentityKey %s", bt_hex(keys->identity, 16));
+	BT_DBG("IdentityKey %s", bt_hex(tmp, 16));
 #endif /* GATT_PROXY */
 
-	err = bt_mesh_beacon_key(key, keys->beacon);
+	err = bt_mesh_beacon_key(key, tmp);
+	if (!err) {
+		err = bt_aes_key_set(&keys->beacon, tmp);
+	}
+
 	if (err) {
 		BT_ERR("Unable to generate beacon key");
 		return err;
 	}
 
-	BT_DBG("BeaconKey %s", bt_hex(keys->beacon, 16));
+	BT_DBG("BeaconKey %s", bt_hex(tmp, 16));
 
 	keys->valid = 1U;
 
@@ -503,6 +570,8 @@ int bt_mesh_subnet_set(uint16_t net_idx, uint8_t kr_phase,
 		sub->node_id = BT_MESH_NODE_IDENTITY_NOT_SUPPORTED;
 	}
 
+	bt_mesh_net_creds_changed();
+
 	/* Make sure we have valid beacon data to be sent */
 	bt_mesh_beacon_update(sub);
 
@@ -580,6 +649,93 @@ void bt_mesh_net_keys_reset(void)
 	}
 }
 
+static void cred_index_add(const struct bt_mesh_net_cred *cred,
+			   struct bt_mesh_subnet *sub, uint8_t key_idx,
+			   bool friend_cred)
+{
+	struct net_cred_entry *entry = &cred_index.entries[cred_index.count];
+	uint8_t *next = &cred_index.nid[cred->nid];
+
+	/* Keep the walk order: Friendship credentials before the subnets' */
+	while (*next != CRED_NONE) {
+		next = &cred_index.entries[*next].next;
+	}
+
+	*next = cred_index.count++;
+
+	entry->cred = cred;
+	entry->sub = sub;
+	entry->next = CRED_NONE;
+	entry->new_key = (key_idx > 0);
+	entry->friend_cred = friend_cred;
+}
+
+static void cred_index_build(void)
+{
+	int i, j;
+
+	memset(cred_index.nid, CRED_NONE, sizeof(cred_index.nid));
+	cred_index.count = 0U;
+
+#if defined(CONFIG_BT_MESH_FRIEND)
+	for (i = 0; i < ARRAY_SIZE(bt_mesh.frnd); i++) {
+		struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
+
+		if (!frnd->subnet) {
+			continue;
+		}
+
+		for (j = 0; j < ARRAY_SIZE(frnd->cred); j++) {
+			if (frnd->subnet->keys[j].valid) {
+				cred_index_add(&frnd->cred[j], frnd->subnet, j,
+					       true);
+			}
+		}
+	}
+#endif
+
+	for (i = 0; i < ARRAY_SIZE(subnets); i++) {
+		struct bt_mesh_subnet *sub = &subnets[i];
+
+		if (sub->net_idx == BT_MESH_KEY_UNUSED) {
+			continue;
+		}
+
+		for (j = 0; j < ARRAY_SIZE(sub->keys); j++) {
+			if (sub->keys[j].valid) {
+				cred_index_add(&sub->keys[j].msg, sub, j,
+					       false);
+			}
+		}
+	}
+
+	BT_DBG("%u credentials indexed", cred_index.count);
+}
+
+void bt_mesh_net_creds_changed(void)
+{
+	atomic_clear_bit(cred_index.flags, CRED_INDEX_VALID);
+}
+
+static void cred_stats_add(uint8_t trials, bool found)
+{
+	cred_stats.trials[MIN(trials, ARRAY_SIZE(cred_stats.trials) - 1)]++;
+
+	if (found) {
+		cred_stats.found++;
+	}
+
+	bt_mesh_stats_evt(found ? BT_MESH_STATS_NET_RX :
+			  BT_MESH_STATS_NET_UNKNOWN, trials);
+
+	BT_DBG("%u trial decryptions, found %u", trials, found);
+}
+
+void bt_mesh_net_cred_stats_get(struct bt_mesh_net_cred_stats *stats)
+{
+	*stats = cred_stats;
+}
+
 bool bt_mesh_net_cred_find(struct bt_mesh_net_rx *rx, struct net_buf_simple *in,
 			   struct net_buf_simple *out,
 			   bool (*cb)(struct bt_mesh_net_rx *rx,
@@ -587,12 +743,15 @@ bool bt_mesh_net_cred_find(struct bt_mesh_net_rx *rx, struct net_buf_simple *in,
 				      struct net_buf_simple *out,
 				      const struct bt_mesh_net_cred *cred))
 {
-	int i, j;
+	uint8_t trials = 0U;
+	uint8_t i;
 
 	BT_DBG("");
 
 #if defined(CONFIG_BT_MESH_LOW_POWER)
 	if (bt_mesh_lpn_established()) {
+		int j;
+
 		rx->sub = bt_mesh.lpn.sub;
 
 		for (j = 0; j < ARRAY_SIZE(bt_mesh.lpn.cred); j++) {
@@ -600,10 +759,13 @@ bool bt_mesh_net_cred_find(struct bt_mesh_net_rx *rx, struct net_buf_simple *in,
 				continue;
 			}
 
+			trials++;
+
 			if (cb(rx, in, out, &bt_mesh.lpn.cred[j])) {
 				rx->new_key = (j > 0);
 				rx->friend_cred = 1U;
 				rx->ctx.net_idx = rx->sub->net_idx;
+				cred_stats_add(trials, true);
 				return true;
 			}
 		}
@@ -611,55 +773,32 @@ bool bt_mesh_net_cred_find(struct bt_mesh_net_rx *rx, struct net_buf_simple *in,
 		/* LPN Should only receive on the friendship credentials when in
 		 * a friendship.
 		 */
+		cred_stats_add(trials, false);
 		return false;
 	}
 #endif
 
-#if defined(CONFIG_BT_MESH_FRIEND)
-	/** Each friendship has unique friendship credentials */
-	for (i = 0; i < ARRAY_SIZE(bt_mesh.frnd); i++) {
-		struct bt_mesh_friend *frnd = &bt_mesh.frnd[i];
-
-		if (!frnd->subnet) {
-			continue;
-		}
-
-		rx->sub = frnd->subnet;
-
-		for (j = 0; j < ARRAY_SIZE(frnd->cred); j++) {
-			if (!rx->sub->keys[j].valid) {
-				continue;
-			}
-
-			if (cb(rx, in, out, &frnd->cred[j])) {
-				rx->new_key = (j > 0);
-				rx->friend_cred = 1U;
-				rx->ctx.net_idx = rx->sub->net_idx;
-				return true;
-			}
-		}
+	if (!atomic_test_and_set_bit(cred_index.flags, CRED_INDEX_VALID)) {
+		cred_index_build();
 	}
-#endif
 
-	for (i = 0; i < ARRAY_SIZE(subnets); i++) {
-		rx->sub = &subnets[i];
-		if (rx->sub->net_idx == BT_MESH_KEY_UNUSED) {
-			continue;
-		}
+	/* Only the credentials with the NID of the PDU can decrypt it */
+	for (i = cred_index.nid[in->data[0] & 0x7f]; i != CRED_NONE;
+	     i = cred_index.entries[i].next) {
+		const struct net_cred_entry *entry = &cred_index.entries[i];
 
-		for (j = 0; j < ARRAY_SIZE(rx->sub->keys); j++) {
-			if (!rx->sub->keys[j].valid) {
-				continue;
-			}
+		rx->sub = entry->sub;
+		trials++;
 
-			if (cb(rx, in, out, &rx->sub->keys[j].msg)) {
-				rx->new_key = (j > 0);
-				rx->friend_cred = 0U;
-				rx->ctx.net_idx = rx->sub->net_idx;
-				return true;
-			}
+		if (cb(rx, in, out, entry->cred)) {
+			rx->new_key = entry->new_key;
+			rx->friend_cred = entry->friend_cred;
+			rx->ctx.net_idx = rx->sub->net_idx;
+			cred_stats_add(trials, true);
+			return true;
 		}
 	}
 
+	cred_stats_add(trials, false);
 	return false;
 }
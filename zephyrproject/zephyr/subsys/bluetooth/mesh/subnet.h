@@ -11,6 +11,7 @@
 #include <sys/types.h>
 #include <net/buf.h>
 #include <zephyr.h>
+#include <bluetooth/crypto.h>
 
 #define BT_MESH_NET_FLAG_KR       BIT(0)
 #define BT_MESH_NET_FLAG_IVU      BIT(1)
@@ -26,11 +27,11 @@
 struct bt_mesh_net_rx;
 enum bt_mesh_key_evt;
 
-/** Network message encryption credentials */
+/** Network message encryption credentials, keys are kept expanded */
 struct bt_mesh_net_cred {
-	uint8_t nid;         /* NID */
-	uint8_t enc[16];     /* EncKey */
-	uint8_t privacy[16]; /* PrivacyKey */
+	uint8_t nid;                /* NID */
+	struct bt_aes_key enc;      /* EncKey */
+	struct bt_aes_key privacy;  /* PrivacyKey */
 };
 
 /** Subnet instance. */
@@ -60,9 +61,9 @@ struct bt_mesh_subnet {
 		struct bt_mesh_net_cred msg;
 		uint8_t net_id[8];     /* Network ID */
 	#if defined(CONFIG_BT_MESH_GATT_PROXY)
-		uint8_t identity[16];  /* IdentityKey */
+		struct bt_aes_key identity;  /* IdentityKey */
 	#endif
-		uint8_t beacon[16];    /* BeaconKey */
+		struct bt_aes_key beacon;    /* BeaconKey */
 	} keys[2];
 };
 
@@ -153,7 +154,32 @@ int bt_mesh_friend_cred_create(struct bt_mesh_net_cred *cred,
 			       uint16_t lpn_counter, uint16_t frnd_counter,
 			       const uint8_t key[16]);
 
+/** Trial decryption statistics of received network PDUs. */
+struct bt_mesh_net_cred_stats {
+	/** PDUs that were decrypted by one of the credentials. */
+	uint32_t found;
+	/** PDUs by the number of credentials tried on them, the last entry
+	 *  counts three or more.
+	 */
+	uint32_t trials[4];
+};
+
+/** @brief Notify that network or Friendship credentials changed.
+ *
+ *  Marks the NID index used by @ref bt_mesh_net_cred_find as stale, so it
+ *  gets rebuilt before the next PDU is looked up.
+ */
+void bt_mesh_net_creds_changed(void);
+
+/** @brief Get the trial decryption statistics.
+ *
+ *  @param stats Statistics return parameter.
+ */
+void bt_mesh_net_cred_stats_get(struct bt_mesh_net_cred_stats *stats);
+
 /** @brief Iterate through all valid network credentials to decrypt a message.
+ *
+ *  Only the credentials with the NID of the PDU in @c in are tried.
  *
  *  @param rx Network RX parameters, passed to the callback.
  *  @param in Input message buffer, passed to the callback.
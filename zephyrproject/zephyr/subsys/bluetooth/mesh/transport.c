@@ -37,6 +37,8 @@
 #include "settings.h"
 #include "heartbeat.h"
 #include "transport.h"
+#include "stats.h"
+#include "sar.h"
 
 #define AID_MASK                    ((uint8_t)(BIT_MASK(6)))
 
@@ -101,6 +103,13 @@ static struct seg_tx {
 	const struct bt_mesh_send_cb *cb;
 	void                  *cb_data;
 	struct k_delayed_work retransmit;    /* Retransmit timer */
+#if defined(CONFIG_BT_MESH_TX_SEG_ADAPTIVE)
+	uint32_t              round_end;     /* Uptime the round was sent */
+	uint8_t               round_segs;    /* Segments sent in the round */
+	uint8_t               backoff;       /* Unanswered rounds in a row */
+	uint8_t               in_round:1,    /* Round is being queued */
+			      acked:1;       /* Acked during the round */
+#endif
 } seg_tx[CONFIG_BT_MESH_TX_SEG_MSG_COUNT];
 
 static struct seg_rx {
@@ -118,20 +127,74 @@ static struct seg_rx {
 	uint8_t                     ttl;
 	uint32_t                    block;
 	uint32_t                    last;
+	uint32_t                    ack_block; /* Block of the last ack */
+	uint32_t                    ack_sent;  /* Uptime of the last ack */
+	struct net_buf             *ack_buf;   /* Last ack, NULL once sent */
 	struct k_delayed_work    ack;
 } seg_rx[CONFIG_BT_MESH_RX_SEG_MSG_COUNT];
 
 K_MEM_SLAB_DEFINE(segs, BT_MESH_APP_SEG_SDU_MAX, CONFIG_BT_MESH_SEG_BUFS, 4);
 
+/* Contexts are referred to by their index plus one in the lookup indexes,
+ * so that zero ends a hash chain.
+ */
+#define SEG_IDX(arr, ctx)   ((uint8_t)((ctx) - (arr)) + 1)
+#define SEG_ENTRY(arr, idx) (&(arr)[(idx) - 1])
+
+/* Outgoing messages indexed on SeqZero, which is what the acks carry. A
+ * context is in its hash chain while it has a destination.
+ */
+static struct {
+	uint8_t bucket[CONFIG_BT_MESH_TX_SEG_MSG_COUNT];
+	uint8_t next[CONFIG_BT_MESH_TX_SEG_MSG_COUNT];
+} seg_tx_index;
+
+/* Incoming messages indexed on their source and destination, which only
+ * have one message in progress at a time. A context is in its hash chain
+ * while it has a source, including after completing, so that late segments
+ * still get acked.
+ */
+static struct {
+	uint8_t bucket[CONFIG_BT_MESH_RX_SEG_MSG_COUNT];
+	uint8_t next[CONFIG_BT_MESH_RX_SEG_MSG_COUNT];
+} seg_rx_index;
+
+/* An incomplete incoming message that got no segments for this long has
+ * most likely been given up by its sender, which retransmits far more
+ * often than this. It is dropped when its resources are needed by others.
+ */
+#define SEG_RX_STALE_MS (5 * MSEC_PER_SEC)
+
+/* The receiver holds its ack this much longer per missing segment */
+#define SEG_ACK_MISSING_MS 100
+
+/* An ack timer expiring within this long of the last new segment waits
+ * for the rest of the round, as ack_timeout() allows as much per segment.
+ */
+#define SEG_ACK_DEFER_MS SEG_ACK_MISSING_MS
+
+/* The same block is not acked again for this long, which is shorter than
+ * the 200 + 50 * TTL ms the sender waits for the ack before retransmitting.
+ */
+#define SEG_ACK_REPEAT_MS(ttl) (150 + 50 * (ttl))
+
 static struct bt_mesh_va virtual_addrs[CONFIG_BT_MESH_LABEL_COUNT];
 
+/* If held isn't NULL, it gets a reference to the buffer passed on to the
+ * network layer, so that it can be canceled while still queued.
+ */
 static int send_unseg(struct bt_mesh_net_tx *tx, struct net_buf_simple *sdu,
 		      const struct bt_mesh_send_cb *cb, void *cb_data,
-		      const uint8_t *ctl_op)
+		      const uint8_t *ctl_op, struct net_buf **held)
 {
+	enum bt_mesh_adv_tag tag = BT_MESH_LOCAL_ADV;
 	struct net_buf *buf;
 
-	buf = bt_mesh_adv_create(BT_MESH_ADV_DATA, tx->xmit, BUF_TIMEOUT);
+	if (ctl_op && *ctl_op == TRANS_CTL_OP_ACK) {
+		tag = BT_MESH_ACK_ADV;
+	}
+
+	buf = bt_mesh_adv_create(BT_MESH_ADV_DATA, tag, tx->xmit, BUF_TIMEOUT);
 	if (!buf) {
 		BT_ERR("Out of network buffers");
 		return -ENOBUFS;
@@ -176,6 +239,10 @@ static int send_unseg(struct bt_mesh_net_tx *tx, struct net_buf_simple *sdu,
 	}
 
 send:
+	if (held) {
+		*held = net_buf_ref(buf);
+	}
+
 	return bt_mesh_net_send(tx, buf, cb, cb_data);
 }
 
@@ -236,11 +303,41 @@ static void seg_tx_unblock_check(struct seg_tx *tx)
 	}
 }
 
+static inline uint8_t *seg_tx_bucket(uint16_t seq_zero)
+{
+	return &seg_tx_index.bucket[seq_zero % ARRAY_SIZE(seg_tx)];
+}
+
+static void seg_tx_link(struct seg_tx *tx)
+{
+	uint8_t *bucket = seg_tx_bucket(tx->seq_auth & TRANS_SEQ_ZERO_MASK);
+
+	seg_tx_index.next[SEG_IDX(seg_tx, tx) - 1] = *bucket;
+	*bucket = SEG_IDX(seg_tx, tx);
+}
+
+static void seg_tx_unlink(struct seg_tx *tx)
+{
+	uint8_t idx = SEG_IDX(seg_tx, tx);
+	uint8_t *i;
+
+	if (tx->dst == BT_MESH_ADDR_UNASSIGNED) {
+		return;
+	}
+
+	for (i = seg_tx_bucket(tx->seq_auth & TRANS_SEQ_ZERO_MASK); *i != idx;
+	     i = &seg_tx_index.next[*i - 1]) {
+	}
+
+	*i = seg_tx_index.next[idx - 1];
+}
+
 static void seg_tx_reset(struct seg_tx *tx)
 {
 	int i;
 
 	k_delayed_work_cancel(&tx->retransmit);
+	seg_tx_unlink(tx);
 
 	tx->cb = NULL;
 	tx->cb_data = NULL;
@@ -250,6 +347,13 @@ static void seg_tx_reset(struct seg_tx *tx)
 	tx->dst = BT_MESH_ADDR_UNASSIGNED;
 	tx->blocked = false;
 
+#if defined(CONFIG_BT_MESH_TX_SEG_ADAPTIVE)
+	tx->round_end = 0U;
+	tx->backoff = 0U;
+	tx->in_round = 0U;
+	tx->acked = 0U;
+#endif
+
 	for (i = 0; i <= tx->seg_n && tx->nack_count; i++) {
 		if (!tx->seg[i]) {
 			continue;
@@ -283,6 +387,134 @@ static inline void seg_tx_complete(struct seg_tx *tx, int err)
 	}
 }
 
+#if defined(CONFIG_BT_MESH_TX_SEG_ADAPTIVE)
+/* A round is one pass over the unacked segments. Rounds to unicast
+ * destinations are timed to keep a round trip and loss estimate per
+ * destination, which sets the retransmit timeout and how many segments
+ * get queued on the advertising bearer at once.
+ */
+static int32_t seg_retransmit_timeout(struct seg_tx *tx)
+{
+	if (!BT_MESH_ADDR_IS_UNICAST(tx->dst)) {
+		return SEG_RETRANSMIT_TIMEOUT_GROUP;
+	}
+
+	return bt_mesh_sar_timeout(bt_mesh_sar_peer_get(tx->dst), tx->ttl,
+				   tx->backoff);
+}
+
+static bool seg_tx_window_full(struct seg_tx *tx)
+{
+	uint8_t window = CONFIG_BT_MESH_TX_SEG_WINDOW;
+
+	if (BT_MESH_ADDR_IS_UNICAST(tx->dst)) {
+		window = bt_mesh_sar_peer_get(tx->dst)->window;
+	}
+
+	return tx->seg_pending >= window;
+}
+
+static bool seg_tx_round_queued(struct seg_tx *tx)
+{
+	return !tx->in_round;
+}
+
+static void seg_tx_round_start(struct seg_tx *tx)
+{
+	if (tx->in_round) {
+		return;
+	}
+
+	/* Back off exponentially while rounds go unanswered */
+	if (tx->attempts < SEG_RETRANSMIT_ATTEMPTS) {
+		tx->backoff = tx->acked ? 0 : MIN(tx->backoff + 1,
+						  BT_MESH_SAR_BACKOFF_MAX);
+	}
+
+	tx->in_round = 1U;
+	tx->acked = 0U;
+	tx->round_end = 0U;
+	tx->round_segs = 0U;
+}
+
+static void seg_tx_round_sent(struct seg_tx *tx)
+{
+	tx->round_segs++;
+}
+
+static void seg_tx_round_end(struct seg_tx *tx)
+{
+	tx->in_round = 0U;
+}
+
+static void seg_tx_round_on_air(struct seg_tx *tx)
+{
+	tx->round_end = k_uptime_get_32();
+}
+
+static void seg_tx_acked(struct seg_tx *tx)
+{
+	uint32_t rtt = 0U;
+
+	tx->acked = 1U;
+
+	/* Acks that come before the whole round went out say nothing about
+	 * the losses.
+	 */
+	if (!BT_MESH_ADDR_IS_UNICAST(tx->dst) || !tx->round_end) {
+		return;
+	}
+
+	/* Acks after a retransmission may answer either round, so only the
+	 * first round is timed. The time the receiver deliberately held the
+	 * ack for the missing segments is not part of the round trip, and
+	 * would otherwise make the retransmit timeout grow with the loss.
+	 */
+	if (tx->attempts == SEG_RETRANSMIT_ATTEMPTS - 1) {
+		uint32_t hold = tx->nack_count * SEG_ACK_MISSING_MS;
+
+		rtt = k_uptime_get_32() - tx->round_end;
+		rtt = rtt > hold ? rtt - hold : 1;
+	}
+
+	bt_mesh_sar_ack(bt_mesh_sar_peer_get(tx->dst), rtt, tx->round_segs,
+			tx->nack_count);
+	tx->round_end = 0U;
+}
+#else
+#define seg_retransmit_timeout(tx) SEG_RETRANSMIT_TIMEOUT(tx)
+
+static inline bool seg_tx_window_full(struct seg_tx *tx)
+{
+	return false;
+}
+
+static inline bool seg_tx_round_queued(struct seg_tx *tx)
+{
+	return !tx->seg_o;
+}
+
+static inline void seg_tx_round_start(struct seg_tx *tx)
+{
+}
+
+static inline void seg_tx_round_sent(struct seg_tx *tx)
+{
+}
+
+static inline void seg_tx_round_end(struct seg_tx *tx)
+{
+}
+
+static inline void seg_tx_round_on_air(struct seg_tx *tx)
+{
+}
+
+static inline void seg_tx_acked(struct seg_tx *tx)
+{
+}
+#endif /* CONFIG_BT_MESH_TX_SEG_ADAPTIVE */
+
 static void schedule_retransmit(struct seg_tx *tx)
 {
 	if (!tx->nack_count) {
@@ -296,13 +528,19 @@ static void schedule_retransmit(struct seg_tx *tx)
 	BT_DBG("");
 
 	/* If we haven't gone through all the segments for this attempt yet,
-	 * (likely because of a buffer allocation failure or because we
-	 * called this from inside bt_mesh_net_send), we should continue the
-	 * retransmit immediately, as we just freed up a tx buffer.
+	 * (likely because of a buffer allocation failure, a full window or
+	 * because we called this from inside bt_mesh_net_send), we should
+	 * continue the retransmit immediately, as we just freed up a tx
+	 * buffer.
 	 */
+	if (!seg_tx_round_queued(tx)) {
+		k_delayed_work_submit(&tx->retransmit, K_NO_WAIT);
+		return;
+	}
+
+	seg_tx_round_on_air(tx);
 	k_delayed_work_submit(&tx->retransmit,
-			      tx->seg_o ? K_NO_WAIT :
-					  K_MSEC(SEG_RETRANSMIT_TIMEOUT(tx)));
+			      K_MSEC(seg_retransmit_timeout(tx)));
 }
 
 static void seg_send_start(uint16_t duration, int err, void *user_data)
@@ -388,6 +626,8 @@ static void seg_tx_send_unacked(struct seg_tx *tx)
 	BT_DBG("SeqZero: 0x%04x Attempts: %u",
 	       (uint16_t)(tx->seq_auth & TRANS_SEQ_ZERO_MASK), tx->attempts);
 
+	seg_tx_round_start(tx);
+
 	tx->sending = 1U;
 
 	for (; tx->seg_o <= tx->seg_n; tx->seg_o++) {
@@ -398,8 +638,13 @@ static void seg_tx_send_unacked(struct seg_tx *tx)
 			continue;
 		}
 
-		seg = bt_mesh_adv_create(BT_MESH_ADV_DATA, tx->xmit,
-					 BUF_TIMEOUT);
+		if (seg_tx_window_full(tx)) {
+			BT_DBG("Window full");
+			goto end;
+		}
+
+		seg = bt_mesh_adv_create(BT_MESH_ADV_DATA, BT_MESH_LOCAL_ADV,
+					 tx->xmit, BUF_TIMEOUT);
 		if (!seg) {
 			BT_DBG("Allocating segment failed");
 			goto end;
@@ -418,15 +663,22 @@ static void seg_tx_send_unacked(struct seg_tx *tx)
 			tx->seg_pending--;
 			goto end;
 		}
+
+		if (tx->attempts < SEG_RETRANSMIT_ATTEMPTS) {
+			bt_mesh_stats_evt(BT_MESH_STATS_SEG_RETRANSMIT, 0);
+		}
+
+		seg_tx_round_sent(tx);
 	}
 
 	tx->seg_o = 0U;
 	tx->attempts--;
+	seg_tx_round_end(tx);
 
 end:
 	if (!tx->seg_pending) {
 		k_delayed_work_submit(&tx->retransmit,
-				      K_MSEC(SEG_RETRANSMIT_TIMEOUT(tx)));
+				      K_MSEC(seg_retransmit_timeout(tx)));
 	}
 
 	tx->sending = 0U;
@@ -494,6 +746,8 @@ static int send_seg(struct bt_mesh_net_tx *net_tx, struct net_buf_simple *sdu,
 	tx->ctl = !!ctl_op;
 	tx->ttl = net_tx->ctx->send_ttl;
 
+	seg_tx_link(tx);
+
 	BT_DBG("SeqZero 0x%04x (segs: %u)",
 	       (uint16_t)(tx->seq_auth & TRANS_SEQ_ZERO_MASK), tx->nack_count);
 
@@ -586,7 +840,8 @@ static int send_seg(struct bt_mesh_net_tx *net_tx, struct net_buf_simple *sdu,
 	return 0;
 }
 
-static int trans_encrypt(const struct bt_mesh_net_tx *tx, const uint8_t *key,
+static int trans_encrypt(const struct bt_mesh_net_tx *tx,
+			 const struct bt_aes_key *key,
 			 struct net_buf_simple *msg)
 {
 	struct bt_mesh_app_crypto_ctx crypto = {
@@ -608,7 +863,8 @@ static int trans_encrypt(const struct bt_mesh_net_tx *tx, const uint8_t *key,
 int bt_mesh_trans_send(struct bt_mesh_net_tx *tx, struct net_buf_simple *msg,
 		       const struct bt_mesh_send_cb *cb, void *cb_data)
 {
-	const uint8_t *key;
+	const struct bt_aes_key *key;
+	struct bt_aes_key dev_key;
 	uint8_t aid;
 	int err;
 
@@ -649,7 +905,7 @@ int bt_mesh_trans_send(struct bt_mesh_net_tx *tx, struct net_buf_simple *msg,
 	       tx->ctx->app_idx, tx->ctx->addr);
 	BT_DBG("len %u: %s", msg->len, bt_hex(msg->data, msg->len));
 
-	err = bt_mesh_keys_resolve(tx->ctx, &tx->sub, &key, &aid);
+	err = bt_mesh_keys_resolve(tx->ctx, &tx->sub, &key, &aid, &dev_key);
 	if (err) {
 		return err;
 	}
@@ -671,7 +927,7 @@ int bt_mesh_trans_send(struct bt_mesh_net_tx *tx, struct net_buf_simple *msg,
 	if (tx->ctx->send_rel) {
 		err = send_seg(tx, msg, cb, cb_data, NULL);
 	} else {
-		err = send_unseg(tx, msg, cb, cb_data, NULL);
+		err = send_unseg(tx, msg, cb, cb_data, NULL, NULL);
 	}
 
 	return err;
@@ -685,9 +941,11 @@ static void seg_rx_assemble(struct seg_rx *rx, struct net_buf_simple *buf,
 	net_buf_simple_reset(buf);
 
 	for (i = 0; i <= rx->seg_n; i++) {
-		net_buf_simple_add_mem(buf, rx->seg[i],
-				       MIN(seg_len(rx->ctl),
-					   rx->len - (i * seg_len(rx->ctl))));
+		size_t len = MIN(seg_len(rx->ctl),
+				 rx->len - (i * seg_len(rx->ctl)));
+
+		net_buf_simple_add_mem(buf, rx->seg[i], len);
+		bt_mesh_net_rx_copied(len);
 	}
 
 	/* Adjust the length to not contain the MIC at the end */
@@ -701,20 +959,31 @@ struct decrypt_ctx {
 	struct net_buf_simple *buf;
 	struct net_buf_simple *sdu;
 	struct seg_rx *seg;
+	bool stale; /* buf must be reassembled from seg before decrypting */
 };
 
-static int sdu_try_decrypt(struct bt_mesh_net_rx *rx, const uint8_t key[16],
-			   void *cb_data)
+static int sdu_try_decrypt(struct bt_mesh_net_rx *rx,
+			   const struct bt_aes_key *key, void *cb_data)
 {
-	const struct decrypt_ctx *ctx = cb_data;
+	struct decrypt_ctx *ctx = cb_data;
+	int err;
 
-	if (ctx->seg) {
+	/* Segmented SDUs are decrypted in place, so the segments only have
+	 * to be assembled again if a previous attempt overwrote them.
+	 */
+	if (ctx->seg && ctx->stale) {
 		seg_rx_assemble(ctx->seg, ctx->buf, ctx->crypto.aszmic);
+		ctx->stale = false;
 	}
 
 	net_buf_simple_reset(ctx->sdu);
 
-	return bt_mesh_app_decrypt(key, &ctx->crypto, ctx->buf, ctx->sdu);
+	err = bt_mesh_app_decrypt(key, &ctx->crypto, ctx->buf, ctx->sdu);
+	if (err && ctx->seg) {
+		ctx->stale = true;
+	}
+
+	return err;
 }
 
 static int sdu_recv(struct bt_mesh_net_rx *rx, uint8_t hdr, uint8_t aszmic,
@@ -733,6 +1002,7 @@ static int sdu_recv(struct bt_mesh_net_rx *rx, uint8_t hdr, uint8_t aszmic,
 		.buf = buf,
 		.sdu = sdu,
 		.seg = seg,
+		.stale = true,
 	};
 
 	BT_DBG("AKF %u AID 0x%02x", !ctx.crypto.dev_key, AID(&hdr));
@@ -764,10 +1034,11 @@ static int sdu_recv(struct bt_mesh_net_rx *rx, uint8_t hdr, uint8_t aszmic,
 static struct seg_tx *seg_tx_lookup(uint16_t seq_zero, uint8_t obo, uint16_t addr)
 {
 	struct seg_tx *tx;
-	int i;
+	uint8_t idx;
 
-	for (i = 0; i < ARRAY_SIZE(seg_tx); i++) {
-		tx = &seg_tx[i];
+	for (idx = *seg_tx_bucket(seq_zero); idx;
+	     idx = seg_tx_index.next[idx - 1]) {
+		tx = SEG_ENTRY(seg_tx, idx);
 
 		if ((tx->seq_auth & TRANS_SEQ_ZERO_MASK) != seq_zero) {
 			continue;
@@ -798,6 +1069,7 @@ static int trans_ack(struct bt_mesh_net_rx *rx, uint8_t hdr,
 	unsigned int bit;
 	uint32_t ack;
 	uint16_t seq_zero;
+	uint8_t nack_count;
 	uint8_t obo;
 
 	if (buf->len < 6) {
@@ -846,6 +1118,8 @@ static int trans_ack(struct bt_mesh_net_rx *rx, uint8_t hdr,
 
 	k_delayed_work_cancel(&tx->retransmit);
 
+	nack_count = tx->nack_count;
+
 	while ((bit = find_lsb_set(ack))) {
 		if (tx->seg[bit - 1]) {
 			BT_DBG("seg %u/%u acked", bit - 1, tx->seg_n);
@@ -855,6 +1129,10 @@ static int trans_ack(struct bt_mesh_net_rx *rx, uint8_t hdr,
 		ack &= ~BIT(bit - 1);
 	}
 
+	if (tx->nack_count < nack_count) {
+		seg_tx_acked(tx);
+	}
+
 	if (tx->nack_count) {
 		seg_tx_send_unacked(tx);
 	} else {
@@ -983,7 +1261,7 @@ static inline int32_t ack_timeout(struct seg_rx *rx)
 	to = 150 + (ttl * 50U);
 
 	/* 100 ms for every not yet received segment */
-	to += ((rx->seg_n + 1) - popcount(rx->block)) * 100U;
+	to += ((rx->seg_n + 1) - popcount(rx->block)) * SEG_ACK_MISSING_MS;
 
 	/* Make sure we don't send more frequently than the duration for
 	 * each packet (default is 300ms).
@@ -1025,12 +1303,40 @@ int bt_mesh_ctl_send(struct bt_mesh_net_tx *tx, uint8_t ctl_op, void *data,
 	if (tx->ctx->send_rel) {
 		return send_seg(tx, &buf, cb, cb_data, &ctl_op);
 	} else {
-		return send_unseg(tx, &buf, cb, cb_data, &ctl_op);
+		return send_unseg(tx, &buf, cb, cb_data, &ctl_op, NULL);
 	}
 }
 
+static void seg_ack_sent(uint16_t duration, int err, void *cb_data)
+{
+	struct seg_rx *rx = cb_data;
+
+	/* Acks replaced while still queued never get here */
+	if (!err) {
+		bt_mesh_stats_evt(BT_MESH_STATS_ACK_SENT, 0);
+	}
+
+	if (!rx) {
+		return;
+	}
+
+	/* The buffer may already have been replaced by a newer ack that is
+	 * still queued.
+	 */
+	if (rx->ack_buf && !BT_MESH_ADV(rx->ack_buf)->busy) {
+		net_buf_unref(rx->ack_buf);
+		rx->ack_buf = NULL;
+	}
+}
+
+static const struct bt_mesh_send_cb seg_ack_cb = {
+	.start = seg_ack_sent,
+};
+
+/* If rx isn't NULL, the ack is kept in it until it has been sent */
 static int send_ack(struct bt_mesh_subnet *sub, uint16_t src, uint16_t dst,
-		    uint8_t ttl, uint64_t *seq_auth, uint32_t block, uint8_t obo)
+		    uint8_t ttl, uint64_t *seq_auth, uint32_t block, uint8_t obo,
+		    struct seg_rx *rx)
 {
 	struct bt_mesh_msg_ctx ctx = {
 		.net_idx = sub->net_idx,
@@ -1045,6 +1351,8 @@ static int send_ack(struct bt_mesh_subnet *sub, uint16_t src, uint16_t dst,
 		.xmit = bt_mesh_net_transmit_get(),
 	};
 	uint16_t seq_zero = *seq_auth & TRANS_SEQ_ZERO_MASK;
+	uint8_t ctl_op = TRANS_CTL_OP_ACK;
+	struct net_buf_simple sdu;
 	uint8_t buf[6];
 
 	BT_DBG("SeqZero 0x%04x Block 0x%08x OBO %u", seq_zero, block, obo);
@@ -1065,8 +1373,87 @@ static int send_ack(struct bt_mesh_subnet *sub, uint16_t src, uint16_t dst,
 	sys_put_be16(((seq_zero << 2) & 0x7ffc) | (obo << 15), buf);
 	sys_put_be32(block, &buf[2]);
 
-	return bt_mesh_ctl_send(&tx, TRANS_CTL_OP_ACK, buf, sizeof(buf),
-				NULL, NULL);
+	net_buf_simple_init_with_data(&sdu, buf, sizeof(buf));
+
+	return send_unseg(&tx, &sdu, &seg_ack_cb, rx, &ctl_op,
+			  rx ? &rx->ack_buf : NULL);
+}
+
+/* Drop the last ack of rx if it is still waiting in the advertising queue */
+static void seg_rx_ack_cancel(struct seg_rx *rx)
+{
+	if (rx->ack_buf && BT_MESH_ADV(rx->ack_buf)->busy) {
+		BT_MESH_ADV(rx->ack_buf)->busy = 0U;
+		bt_mesh_stats_evt(BT_MESH_STATS_ACK_REPLACED, 0);
+	}
+}
+
+/* Ack the message of rx, unless the same block has just been acked.
+ * Segment Acknowledgments carry the complete block, so an older ack still
+ * waiting in the advertising queue is replaced rather than sent as well.
+ */
+static int seg_rx_ack(struct seg_rx *rx, uint8_t ttl, uint32_t block)
+{
+	uint32_t now = k_uptime_get_32();
+	bool queued = rx->ack_buf && BT_MESH_ADV(rx->ack_buf)->busy;
+	int err;
+
+	/* Late segments come in bursts when the sender missed the ack, and
+	 * the whole burst is answered by a single one.
+	 */
+	if (block == rx->ack_block &&
+	    (queued || now - rx->ack_sent < SEG_ACK_REPEAT_MS(ttl))) {
+		BT_DBG("Block 0x%08x just acked", block);
+		bt_mesh_stats_evt(BT_MESH_STATS_ACK_REPEATED, 0);
+		return 0;
+	}
+
+	seg_rx_ack_cancel(rx);
+
+	if (rx->ack_buf) {
+		net_buf_unref(rx->ack_buf);
+		rx->ack_buf = NULL;
+	}
+
+	err = send_ack(rx->sub, rx->dst, rx->src, ttl, &rx->seq_auth, block,
+		       rx->obo, rx);
+	if (!err) {
+		rx->ack_block = block;
+		rx->ack_sent = now;
+	}
+
+	return err;
+}
+
+static inline uint8_t *seg_rx_bucket(uint16_t src, uint16_t dst)
+{
+	/* Unicast addresses are mostly assigned in sequence */
+	return &seg_rx_index.bucket[(src ^ dst) % ARRAY_SIZE(seg_rx)];
+}
+
+static void seg_rx_link(struct seg_rx *rx)
+{
+	uint8_t *bucket = seg_rx_bucket(rx->src, rx->dst);
+
+	seg_rx_index.next[SEG_IDX(seg_rx, rx) - 1] = *bucket;
+	*bucket = SEG_IDX(seg_rx, rx);
+}
+
+static void seg_rx_unlink(struct seg_rx *rx)
+{
+	uint8_t idx = SEG_IDX(seg_rx, rx);
+	uint8_t *i;
+
+	if (rx->src == BT_MESH_ADDR_UNASSIGNED) {
+		return;
+	}
+
+	for (i = seg_rx_bucket(rx->src, rx->dst); *i != idx;
+	     i = &seg_rx_index.next[*i - 1]) {
+	}
+
+	*i = seg_rx_index.next[idx - 1];
+	rx->src = BT_MESH_ADDR_UNASSIGNED;
 }
 
 static void seg_rx_reset(struct seg_rx *rx, bool full_reset)
@@ -1077,6 +1464,12 @@ static void seg_rx_reset(struct seg_rx *rx, bool full_reset)
 
 	k_delayed_work_cancel(&rx->ack);
 
+	/* A queued ack still gets sent */
+	if (rx->ack_buf) {
+		net_buf_unref(rx->ack_buf);
+		rx->ack_buf = NULL;
+	}
+
 	if (IS_ENABLED(CONFIG_BT_MESH_FRIEND) && rx->obo &&
 	    rx->block != BLOCK_COMPLETE(rx->seg_n)) {
 		BT_WARN("Clearing incomplete buffers from Friend queue");
@@ -1100,9 +1493,9 @@ static void seg_rx_reset(struct seg_rx *rx, bool full_reset)
 	 * the full SDU.
 	 */
 	if (full_reset) {
+		seg_rx_unlink(rx);
 		rx->seq_auth = 0U;
 		rx->sub = NULL;
-		rx->src = BT_MESH_ADDR_UNASSIGNED;
 		rx->dst = BT_MESH_ADDR_UNASSIGNED;
 	}
 }
@@ -1125,8 +1518,17 @@ static void seg_ack(struct k_work *work)
 		return;
 	}
 
-	send_ack(rx->sub, rx->dst, rx->src, rx->ttl, &rx->seq_auth,
-		 rx->block, rx->obo);
+	/* The ack would most likely be made redundant by the one for the
+	 * complete block, if segments are still coming in.
+	 */
+	if (k_uptime_get_32() - rx->last < SEG_ACK_DEFER_MS) {
+		BT_DBG("Deferring ack of block 0x%08x", rx->block);
+		bt_mesh_stats_evt(BT_MESH_STATS_ACK_DEFERRED, 0);
+		k_delayed_work_submit(&rx->ack, K_MSEC(SEG_ACK_DEFER_MS));
+		return;
+	}
+
+	seg_rx_ack(rx, rx->ttl, rx->block);
 
 	timeout = ack_timeout(rx);
 	k_delayed_work_submit(&rx->ack, K_MSEC(timeout));
@@ -1140,10 +1542,11 @@ static inline bool sdu_len_is_ok(bool ctl, uint8_t seg_n)
 static struct seg_rx *seg_rx_find(struct bt_mesh_net_rx *net_rx,
 				  const uint64_t *seq_auth)
 {
-	int i;
+	uint8_t idx;
 
-	for (i = 0; i < ARRAY_SIZE(seg_rx); i++) {
-		struct seg_rx *rx = &seg_rx[i];
+	for (idx = *seg_rx_bucket(net_rx->ctx.addr, net_rx->ctx.recv_dst);
+	     idx; idx = seg_rx_index.next[idx - 1]) {
+		struct seg_rx *rx = SEG_ENTRY(seg_rx, idx);
 
 		if (rx->src != net_rx->ctx.addr ||
 		    rx->dst != net_rx->ctx.recv_dst) {
@@ -1164,6 +1567,7 @@ static struct seg_rx *seg_rx_find(struct bt_mesh_net_rx *net_rx,
 			/* Clear out the old context since the sender
 			 * has apparently started sending a new SDU.
 			 */
+			seg_rx_ack_cancel(rx);
 			seg_rx_reset(rx, true);
 
 			/* Return non-match so caller can re-allocate */
@@ -1195,45 +1599,107 @@ static bool seg_rx_is_valid(struct seg_rx *rx, struct bt_mesh_net_rx *net_rx,
 	return true;
 }
 
+/* Drop the incomplete message that has been stale for the longest time,
+ * other than the one being received. Returns the freed context, if any.
+ */
+static struct seg_rx *seg_rx_evict(const struct seg_rx *keep)
+{
+	uint32_t now = k_uptime_get_32();
+	struct seg_rx *oldest = NULL;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(seg_rx); i++) {
+		struct seg_rx *rx = &seg_rx[i];
+
+		if (!rx->in_use || rx == keep ||
+		    now - rx->last < SEG_RX_STALE_MS) {
+			continue;
+		}
+
+		if (!oldest || now - rx->last > now - oldest->last) {
+			oldest = rx;
+		}
+	}
+
+	if (!oldest) {
+		return NULL;
+	}
+
+	BT_WARN("Dropping stale SDU from src 0x%04x", oldest->src);
+	bt_mesh_stats_evt(BT_MESH_STATS_SEG_EVICT, 0);
+	seg_rx_reset(oldest, true);
+
+	return oldest;
+}
+
 static struct seg_rx *seg_rx_alloc(struct bt_mesh_net_rx *net_rx,
 				   const uint8_t *hdr, const uint64_t *seq_auth,
 				   uint8_t seg_n)
 {
+	uint32_t now = k_uptime_get_32();
+	struct seg_rx *rx = NULL;
+	uint8_t src_count = 0U;
 	int i;
 
+	/* Contexts that completed or expired are only kept for acking late
+	 * segments, and the one that has been idle the longest is reused.
+	 */
+	for (i = 0; i < ARRAY_SIZE(seg_rx); i++) {
+		if (seg_rx[i].in_use) {
+			src_count += (seg_rx[i].src == net_rx->ctx.addr);
+			continue;
+		}
+
+		if (!rx || seg_rx[i].src == BT_MESH_ADDR_UNASSIGNED ||
+		    (rx->src != BT_MESH_ADDR_UNASSIGNED &&
+		     now - seg_rx[i].last > now - rx->last)) {
+			rx = &seg_rx[i];
+		}
+	}
+
+	/* Keep a single source from taking all the contexts */
+	if (src_count >= CONFIG_BT_MESH_RX_SEG_SRC_MSG_COUNT) {
+		BT_WARN("Too many incoming messages from src 0x%04x",
+			net_rx->ctx.addr);
+		return NULL;
+	}
+
+	if (!rx) {
+		rx = seg_rx_evict(NULL);
+		if (!rx) {
+			return NULL;
+		}
+	}
+
 	/* No race condition on this check, as this function only executes in
 	 * the collaborative Bluetooth rx thread:
 	 */
-	if (k_mem_slab_num_free_get(&segs) < 1) {
+	if (k_mem_slab_num_free_get(&segs) < 1 && !seg_rx_evict(rx)) {
 		BT_WARN("Not enough segments for incoming message");
 		return NULL;
 	}
 
-	for (i = 0; i < ARRAY_SIZE(seg_rx); i++) {
-		struct seg_rx *rx = &seg_rx[i];
+	seg_rx_unlink(rx);
 
-		if (rx->in_use) {
-			continue;
-		}
-
-		rx->in_use = 1U;
-		rx->sub = net_rx->sub;
-		rx->ctl = net_rx->ctl;
-		rx->seq_auth = *seq_auth;
-		rx->seg_n = seg_n;
-		rx->hdr = *hdr;
-		rx->ttl = net_rx->ctx.send_ttl;
-		rx->src = net_rx->ctx.addr;
-		rx->dst = net_rx->ctx.recv_dst;
-		rx->block = 0U;
+	rx->in_use = 1U;
+	rx->sub = net_rx->sub;
+	rx->ctl = net_rx->ctl;
+	rx->seq_auth = *seq_auth;
+	rx->seg_n = seg_n;
+	rx->hdr = *hdr;
+	rx->ttl = net_rx->ctx.send_ttl;
+	rx->src = net_rx->ctx.addr;
+	rx->dst = net_rx->ctx.recv_dst;
+	rx->block = 0U;
+	rx->last = now;
+	rx->ack_block = 0U;
 
-		BT_DBG("New RX context. Block Complete 0x%08x",
-		       BLOCK_COMPLETE(seg_n));
+	seg_rx_link(rx);
 
-		return rx;
-	}
+	BT_DBG("New RX context. Block Complete 0x%08x",
+	       BLOCK_COMPLETE(seg_n));
 
-	return NULL;
+	return rx;
 }
 
 static int trans_seg(struct net_buf_simple *buf, struct bt_mesh_net_rx *net_rx,
@@ -1318,9 +1784,7 @@ static int trans_seg(struct net_buf_simple *buf, struct bt_mesh_net_rx *net_rx,
 		if (rx->block == BLOCK_COMPLETE(rx->seg_n)) {
 			BT_DBG("Got segment for already complete SDU");
 
-			send_ack(net_rx->sub, net_rx->ctx.recv_dst,
-				 net_rx->ctx.addr, net_rx->ctx.send_ttl,
-				 seq_auth, rx->block, rx->obo);
+			seg_rx_ack(rx, net_rx->ctx.send_ttl, rx->block);
 
 			if (rpl) {
 				bt_mesh_rpl_update(rpl, net_rx);
@@ -1342,7 +1806,7 @@ static int trans_seg(struct net_buf_simple *buf, struct bt_mesh_net_rx *net_rx,
 		BT_ERR("Too big incoming SDU length");
 		send_ack(net_rx->sub, net_rx->ctx.recv_dst, net_rx->ctx.addr,
 			 net_rx->ctx.send_ttl, seq_auth, 0,
-			 net_rx->friend_match);
+			 net_rx->friend_match, NULL);
 		return -EMSGSIZE;
 	}
 
@@ -1358,7 +1822,7 @@ static int trans_seg(struct net_buf_simple *buf, struct bt_mesh_net_rx *net_rx,
 		BT_ERR("No space in Friend Queue for %u segments", *seg_count);
 		send_ack(net_rx->sub, net_rx->ctx.recv_dst, net_rx->ctx.addr,
 			 net_rx->ctx.send_ttl, seq_auth, 0,
-			 net_rx->friend_match);
+			 net_rx->friend_match, NULL);
 		return -ENOBUFS;
 	}
 
@@ -1393,9 +1857,10 @@ found_rx:
 
 		if (rx->len > BT_MESH_RX_SDU_MAX) {
 			BT_ERR("Too large SDU len");
+			seg_rx_ack_cancel(rx);
 			send_ack(net_rx->sub, net_rx->ctx.recv_dst,
 				 net_rx->ctx.addr, net_rx->ctx.send_ttl,
-				 seq_auth, 0, rx->obo);
+				 seq_auth, 0, rx->obo, NULL);
 			seg_rx_reset(rx, true);
 			return -EMSGSIZE;
 		}
@@ -1418,12 +1883,18 @@ found_rx:
 
 	/* Allocated segment here */
 	err = k_mem_slab_alloc(&segs, &rx->seg[seg_o], K_NO_WAIT);
+	if (err && seg_rx_evict(rx)) {
+		err = k_mem_slab_alloc(&segs, &rx->seg[seg_o], K_NO_WAIT);
+	}
+
 	if (err) {
 		BT_WARN("Unable allocate buffer for Seg %u", seg_o);
 		return -ENOBUFS;
 	}
 
 	memcpy(rx->seg[seg_o], buf->data, buf->len);
+	bt_mesh_net_rx_alloced();
+	bt_mesh_net_rx_copied(buf->len);
 
 	BT_DBG("Received %u/%u", seg_o, seg_n);
 
@@ -1444,8 +1915,7 @@ found_rx:
 	*pdu_type = BT_MESH_FRIEND_PDU_COMPLETE;
 
 	k_delayed_work_cancel(&rx->ack);
-	send_ack(net_rx->sub, net_rx->ctx.recv_dst, net_rx->ctx.addr,
-		 net_rx->ctx.send_ttl, seq_auth, rx->block, rx->obo);
+	seg_rx_ack(rx, net_rx->ctx.send_ttl, rx->block);
 
 	if (net_rx->ctl) {
 		NET_BUF_SIMPLE_DEFINE(sdu, BT_MESH_RX_CTL_MAX);
@@ -1459,8 +1929,8 @@ found_rx:
 		struct net_buf_simple sdu;
 
 		/* Decrypting in place to avoid creating two assembly buffers.
-		 * We'll reassemble the buffer from the segments before each
-		 * decryption attempt.
+		 * The buffer is assembled from the segments before the first
+		 * decryption attempt and again after every failed one.
 		 */
 		net_buf_simple_init(&seg_buf, 0);
 		net_buf_simple_init_with_data(
@@ -1587,6 +2057,10 @@ void bt_mesh_trans_reset(void)
 		seg_tx_reset(&seg_tx[i]);
 	}
 
+	if (IS_ENABLED(CONFIG_BT_MESH_TX_SEG_ADAPTIVE)) {
+		bt_mesh_sar_reset();
+	}
+
 	for (i = 0; i < ARRAY_SIZE(virtual_addrs); i++) {
 		if (virtual_addrs[i].ref) {
 			virtual_addrs[i].ref = 0U;
@@ -32,6 +32,13 @@
 #define TRANS_CTL_OP_FRIEND_SUB_CFM    0x09
 #define TRANS_CTL_OP_HEARTBEAT         0x0a
 
+/* Non-standard extension in RFU bits: the LPN asks in the Friend Request
+ * Criteria for several PDUs per Friend Poll, which the Friend confirms in
+ * the Friend Update Flags.
+ */
+#define BT_MESH_FRIEND_CRIT_BURST      BIT(7)
+#define BT_MESH_FRIEND_FLAG_BURST      BIT(2)
+
 struct bt_mesh_ctl_friend_poll {
 	uint8_t  fsn;
 } __packed;
@@ -213,6 +213,59 @@ int cfb_framebuffer_finalize(const struct device *dev)
 	return api->write(dev, 0, 0, &desc, fb->buf);
 }
 
+static void cfb_invert_area(uint8_t *buf, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		buf[i] = ~buf[i];
+	}
+}
+
+int cfb_framebuffer_finalize_area(const struct device *dev, uint16_t y,
+				  uint16_t height)
+{
+	const struct display_driver_api *api = dev->api;
+	const struct char_framebuffer *fb = &char_fb;
+	struct display_buffer_descriptor desc;
+	bool invert;
+	uint8_t *area;
+	int err;
+
+	if (!fb || !fb->buf) {
+		return -1;
+	}
+
+	if (!(fb->screen_info & SCREEN_INFO_MONO_VTILED)) {
+		return -ENOTSUP;
+	}
+
+	if ((y % fb->ppt) || (height % fb->ppt) || !height ||
+	    (y + height) > fb->y_res) {
+		return -EINVAL;
+	}
+
+	area = fb->buf + (y / fb->ppt) * fb->x_res;
+	desc.buf_size = (height / fb->ppt) * fb->x_res;
+	desc.width = fb->x_res;
+	desc.height = height;
+	desc.pitch = fb->x_res;
+
+	/* Invert only the band and restore it afterwards, so the
+	 * framebuffer keeps its content for later partial updates.
+	 */
+	invert = !(fb->pixel_format & PIXEL_FORMAT_MONO10) != !(fb->inverted);
+	if (invert) {
+		cfb_invert_area(area, desc.buf_size);
+	}
+
+	err = api->write(dev, 0, y, &desc, area);
+
+	if (invert) {
+		cfb_invert_area(area, desc.buf_size);
+	}
+
+	return err;
+}
+
 int cfb_get_display_parameter(const struct device *dev,
 			       enum cfb_display_param param)
 {
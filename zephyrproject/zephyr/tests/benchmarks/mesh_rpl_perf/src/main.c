@@ -0,0 +1,95 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <bluetooth/mesh.h>
+
+#include "mesh.h"
+#include "net.h"
+#include "rpl.h"
+
+#define CHECKS 4096
+
+static struct bt_mesh_net_rx rx = {
+	.net_if = BT_MESH_NET_IF_ADV,
+	.local_match = 1,
+};
+
+static bool rpl_check(uint16_t src, uint32_t seq)
+{
+	rx.ctx.addr = src;
+	rx.seq = seq;
+
+	return bt_mesh_rpl_check(&rx, NULL);
+}
+
+static uint32_t ns_per_check(uint32_t start)
+{
+	uint32_t cycles = k_cycle_get_32() - start;
+
+	return (uint32_t)(k_cyc_to_ns_floor64(cycles) / CHECKS);
+}
+
+/* Time accepted, replayed and unknown sources against a list holding
+ * count sources.
+ */
+static void rpl_check_perf(uint16_t count)
+{
+	uint32_t accepted, replayed, unknown;
+	struct bt_mesh_rpl *match;
+	uint32_t start;
+	int i;
+
+	bt_mesh_rpl_clear();
+
+	for (i = 0; i < count; i++) {
+		zassert_false(rpl_check(i + 1, 1), "Failed adding 0x%04x",
+			      i + 1);
+	}
+
+	start = k_cycle_get_32();
+	for (i = 0; i < CHECKS; i++) {
+		zassert_false(rpl_check((i % count) + 1, 2 + i / count),
+			      "New SEQ rejected");
+	}
+	accepted = ns_per_check(start);
+
+	start = k_cycle_get_32();
+	for (i = 0; i < CHECKS; i++) {
+		zassert_true(rpl_check((i % count) + 1, 1), "Replay accepted");
+	}
+	replayed = ns_per_check(start);
+
+	/* Unknown sources only get a free entry back, or are rejected once
+	 * the list is full.
+	 */
+	start = k_cycle_get_32();
+	for (i = 0; i < CHECKS; i++) {
+		rx.ctx.addr = 0x7000 + i;
+		rx.seq = 1;
+		bt_mesh_rpl_check(&rx, &match);
+	}
+	unknown = ns_per_check(start);
+
+	TC_PRINT("%5u/%u entries: accepted %6u ns replayed %6u ns "
+		 "unknown %6u ns\n", count, CONFIG_BT_MESH_CRPL, accepted,
+		 replayed, unknown);
+}
+
+void test_rpl_check_perf(void)
+{
+	rpl_check_perf(CONFIG_BT_MESH_CRPL / 16);
+	rpl_check_perf(CONFIG_BT_MESH_CRPL / 4);
+	rpl_check_perf(CONFIG_BT_MESH_CRPL / 2);
+	rpl_check_perf(CONFIG_BT_MESH_CRPL * 3 / 4);
+	rpl_check_perf(CONFIG_BT_MESH_CRPL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(mesh_rpl_perf,
+			 ztest_unit_test(test_rpl_check_perf));
+
+	ztest_run_test_suite(mesh_rpl_perf);
+}
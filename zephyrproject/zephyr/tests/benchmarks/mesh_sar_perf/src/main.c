@@ -0,0 +1,379 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <sys/byteorder.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/hci.h>
+#include <bluetooth/mesh.h>
+
+#include "adv.h"
+#include "net.h"
+#include "transport.h"
+#include "sar.h"
+
+/* The segmented messages are sent through the transport layer of the
+ * stack, but bt_mesh_net_send() is wrapped at link time by a test bearer
+ * that loses segments at a given rate and answers for the receiver. The
+ * receiver acks a complete message right away, and an incomplete one when
+ * its ack timer of 150 + 50 * TTL ms plus 100 ms per missing segment, at
+ * least 400 ms, expires. It puts the timed ack off while segments are still
+ * coming in, and doesn't ack the same block again within 150 + 50 * TTL ms.
+ * The losses are pseudo random from a fixed seed, so that the fixed and the
+ * adaptive retransmit timing, which are built as separate test scenarios,
+ * see the same bearer.
+ */
+#define NET_IDX       0x000
+#define LOCAL_ADDR    0x0001
+#define PEER_ADDR     0x0002
+
+#define MESSAGES      20
+#define SEGS          16    /* e.g. a large Composition Data Status */
+#define TTL           3
+#define SEG_AIR_MS    30    /* Air time of a PDU with its repeats */
+#define SEG_SDU       12    /* Upper transport payload of a segment */
+#define CONGESTION    10    /* Extra loss per segment queued, in 1/1000 */
+#define LOSS_MAX      900
+#define SEND_TIMEOUT  K_SECONDS(120)
+
+#define SEGS_ALL      BIT_MASK(SEGS)
+
+#define ACK_DEFER_MS  100
+#define ACK_REPEAT_MS (150 + 50 * TTL)
+
+int __real_bt_mesh_net_send(struct bt_mesh_net_tx *tx, struct net_buf *buf,
+			    const struct bt_mesh_send_cb *cb, void *cb_data);
+
+static const uint8_t net_key[16] = { 0x01 };
+static const uint8_t dev_key[16] = { 0x02 };
+static const uint8_t dev_uuid[16] = { 0xdd, 0xdd };
+
+static struct bt_mesh_model root_models[] = {
+	BT_MESH_MODEL_CFG_SRV,
+};
+
+static struct bt_mesh_elem elements[] = {
+	BT_MESH_ELEM(0, root_models, BT_MESH_MODEL_NONE),
+};
+
+static const struct bt_mesh_comp comp = {
+	.cid = BT_COMP_ID_LF,
+	.elem = elements,
+	.elem_count = ARRAY_SIZE(elements),
+};
+
+static const struct bt_mesh_prov prov = {
+	.uuid = dev_uuid,
+};
+
+static K_FIFO_DEFINE(bearer_queue);
+static K_SEM_DEFINE(msg_sent, 0, 1);
+
+static uint32_t rand_state;
+static uint16_t bearer_loss;   /* Loss of the bearer, in 1/1000 */
+static atomic_t bearer_depth;  /* PDUs waiting on the bearer */
+static uint32_t segs_sent;
+static int send_err;
+
+/* Receiver side of the message being sent */
+static struct {
+	struct k_delayed_work timer;  /* Ack timer */
+	struct k_delayed_work ack;    /* Ack on its way over the bearer */
+	uint16_t seq_zero;
+	uint32_t block;
+	uint32_t seq;
+	uint32_t last;                /* Last new segment */
+	uint32_t ack_block;
+	uint32_t ack_sent;
+	bool started;
+} peer;
+
+static uint32_t sim_rand(void)
+{
+	rand_state = rand_state * 1103515245U + 12345U;
+
+	return (rand_state >> 16) % 1000U;
+}
+
+static int32_t ack_timeout(void)
+{
+	uint8_t missing = SEGS - popcount(peer.block);
+
+	return MAX(150 + TTL * 50U + missing * 100U, 400);
+}
+
+static void peer_ack_send(struct k_work *work)
+{
+	NET_BUF_SIMPLE_DEFINE(buf, BT_MESH_NET_HDR_LEN + 7);
+	struct bt_mesh_net_rx rx = {
+		.ctx = {
+			.net_idx = NET_IDX,
+			.app_idx = BT_MESH_KEY_UNUSED,
+			.addr = PEER_ADDR,
+			.recv_dst = LOCAL_ADDR,
+			.recv_ttl = TTL,
+		},
+		.seq = ++peer.seq,
+		.ctl = 1U,
+		.net_if = BT_MESH_NET_IF_ADV,
+		.local_match = 1U,
+	};
+
+	/* The ack goes over the same bearer as the segments */
+	if (sim_rand() < bearer_loss) {
+		return;
+	}
+
+	rx.sub = bt_mesh_subnet_get(NET_IDX);
+
+	(void)memset(net_buf_simple_add(&buf, BT_MESH_NET_HDR_LEN), 0,
+		     BT_MESH_NET_HDR_LEN);
+	net_buf_simple_add_u8(&buf, TRANS_CTL_OP_ACK);
+	net_buf_simple_add_be16(&buf, peer.seq_zero << 2);
+	net_buf_simple_add_be32(&buf, peer.ack_block);
+
+	bt_mesh_trans_recv(&buf, &rx, -60);
+}
+
+/* A newer block replaces an ack still waiting for the bearer, and the same
+ * block is answered once for a burst of late segments.
+ */
+static void peer_ack(void)
+{
+	uint32_t now = k_uptime_get_32();
+
+	if (peer.block == peer.ack_block &&
+	    (k_delayed_work_remaining_get(&peer.ack) ||
+	     now - peer.ack_sent < ACK_REPEAT_MS)) {
+		return;
+	}
+
+	peer.ack_block = peer.block;
+	peer.ack_sent = now;
+	k_delayed_work_submit(&peer.ack, K_MSEC(SEG_AIR_MS));
+}
+
+static void peer_ack_timer(struct k_work *work)
+{
+	if (k_uptime_get_32() - peer.last < ACK_DEFER_MS) {
+		k_delayed_work_submit(&peer.timer, K_MSEC(ACK_DEFER_MS));
+		return;
+	}
+
+	peer_ack();
+	k_delayed_work_submit(&peer.timer, K_MSEC(ack_timeout()));
+}
+
+static void peer_seg_recv(uint16_t seq_zero, uint8_t seg_o)
+{
+	/* The sender has given up on the previous message */
+	if (!peer.started || peer.seq_zero != seq_zero) {
+		k_delayed_work_cancel(&peer.timer);
+		k_delayed_work_cancel(&peer.ack);
+		peer.seq_zero = seq_zero;
+		peer.block = 0U;
+		peer.ack_block = 0U;
+		peer.started = true;
+	}
+
+	/* Segments of a complete message are answered with its ack, and
+	 * repeated segments of an incomplete one are ignored.
+	 */
+	if (peer.block & BIT(seg_o)) {
+		if (peer.block == SEGS_ALL) {
+			peer_ack();
+		}
+
+		return;
+	}
+
+	peer.last = k_uptime_get_32();
+
+	if (!k_delayed_work_remaining_get(&peer.timer)) {
+		k_delayed_work_submit(&peer.timer, K_MSEC(ack_timeout()));
+	}
+
+	peer.block |= BIT(seg_o);
+
+	if (peer.block == SEGS_ALL) {
+		k_delayed_work_cancel(&peer.timer);
+		peer_ack();
+	}
+}
+
+static void bearer_thread(void *p1, void *p2, void *p3)
+{
+	for (;;) {
+		struct net_buf *buf = net_buf_get(&bearer_queue, K_FOREVER);
+		struct bt_mesh_adv *adv = BT_MESH_ADV(buf);
+		uint32_t loss;
+		uint16_t seq_zero;
+		uint8_t seg_o;
+
+		loss = MIN(bearer_loss +
+			   CONGESTION * (atomic_get(&bearer_depth) - 1),
+			   LOSS_MAX);
+
+		if (adv->cb && adv->cb->start) {
+			adv->cb->start(SEG_AIR_MS, 0, adv->cb_data);
+		}
+
+		k_sleep(K_MSEC(SEG_AIR_MS));
+		atomic_dec(&bearer_depth);
+		segs_sent++;
+
+		/* Lower transport header of an access segment */
+		seq_zero = (sys_get_be16(&buf->data[1]) >> 2) &
+			   TRANS_SEQ_ZERO_MASK;
+		seg_o = (sys_get_be16(&buf->data[2]) >> 5) & 0x1f;
+
+		if (sim_rand() >= loss) {
+			peer_seg_recv(seq_zero, seg_o);
+		}
+
+		adv->busy = 0U;
+
+		if (adv->cb && adv->cb->end) {
+			adv->cb->end(0, adv->cb_data);
+		}
+
+		net_buf_unref(buf);
+	}
+}
+
+K_THREAD_DEFINE(bearer, 1024, bearer_thread, NULL, NULL, NULL,
+		K_PRIO_COOP(7), 0, 0);
+
+int __wrap_bt_mesh_net_send(struct bt_mesh_net_tx *tx, struct net_buf *buf,
+			    const struct bt_mesh_send_cb *cb, void *cb_data)
+{
+	if (tx->ctx->addr != PEER_ADDR) {
+		return __real_bt_mesh_net_send(tx, buf, cb, cb_data);
+	}
+
+	/* The network header isn't needed by the test bearer, but the
+	 * sequence number advances as it would for the real one.
+	 */
+	(void)bt_mesh_next_seq();
+
+	BT_MESH_ADV(buf)->cb = cb;
+	BT_MESH_ADV(buf)->cb_data = cb_data;
+	BT_MESH_ADV(buf)->busy = 1U;
+
+	atomic_inc(&bearer_depth);
+	net_buf_put(&bearer_queue, buf);
+
+	return 0;
+}
+
+static void msg_end(int err, void *cb_data)
+{
+	send_err = err;
+	k_sem_give(&msg_sent);
+}
+
+static const struct bt_mesh_send_cb msg_cb = {
+	.end = msg_end,
+};
+
+/* Returns the time it took to get a message through */
+static uint32_t transfer(void)
+{
+	NET_BUF_SIMPLE_DEFINE(msg, SEGS * SEG_SDU);
+	struct bt_mesh_msg_ctx ctx = {
+		.net_idx = NET_IDX,
+		.app_idx = BT_MESH_KEY_DEV_LOCAL,
+		.addr = PEER_ADDR,
+		.send_ttl = TTL,
+	};
+	struct bt_mesh_net_tx tx = {
+		.sub = bt_mesh_subnet_get(NET_IDX),
+		.ctx = &ctx,
+		.src = LOCAL_ADDR,
+	};
+	uint32_t start;
+	int err;
+
+	(void)memset(net_buf_simple_add(&msg, SEGS * SEG_SDU - 4), 0xaa,
+		     SEGS * SEG_SDU - 4);
+
+	start = k_uptime_get_32();
+
+	err = bt_mesh_trans_send(&tx, &msg, &msg_cb, NULL);
+	zassert_equal(err, 0, "Sending failed (err %d)", err);
+
+	err = k_sem_take(&msg_sent, SEND_TIMEOUT);
+	zassert_equal(err, 0, "Send never completed");
+
+	return k_uptime_get_32() - start;
+}
+
+static void sar_perf(uint16_t loss, uint32_t *ms, uint32_t *segs,
+		     uint32_t *failed)
+{
+	uint32_t total = 0U;
+	int i;
+
+	rand_state = loss;
+	bearer_loss = loss;
+	segs_sent = 0U;
+	*failed = 0U;
+
+	/* Every loss rate starts from scratch */
+	if (IS_ENABLED(CONFIG_BT_MESH_TX_SEG_ADAPTIVE)) {
+		bt_mesh_sar_reset();
+	}
+
+	for (i = 0; i < MESSAGES; i++) {
+		total += transfer();
+
+		if (send_err) {
+			(*failed)++;
+		}
+	}
+
+	/* Let the acks of the last message settle */
+	k_sleep(K_SECONDS(2));
+
+	*ms = total / MESSAGES;
+	*segs = segs_sent / MESSAGES;
+}
+
+void test_sar_perf(void)
+{
+	static const uint16_t losses[] = { 0, 50, 100, 200, 300 };
+	uint32_t ms, segs, failed;
+	int i;
+
+	TC_PRINT("%s timing, %u segments, TTL %u, %u ms per segment\n",
+		 IS_ENABLED(CONFIG_BT_MESH_TX_SEG_ADAPTIVE) ? "adaptive" :
+		 "fixed", SEGS, TTL, SEG_AIR_MS);
+
+	for (i = 0; i < ARRAY_SIZE(losses); i++) {
+		sar_perf(losses[i], &ms, &segs, &failed);
+
+		TC_PRINT("loss %2u%%: %5u ms %3u segs %2u failed (%u B/s)\n",
+			 losses[i] / 10, ms, segs, failed,
+			 (uint32_t)(SEGS * SEG_SDU * 1000U / MAX(ms, 1)));
+	}
+}
+
+void test_main(void)
+{
+	int err;
+
+	k_delayed_work_init(&peer.timer, peer_ack_timer);
+	k_delayed_work_init(&peer.ack, peer_ack_send);
+
+	err = bt_mesh_init(&prov, &comp);
+	zassert_equal(err, 0, "Mesh init failed (err %d)", err);
+
+	err = bt_mesh_provision(net_key, NET_IDX, 0, 0, LOCAL_ADDR, dev_key);
+	zassert_equal(err, 0, "Provisioning failed (err %d)", err);
+
+	ztest_test_suite(mesh_sar_perf,
+			 ztest_unit_test(test_sar_perf));
+
+	ztest_run_test_suite(mesh_sar_perf);
+}
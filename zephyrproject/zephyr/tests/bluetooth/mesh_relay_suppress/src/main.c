@@ -0,0 +1,170 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ztest.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/hci.h>
+#include <bluetooth/mesh.h>
+
+#include "adv.h"
+#include "mesh.h"
+#include "net.h"
+
+/* Network PDUs from a remote node to another one are fed to the network
+ * layer as if heard on the advertising bearer, and bt_mesh_adv_send() is
+ * wrapped at link time to count the relayed copies.
+ */
+#define NET_IDX      0x000
+#define LOCAL_ADDR   0x0001
+#define REMOTE_SRC   0x0002
+#define REMOTE_DST   0x0003
+#define TTL          5
+#define RSSI         -70
+
+void __real_bt_mesh_adv_send(struct net_buf *buf,
+			     const struct bt_mesh_send_cb *cb, void *cb_data);
+
+static const uint8_t net_key[16] = { 0x01 };
+static const uint8_t dev_key[16] = { 0x02 };
+static const uint8_t dev_uuid[16] = { 0xdd, 0xdd };
+
+static struct bt_mesh_model root_models[] = {
+	BT_MESH_MODEL_CFG_SRV,
+};
+
+static struct bt_mesh_elem elements[] = {
+	BT_MESH_ELEM(0, root_models, BT_MESH_MODEL_NONE),
+};
+
+static const struct bt_mesh_comp comp = {
+	.cid = BT_COMP_ID_LF,
+	.elem = elements,
+	.elem_count = ARRAY_SIZE(elements),
+};
+
+static const struct bt_mesh_prov prov = {
+	.uuid = dev_uuid,
+};
+
+static atomic_t relayed;
+
+void __wrap_bt_mesh_adv_send(struct net_buf *buf,
+			     const struct bt_mesh_send_cb *cb, void *cb_data)
+{
+	if (BT_MESH_ADV(buf)->tag == BT_MESH_RELAY_ADV) {
+		atomic_inc(&relayed);
+		return;
+	}
+
+	__real_bt_mesh_adv_send(buf, cb, cb_data);
+}
+
+/* Receive an access PDU from REMOTE_SRC with the given sequence number */
+static void pdu_recv(uint32_t seq, uint8_t ttl)
+{
+	NET_BUF_SIMPLE_DEFINE(buf, 29);
+	struct bt_mesh_msg_ctx ctx = {
+		.net_idx = NET_IDX,
+		.app_idx = BT_MESH_KEY_DEV_REMOTE,
+		.addr = REMOTE_DST,
+		.send_ttl = ttl,
+	};
+	struct bt_mesh_net_tx tx = {
+		.sub = bt_mesh_subnet_get(NET_IDX),
+		.ctx = &ctx,
+		.src = REMOTE_SRC,
+	};
+	uint32_t local_seq = bt_mesh.seq;
+	int err;
+
+	net_buf_simple_reserve(&buf, BT_MESH_NET_HDR_LEN);
+	net_buf_simple_add_u8(&buf, 0x00);
+	net_buf_simple_add_mem(&buf, "payload", 7);
+
+	/* The header takes the next sequence number of the local node */
+	bt_mesh.seq = seq;
+	err = bt_mesh_net_encode(&tx, &buf, false);
+	bt_mesh.seq = local_seq;
+	zassert_equal(err, 0, "Encoding failed (err %d)", err);
+
+	bt_mesh_net_recv(&buf, RSSI, BT_MESH_NET_IF_ADV);
+}
+
+static void test_disabled(void)
+{
+	int err;
+
+	err = bt_mesh_relay_suppress_set(0, 60);
+	zassert_equal(err, 0, "Disabling failed (err %d)", err);
+
+	atomic_clear(&relayed);
+	pdu_recv(0x100, TTL);
+
+	zassert_equal(atomic_get(&relayed), 1, "Not relayed right away");
+}
+
+static void test_backoff(void)
+{
+	int err;
+
+	err = bt_mesh_relay_suppress_set(2, 50);
+	zassert_equal(err, 0, "Enabling failed (err %d)", err);
+
+	atomic_clear(&relayed);
+	pdu_recv(0x200, TTL);
+
+	zassert_equal(atomic_get(&relayed), 0, "Relayed without backoff");
+
+	k_sleep(K_MSEC(100));
+	zassert_equal(atomic_get(&relayed), 1, "Not relayed after backoff");
+}
+
+static void test_suppressed(void)
+{
+	int err;
+
+	err = bt_mesh_relay_suppress_set(1, 200);
+	zassert_equal(err, 0, "Enabling failed (err %d)", err);
+
+	atomic_clear(&relayed);
+	pdu_recv(0x300, TTL);
+
+	/* Another relay at the same hop sends the same message */
+	pdu_recv(0x300, TTL - 1);
+
+	k_sleep(K_MSEC(300));
+	zassert_equal(atomic_get(&relayed), 0, "Relayed despite a copy");
+
+	/* Toggled off again, messages go out right away */
+	err = bt_mesh_relay_suppress_set(0, 200);
+	zassert_equal(err, 0, "Disabling failed (err %d)", err);
+
+	pdu_recv(0x400, TTL);
+	zassert_equal(atomic_get(&relayed), 1, "Not relayed right away");
+}
+
+static void test_invalid(void)
+{
+	zassert_equal(bt_mesh_relay_suppress_set(2, 1001), -EINVAL,
+		      "Too long backoff accepted");
+}
+
+void test_main(void)
+{
+	int err;
+
+	err = bt_mesh_init(&prov, &comp);
+	zassert_equal(err, 0, "Mesh init failed (err %d)", err);
+
+	err = bt_mesh_provision(net_key, NET_IDX, 0, 0, LOCAL_ADDR, dev_key);
+	zassert_equal(err, 0, "Provisioning failed (err %d)", err);
+
+	ztest_test_suite(mesh_relay_suppress,
+			 ztest_unit_test(test_disabled),
+			 ztest_unit_test(test_backoff),
+			 ztest_unit_test(test_suppressed),
+			 ztest_unit_test(test_invalid));
+
+	ztest_run_test_suite(mesh_relay_suppress);
+}